@@ -0,0 +1,535 @@
+#include <bench.h>
+#include <mm/paging.h>
+#include <mm/vmm.h>
+#include <mm/vmalloc.h>
+#include <mm/zeropool.h>
+#include <proc/task.h>
+#include <proc/sched.h>
+#include <proc/timer.h>
+#include <proc/wait.h>
+#include <proc/smp.h>
+#include <string.h>
+#include <vga.h>
+
+// TLB 基准测试参数
+#define BENCH_TLB_PAGES 64
+#define BENCH_TLB_ROUNDS 1000
+
+// 批量取消映射基准测试参数（4MB，位于用户空间顶端）
+#define BENCH_UNMAP_BASE 0xBF000000
+#define BENCH_UNMAP_PAGES 1024
+
+// 追加写基准测试参数（以 64 字节为单位追加到 64KB）
+#define BENCH_APPEND_CHUNK 64
+#define BENCH_APPEND_COUNT 1024
+
+// 调度器基准测试参数（进程均匀分布在所有优先级上）
+#define BENCH_SCHED_MAX_TASKS 512
+#define BENCH_SCHED_ROUNDS 4096
+
+// 时间轮基准测试参数（睡眠进程的到期时间均匀分布在 60 秒内）
+#define BENCH_TIMER_COUNT 10000
+#define BENCH_TIMER_SPAN (60 * TIMER_HZ)
+
+// 多处理器基准测试参数（总工作量固定，平均分给 1 到 N 个进程）
+#define BENCH_SMP_WORK (1 << 26)
+
+// 基准测试表
+static bench_t benches[] = {
+    {"tlb", bench_tlb_switch, "CR3 reload + kernel page walk, with and without global pages"},
+    {"unmap", bench_unmap_range, "Unmap 4MB page by page vs. with unmap_range"},
+    {"fault", bench_page_fault, "Anonymous page-fault latency with the zero pool on and off"},
+    {"append", bench_append, "Small appends: exact-size copy vs. krealloc with a capacity hint"},
+    {"sched", bench_sched, "Pick-next + requeue with 16-512 ready tasks: bitmap/FIFO vs. scan/LIFO"},
+    {"timer", bench_timer, "10k concurrent sleepers: timer wheel vs. per-tick deadline scan"},
+    {"smp", bench_smp, "Fixed CPU-bound work split over 1..N tasks: speedup across per-CPU run queues"},
+    {NULL, NULL, NULL}
+};
+
+// 防止编译器优化掉访存
+static volatile uint32_t bench_sink = 0;
+
+// 读取时间戳计数器低 32 位
+uint32_t bench_cycles(void)
+{
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return lo;
+}
+
+// 按名称运行基准测试
+int bench_run(const char* name)
+{
+    for (int i = 0; benches[i].name != NULL; i++) {
+        if (!name) {
+            kprintf("  %s - %s\n", benches[i].name, benches[i].description);
+        } else if (strcmp(name, benches[i].name) == 0) {
+            benches[i].func();
+            return 0;
+        }
+    }
+    
+    return name ? -1 : 0;
+}
+
+// 模拟一次上下文切换：重载 CR3 后访问一组内核堆页
+static uint32_t tlb_switch_rounds(volatile uint8_t* buf)
+{
+    uint32_t start = bench_cycles();
+    
+    for (int round = 0; round < BENCH_TLB_ROUNDS; round++) {
+        tlb_flush_user();
+        for (int i = 0; i < BENCH_TLB_PAGES; i++) {
+            bench_sink += buf[i * PAGE_SIZE];
+        }
+    }
+    
+    return (bench_cycles() - start) / BENCH_TLB_ROUNDS;
+}
+
+// 上下文切换 TLB 开销：比较开启和关闭全局页时重载 CR3 的代价
+void bench_tlb_switch(void)
+{
+    uint8_t* buf = (uint8_t*)vmalloc(BENCH_TLB_PAGES * PAGE_SIZE);
+    if (!buf) {
+        kprintf("[BENCH] tlb: failed to allocate buffer\n");
+        return;
+    }
+    memset(buf, 0, BENCH_TLB_PAGES * PAGE_SIZE);
+    
+    // 关闭全局页：重载 CR3 会丢弃内核的所有 TLB 项（优化前的行为）
+    paging_set_global_pages(false);
+    uint32_t without_global = tlb_switch_rounds(buf);
+    
+    // 开启全局页：内核 TLB 项在重载 CR3 后仍然有效
+    paging_set_global_pages(true);
+    uint32_t with_global = tlb_switch_rounds(buf);
+    
+    kprintf("[BENCH] tlb: %d kernel pages touched per switch, %d rounds\n",
+            BENCH_TLB_PAGES, BENCH_TLB_ROUNDS);
+    kprintf("  without global pages: %d cycles/switch\n", without_global);
+    kprintf("  with global pages:    %d cycles/switch\n", with_global);
+    if (without_global > with_global) {
+        kprintf("  TLB refill cost:      %d cycles/page\n",
+                (without_global - with_global) / BENCH_TLB_PAGES);
+    }
+    
+    vfree(buf);
+}
+
+// 在基准测试区域逐页映射新分配的帧，返回成功映射的页数
+static uint32_t populate_unmap_area(void)
+{
+    for (uint32_t i = 0; i < BENCH_UNMAP_PAGES; i++) {
+        uint32_t frame = alloc_frame_high();
+        if (frame == 0) {
+            unmap_range((void*)BENCH_UNMAP_BASE, i * PAGE_SIZE);
+            return i;
+        }
+        map_page((void*)(BENCH_UNMAP_BASE + i * PAGE_SIZE), frame * PAGE_SIZE, PAGE_PRESENT | PAGE_WRITABLE);
+    }
+    return BENCH_UNMAP_PAGES;
+}
+
+// 批量取消映射：比较逐页 unmap_page 和 unmap_range 的开销
+void bench_unmap_range(void)
+{
+    if (populate_unmap_area() != BENCH_UNMAP_PAGES) {
+        kprintf("[BENCH] unmap: not enough free frames\n");
+        return;
+    }
+    
+    uint32_t start = bench_cycles();
+    for (uint32_t i = 0; i < BENCH_UNMAP_PAGES; i++) {
+        unmap_page((void*)(BENCH_UNMAP_BASE + i * PAGE_SIZE));
+    }
+    uint32_t per_page = bench_cycles() - start;
+    
+    if (populate_unmap_area() != BENCH_UNMAP_PAGES) {
+        kprintf("[BENCH] unmap: not enough free frames\n");
+        return;
+    }
+    
+    start = bench_cycles();
+    unmap_range((void*)BENCH_UNMAP_BASE, BENCH_UNMAP_PAGES * PAGE_SIZE);
+    uint32_t batched = bench_cycles() - start;
+    
+    kprintf("[BENCH] unmap: %d pages\n", BENCH_UNMAP_PAGES);
+    kprintf("  unmap_page loop: %d cycles (%d/page)\n", per_page, per_page / BENCH_UNMAP_PAGES);
+    kprintf("  unmap_range:     %d cycles (%d/page)\n", batched, batched / BENCH_UNMAP_PAGES);
+    if (batched > 0) {
+        kprintf("  speedup:         %dx\n", per_page / batched);
+    }
+}
+
+// 在新的匿名区域中逐页触发缺页，返回每次缺页的平均周期数
+static uint32_t fault_round(vm_space_t* space)
+{
+    uint32_t size = ZERO_POOL_TARGET * PAGE_SIZE;
+    uint32_t base = vm_area_find_free(space, size);
+    if (!base || vm_area_map(space, base, base + size, VM_READ | VM_WRITE) < 0) {
+        return 0;
+    }
+    
+    uint32_t start = bench_cycles();
+    for (uint32_t i = 0; i < ZERO_POOL_TARGET; i++) {
+        *(volatile uint32_t*)(base + i * PAGE_SIZE) = i;
+    }
+    uint32_t cycles = bench_cycles() - start;
+    
+    vm_area_unmap(space, base, base + size);
+    return cycles / ZERO_POOL_TARGET;
+}
+
+// 缺页延迟：比较预清零池开启和关闭时匿名页首次访问的开销
+void bench_page_fault(void)
+{
+    vm_space_t* space = vm_space_current();
+    bool was_enabled = zero_pool_enabled();
+    
+    // 开启预清零池并填满（模拟空闲进程已经完成清零）
+    zero_pool_set_enabled(true);
+    zero_pool_refill(ZERO_POOL_TARGET * BUDDY_ZONE_COUNT);
+    uint32_t with_pool = fault_round(space);
+    
+    // 关闭预清零池：每次缺页都同步清零
+    zero_pool_set_enabled(false);
+    uint32_t without_pool = fault_round(space);
+    
+    zero_pool_set_enabled(was_enabled);
+    
+    if (with_pool == 0 || without_pool == 0) {
+        kprintf("[BENCH] fault: failed to map test area\n");
+        return;
+    }
+    
+    kprintf("[BENCH] fault: %d anonymous pages\n", ZERO_POOL_TARGET);
+    kprintf("  zero pool off: %d cycles/fault\n", without_pool);
+    kprintf("  zero pool on:  %d cycles/fault\n", with_pool);
+}
+
+// 按精确大小重新分配并复制（优化前 tmpfs_write 的做法），返回总周期数，失败返回 0
+static uint32_t append_exact(const uint8_t* chunk)
+{
+    uint8_t* data = NULL;
+    size_t size = 0;
+    
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_APPEND_COUNT; i++) {
+        uint8_t* new_data = (uint8_t*)kmalloc(size + BENCH_APPEND_CHUNK);
+        if (!new_data) {
+            kfree(data);
+            return 0;
+        }
+        if (data) {
+            memcpy(new_data, data, size);
+            kfree(data);
+        }
+        data = new_data;
+        memcpy(data + size, chunk, BENCH_APPEND_CHUNK);
+        size += BENCH_APPEND_CHUNK;
+    }
+    uint32_t cycles = bench_cycles() - start;
+    
+    kfree(data);
+    return cycles;
+}
+
+// 按容量提示增长并使用 krealloc，返回总周期数，失败返回 0
+static uint32_t append_krealloc(const uint8_t* chunk)
+{
+    uint8_t* data = NULL;
+    size_t size = 0;
+    
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_APPEND_COUNT; i++) {
+        size_t capacity = ksize(data);
+        if (size + BENCH_APPEND_CHUNK > capacity) {
+            uint8_t* new_data = (uint8_t*)krealloc(data, kcapacity_hint(capacity, size + BENCH_APPEND_CHUNK));
+            if (!new_data) {
+                kfree(data);
+                return 0;
+            }
+            data = new_data;
+        }
+        memcpy(data + size, chunk, BENCH_APPEND_CHUNK);
+        size += BENCH_APPEND_CHUNK;
+    }
+    uint32_t cycles = bench_cycles() - start;
+    
+    kfree(data);
+    return cycles;
+}
+
+// 追加写：比较按精确大小复制和 krealloc + 容量提示的开销
+void bench_append(void)
+{
+    uint8_t chunk[BENCH_APPEND_CHUNK];
+    memset(chunk, 0xA5, sizeof(chunk));
+    
+    kheap_stats_t before, after;
+    uint32_t exact = append_exact(chunk);
+    get_kheap_stats(&before);
+    uint32_t grown = append_krealloc(chunk);
+    get_kheap_stats(&after);
+    
+    if (exact == 0 || grown == 0) {
+        kprintf("[BENCH] append: out of memory\n");
+        return;
+    }
+    
+    kprintf("[BENCH] append: %d x %d bytes\n", BENCH_APPEND_COUNT, BENCH_APPEND_CHUNK);
+    kprintf("  exact-size copy:   %d cycles/append\n", exact / BENCH_APPEND_COUNT);
+    kprintf("  krealloc + hint:   %d cycles/append (%d in place, %d moved)\n",
+            grown / BENCH_APPEND_COUNT, after.realloc_inplace - before.realloc_inplace,
+            after.realloc_moved - before.realloc_moved);
+}
+
+// 最高优先级进程之间被选中次数的最大差值（衡量同优先级的公平性）
+static uint32_t sched_spread(task_t* tasks, uint32_t count)
+{
+    uint32_t min = 0xFFFFFFFF, max = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (tasks[i].priority == MAX_PRIORITY - 1) {
+            min = MIN(min, tasks[i].total_runtime);
+            max = MAX(max, tasks[i].total_runtime);
+        }
+    }
+    return max - min;
+}
+
+// 位图 + FIFO 就绪队列：取出最高优先级进程并放回队尾，返回每轮的平均周期数
+static uint32_t sched_round_bitmap(task_t* tasks, uint32_t count, uint32_t* spread)
+{
+    runqueue_t rq;
+    rq_init(&rq);
+    for (uint32_t i = 0; i < count; i++) {
+        tasks[i].total_runtime = 0;
+        rq_enqueue(&rq, &tasks[i], 0);
+    }
+    
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_SCHED_ROUNDS; i++) {
+        task_t* task = rq_pick_next(&rq);
+        task->total_runtime++;
+        rq_enqueue(&rq, task, 0);
+    }
+    uint32_t cycles = bench_cycles() - start;
+    
+    *spread = sched_spread(tasks, count);
+    return cycles / BENCH_SCHED_ROUNDS;
+}
+
+// 原调度器的做法：逐级扫描 16 个优先级，进程压回链表头部（后进先出）
+static uint32_t sched_round_legacy(task_t* tasks, uint32_t count, uint32_t* spread)
+{
+    task_t* queues[MAX_PRIORITY] = {0};
+    for (uint32_t i = 0; i < count; i++) {
+        tasks[i].total_runtime = 0;
+        tasks[i].sibling_next = queues[tasks[i].priority];
+        queues[tasks[i].priority] = &tasks[i];
+    }
+    
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_SCHED_ROUNDS; i++) {
+        task_t* task = NULL;
+        for (int prio = MAX_PRIORITY - 1; prio >= 0; prio--) {
+            if (queues[prio]) {
+                task = queues[prio];
+                queues[prio] = task->sibling_next;
+                break;
+            }
+        }
+        task->total_runtime++;
+        task->sibling_next = queues[task->priority];
+        queues[task->priority] = task;
+    }
+    uint32_t cycles = bench_cycles() - start;
+    
+    *spread = sched_spread(tasks, count);
+    return cycles / BENCH_SCHED_ROUNDS;
+}
+
+// 调度器：就绪进程数从 16 增加到 512 时选取下一个进程的开销和公平性
+void bench_sched(void)
+{
+    // 使用不参与调度的进程控制块副本，只测量就绪队列操作
+    task_t* tasks = (task_t*)vmalloc(BENCH_SCHED_MAX_TASKS * sizeof(task_t));
+    if (!tasks) {
+        kprintf("[BENCH] sched: out of memory\n");
+        return;
+    }
+    memset(tasks, 0, BENCH_SCHED_MAX_TASKS * sizeof(task_t));
+    for (uint32_t i = 0; i < BENCH_SCHED_MAX_TASKS; i++) {
+        tasks[i].pid = i;
+        tasks[i].priority = i % MAX_PRIORITY;
+    }
+    
+    kprintf("[BENCH] sched: %d pick-next + requeue rounds, tasks spread over %d priorities\n",
+            BENCH_SCHED_ROUNDS, MAX_PRIORITY);
+    kprintf("  tasks  bitmap+FIFO cycles (spread)  scan+LIFO cycles (spread)\n");
+    for (uint32_t count = 16; count <= BENCH_SCHED_MAX_TASKS; count *= 2) {
+        uint32_t bitmap_spread, legacy_spread;
+        uint32_t bitmap = sched_round_bitmap(tasks, count, &bitmap_spread);
+        uint32_t legacy = sched_round_legacy(tasks, count, &legacy_spread);
+        kprintf("  %d\t %d (%d)\t\t\t %d (%d)\n", count, bitmap, bitmap_spread, legacy, legacy_spread);
+    }
+    
+    vfree(tasks);
+}
+
+// 到期回调次数
+static uint32_t bench_timer_fired = 0;
+
+static void bench_timer_func(ktimer_t* timer)
+{
+    UNUSED(timer);
+    bench_timer_fired++;
+}
+
+// 时间轮：1 万个睡眠定时器的插入、取消和逐滴答推进的开销，与每个滴答扫描所有睡眠进程比较
+void bench_timer(void)
+{
+    ktimer_t* timers = (ktimer_t*)vmalloc(BENCH_TIMER_COUNT * sizeof(ktimer_t));
+    timer_wheel_t* wheel = (timer_wheel_t*)vmalloc(sizeof(timer_wheel_t));
+    if (!timers || !wheel) {
+        kprintf("[BENCH] timer: out of memory\n");
+        vfree(timers);
+        vfree(wheel);
+        return;
+    }
+    
+    // 使用不由时钟中断推进的私有时间轮，到期时间用线性同余序列打散
+    uint32_t seed = 12345;
+    timer_wheel_init(wheel, 1);
+    for (int i = 0; i < BENCH_TIMER_COUNT; i++) {
+        seed = seed * 1103515245 + 12345;
+        timer_setup(&timers[i], bench_timer_func, NULL);
+        timers[i].expires = 1 + (seed >> 8) % BENCH_TIMER_SPAN;
+    }
+    
+    kprintf("[BENCH] timer: %d sleepers expiring within %d ticks\n", BENCH_TIMER_COUNT, BENCH_TIMER_SPAN);
+    
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_TIMER_COUNT; i++) {
+        timer_wheel_add(wheel, &timers[i]);
+    }
+    uint32_t insert = bench_cycles() - start;
+    
+    // 取消一半再重新挂入（模拟提前被唤醒的睡眠进程）
+    start = bench_cycles();
+    for (int i = 0; i < BENCH_TIMER_COUNT; i += 2) {
+        timer_wheel_cancel(wheel, &timers[i]);
+    }
+    uint32_t cancel = bench_cycles() - start;
+    for (int i = 0; i < BENCH_TIMER_COUNT; i += 2) {
+        timer_wheel_add(wheel, &timers[i]);
+    }
+    
+    kprintf("  insert: %d cycles/timer, cancel: %d cycles/timer\n",
+            insert / BENCH_TIMER_COUNT, cancel / (BENCH_TIMER_COUNT / 2));
+    
+    // 逐滴答推进时间轮（包括级联）
+    uint32_t wheel_total = 0, wheel_max = 0;
+    bench_timer_fired = 0;
+    for (uint32_t tick = 1; tick <= BENCH_TIMER_SPAN; tick++) {
+        start = bench_cycles();
+        timer_wheel_advance(wheel, tick);
+        uint32_t cycles = bench_cycles() - start;
+        wheel_total += cycles;
+        wheel_max = MAX(wheel_max, cycles);
+    }
+    kprintf("  wheel: %d cycles/tick avg, %d max, %d fired, %d left\n",
+            wheel_total / BENCH_TIMER_SPAN, wheel_max, bench_timer_fired, wheel->pending);
+    
+    // 原 sys_sleep 的做法：每个滴答检查每个睡眠进程的截止时间
+    uint32_t scan_total = 0, scan_max = 0, scan_fired = 0;
+    for (uint32_t tick = 1; tick <= BENCH_TIMER_SPAN; tick++) {
+        start = bench_cycles();
+        for (int i = 0; i < BENCH_TIMER_COUNT; i++) {
+            if (timers[i].expires == tick) {
+                scan_fired++;
+            }
+        }
+        uint32_t cycles = bench_cycles() - start;
+        scan_total += cycles;
+        scan_max = MAX(scan_max, cycles);
+    }
+    kprintf("  scan:  %d cycles/tick avg, %d max, %d fired\n",
+            scan_total / BENCH_TIMER_SPAN, scan_max, scan_fired);
+    
+    vfree(wheel);
+    vfree(timers);
+}
+
+// 每个工作进程的迭代次数
+static volatile uint32_t bench_smp_iters = 0;
+
+// 工作进程：纯计算，不访问共享数据，返回后退出
+static void bench_smp_worker(void)
+{
+    uint32_t x = 1;
+    for (uint32_t i = 0; i < bench_smp_iters; i++) {
+        x = x * 1664525 + 1013904223;
+    }
+    bench_sink += x;
+}
+
+// 运行 count 个工作进程并等待它们全部退出，返回经过的时钟滴答数
+static uint32_t smp_round(uint32_t count)
+{
+    uint32_t pids[MAX_CPUS];
+    bench_smp_iters = BENCH_SMP_WORK / count;
+    
+    uint32_t start = get_system_ticks();
+    uint32_t created = 0;
+    for (; created < count; created++) {
+        task_t* task = create_task(bench_smp_worker, "smp-bench", 1);
+        if (!task) {
+            break;
+        }
+        pids[created] = task->pid;
+    }
+    
+    // 逐个等待工作进程变为僵尸并回收
+    task_t* self = current_task;
+    for (uint32_t i = 0; i < created; i++) {
+        task_t* child;
+        wait_event(self->child_exit, (child = sched_find_child(self, pids[i], true)) != NULL);
+        sched_reap(child);
+    }
+    
+    return created == count ? get_system_ticks() - start : 0;
+}
+
+// 多处理器：固定的计算量分给越来越多的进程，各处理器的就绪队列独立调度时的加速比
+void bench_smp(void)
+{
+    uint32_t cpus = 0;
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (smp_cpu_online(cpu)) {
+            cpus++;
+        }
+    }
+    
+    kprintf("[BENCH] smp: %d iterations split over 1..%d tasks, %d CPU(s) online\n",
+            BENCH_SMP_WORK, cpus, cpus);
+    kprintf("  tasks  ticks  speedup  efficiency\n");
+    
+    uint32_t base = 0;
+    for (uint32_t count = 1; count <= cpus; count++) {
+        uint32_t ticks = smp_round(count);
+        if (ticks == 0) {
+            kprintf("[BENCH] smp: failed to create %d tasks\n", count);
+            return;
+        }
+        if (count == 1) {
+            base = ticks;
+        }
+        
+        // 加速比保留两位小数
+        uint32_t speedup = base * 100 / ticks;
+        kprintf("  %d\t %d\t %d.%d%d\t  %d%%\n", count, ticks,
+                speedup / 100, speedup / 10 % 10, speedup % 10, speedup / count);
+    }
+}
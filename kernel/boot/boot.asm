@@ -8,9 +8,11 @@ multiboot_header:
 
 section .text
 global _start
-extern _kernel_main
+extern kernel_main
 
 _start:
+    ; eax 中是引导程序魔数，下面设置 CR0 和段寄存器会覆盖它，先保存到 esi
+    mov esi, eax
     cli
     lgdt [gdt_descriptor]
     
@@ -31,9 +33,9 @@ init_pm:
     mov esp, stack_top
     
     push ebx
-    push eax
+    push esi
     
-    call _kernel_main
+    call kernel_main
     
     cli
 .halt:
@@ -5,3 +5,24 @@ idt_flush:
     mov eax, [esp + 4]
     lidt [eax]
     ret
+
+global page_fault_handler_wrapper
+extern page_fault_handler
+
+; 缺页异常（向量 14）处理包装函数，CPU 已在栈上压入错误码
+page_fault_handler_wrapper:
+    ; 保存所有通用寄存器
+    pusha
+    
+    ; 调用C处理函数 page_fault_handler(error_code, eip)
+    push dword [esp + 36]    ; 出错指令的 eip
+    push dword [esp + 36]    ; 错误码（上一条 push 后偏移不变）
+    call page_fault_handler
+    add esp, 8
+    
+    ; 恢复所有通用寄存器
+    popa
+    
+    ; 弹出错误码后中断返回
+    add esp, 4
+    iret
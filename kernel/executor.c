@@ -124,19 +124,13 @@ void execute_ai_action(const char* json_action) {
                     return;
                 }
                 
-                // 遍历就绪队列查找目标进程
-                extern task_t* ready_queue[];
-                for (int i = 0; i < MAX_PRIORITY; i++) {
-                    task_t* t = ready_queue[i];
-                    while (t) {
-                        if (t->pid == action.pid) {
-                            // 设置进程状态为僵尸，等待调度器清理
-                            t->state = TASK_ZOMBIE;
-                            kprintf("[AI_EXECUTOR] Terminated process %d\n", action.pid);
-                            return;
-                        }
-                        t = t->sibling_next;
-                    }
+                // 查找目标进程：标记终止并唤醒，由它摘除自己的等待项和定时器后退出
+                task_t* t = find_task(action.pid);
+                bool killed = sched_kill(t);
+                task_put(t);
+                if (killed) {
+                    kprintf("[AI_EXECUTOR] Terminated process %d\n", action.pid);
+                    return;
                 }
                 
                 kprintf("[AI_EXECUTOR] Process %d not found\n", action.pid);
@@ -156,19 +150,16 @@ void execute_ai_action(const char* json_action) {
             
             if (c == 'y' || c == 'Y') {
                 // 查找并暂停进程
-                extern task_t* ready_queue[];
-                for (int i = 0; i < MAX_PRIORITY; i++) {
-                    task_t* t = ready_queue[i];
-                    while (t) {
-                        if (t->pid == action.pid) {
-                            // 将进程状态改为阻塞
-                            t->state = TASK_BLOCKED;
-                            kprintf("[AI_EXECUTOR] Paused process %d\n", action.pid);
-                            return;
-                        }
-                        t = t->sibling_next;
-                    }
+                task_t* t = find_task(action.pid);
+                if (t && t->state == TASK_READY) {
+                    // 移出就绪队列并将进程状态改为阻塞
+                    sched_dequeue(t);
+                    t->state = TASK_BLOCKED;
+                    task_put(t);
+                    kprintf("[AI_EXECUTOR] Paused process %d\n", action.pid);
+                    return;
                 }
+                task_put(t);
                 
                 kprintf("[AI_EXECUTOR] Process %d not found\n", action.pid);
             } else {
@@ -187,18 +178,13 @@ void execute_ai_action(const char* json_action) {
             
             if (c == 'y' || c == 'Y') {
                 // 查找并恢复进程
-                extern task_t* ready_queue[];
-                for (int i = 0; i < MAX_PRIORITY; i++) {
-                    task_t* t = ready_queue[i];
-                    while (t) {
-                        if (t->pid == action.pid) {
-                            // 将进程状态改为就绪
-                            t->state = TASK_READY;
-                            kprintf("[AI_EXECUTOR] Resumed process %d\n", action.pid);
-                            return;
-                        }
-                        t = t->sibling_next;
-                    }
+                task_t* t = find_task(action.pid);
+                bool resumed = t && sched_wakeup(t);
+                task_put(t);
+                if (resumed) {
+                    // sched_wakeup 在 rq->lock 下确认仍处于阻塞状态后放回就绪队列（可能在另一个处理器上）
+                    kprintf("[AI_EXECUTOR] Resumed process %d\n", action.pid);
+                    return;
                 }
                 
                 kprintf("[AI_EXECUTOR] Process %d not found\n", action.pid);
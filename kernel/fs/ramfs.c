@@ -1,11 +1,17 @@
 #include <fs/ramfs.h>
 #include <mm/kheap.h>
+#include <mm/slab.h>
+#include <mm/vmalloc.h>
 #include <string.h>
 #include <vga.h>
 
 // 全局变量
 static uint32_t next_inode = 1;
 
+// inode 和目录项的对象缓存
+static kmem_cache_t* inode_cache = NULL;
+static kmem_cache_t* dentry_cache = NULL;
+
 // RamFS文件操作函数声明
 static int ramfs_open(inode_t* inode, file_t* file);
 static int ramfs_close(file_t* file);
@@ -32,13 +38,22 @@ file_operations_t ramfs_file_ops = {
 
 // 初始化RamFS
 int ramfs_init(void) {
+    if (!inode_cache) {
+        inode_cache = kmem_cache_create("ramfs_inode", sizeof(ramfs_inode_t), 0, NULL);
+        dentry_cache = kmem_cache_create("ramfs_dentry", sizeof(ramfs_dir_entry_t), 0, NULL);
+    }
+    if (!inode_cache || !dentry_cache) {
+        kprintf("[RAMFS] Failed to create object caches\n");
+        return -1;
+    }
+    
     kprintf("[RAMFS] RamFS initialized\n");
     return 0;
 }
 
 // 创建新的RamFS inode
 static ramfs_inode_t* ramfs_alloc_inode(file_type_t type) {
-    ramfs_inode_t* ramfs_inode = (ramfs_inode_t*)kmalloc(sizeof(ramfs_inode_t));
+    ramfs_inode_t* ramfs_inode = (ramfs_inode_t*)kmem_cache_alloc(inode_cache);
     if (!ramfs_inode) {
         return NULL;
     }
@@ -73,13 +88,13 @@ inode_t* ramfs_create_root(void) {
     }
     
     // 创建当前目录和父目录项
-    ramfs_dir_entry_t* dot_entry = (ramfs_dir_entry_t*)kmalloc(sizeof(ramfs_dir_entry_t));
-    ramfs_dir_entry_t* dotdot_entry = (ramfs_dir_entry_t*)kmalloc(sizeof(ramfs_dir_entry_t));
+    ramfs_dir_entry_t* dot_entry = (ramfs_dir_entry_t*)kmem_cache_alloc(dentry_cache);
+    ramfs_dir_entry_t* dotdot_entry = (ramfs_dir_entry_t*)kmem_cache_alloc(dentry_cache);
     
     if (!dot_entry || !dotdot_entry) {
-        kfree(dot_entry);
-        kfree(dotdot_entry);
-        kfree(root_inode);
+        kmem_cache_free(dentry_cache, dot_entry);
+        kmem_cache_free(dentry_cache, dotdot_entry);
+        kmem_cache_free(inode_cache, root_inode);
         return NULL;
     }
     
@@ -170,24 +185,23 @@ static ssize_t ramfs_write(file_t* file, const void* buf, size_t count, off_t of
     // 确保有足够的空间
     size_t new_size = offset + count;
     if (new_size > ramfs_inode->data_capacity) {
-        // 计算新的容量（按4KB递增）
-        size_t new_capacity = ((new_size + 4095) & ~4095);
+        // 按比例扩大容量，文件缓冲区按页分配，不占用小对象堆
+        size_t new_capacity = kcapacity_hint(ramfs_inode->data_capacity, new_size);
         
-        // 重新分配内存
-        void* new_data = kmalloc(new_capacity);
+        // 原地扩展或重新映射已有的页，不复制现有数据
+        void* new_data = ramfs_inode->data ? krealloc(ramfs_inode->data, new_capacity) : vmalloc(new_capacity);
         if (!new_data) {
             return -1;
         }
         
-        // 复制现有数据
-        if (ramfs_inode->data) {
-            memcpy(new_data, ramfs_inode->data, ramfs_inode->data_size);
-            kfree(ramfs_inode->data);
-        }
-        
         // 更新数据指针和容量
         ramfs_inode->data = new_data;
-        ramfs_inode->data_capacity = new_capacity;
+        ramfs_inode->data_capacity = ksize(new_data);
+    }
+    
+    // 写入位置超过文件末尾时，中间的空洞读出为零
+    if (offset > ramfs_inode->data_size) {
+        memset((uint8_t*)ramfs_inode->data + ramfs_inode->data_size, 0, offset - ramfs_inode->data_size);
     }
     
     // 写入数据
@@ -223,9 +237,9 @@ static int ramfs_create(inode_t* parent, const char* name, file_type_t type, ino
     }
     
     // 创建目录项
-    ramfs_dir_entry_t* new_entry = (ramfs_dir_entry_t*)kmalloc(sizeof(ramfs_dir_entry_t));
+    ramfs_dir_entry_t* new_entry = (ramfs_dir_entry_t*)kmem_cache_alloc(dentry_cache);
     if (!new_entry) {
-        kfree(new_ramfs_inode);
+        kmem_cache_free(inode_cache, new_ramfs_inode);
         return -1;
     }
     
@@ -264,12 +278,12 @@ static int ramfs_mkdir(inode_t* parent, const char* name) {
     ramfs_inode_t* dir_inode = (ramfs_inode_t*)result->private_data;
     
     // 创建当前目录和父目录项
-    ramfs_dir_entry_t* dot_entry = (ramfs_dir_entry_t*)kmalloc(sizeof(ramfs_dir_entry_t));
-    ramfs_dir_entry_t* dotdot_entry = (ramfs_dir_entry_t*)kmalloc(sizeof(ramfs_dir_entry_t));
+    ramfs_dir_entry_t* dot_entry = (ramfs_dir_entry_t*)kmem_cache_alloc(dentry_cache);
+    ramfs_dir_entry_t* dotdot_entry = (ramfs_dir_entry_t*)kmem_cache_alloc(dentry_cache);
     
     if (!dot_entry || !dotdot_entry) {
-        kfree(dot_entry);
-        kfree(dotdot_entry);
+        kmem_cache_free(dentry_cache, dot_entry);
+        kmem_cache_free(dentry_cache, dotdot_entry);
         return -1;
     }
     
@@ -328,9 +342,17 @@ static int ramfs_rmdir(inode_t* parent, const char* name) {
         parent_ramfs_inode->entries = (entry->next != entry) ? entry->next : NULL;
     }
     
+    // 释放空目录中的.和..目录项
+    if (sub_entry) {
+        if (sub_entry->next != sub_entry) {
+            kmem_cache_free(dentry_cache, sub_entry->next);
+        }
+        kmem_cache_free(dentry_cache, sub_entry);
+    }
+    
     // 释放目录项和inode
-    kfree(entry);
-    kfree(dir_inode);
+    kmem_cache_free(dentry_cache, entry);
+    kmem_cache_free(inode_cache, dir_inode);
     
     return 0;
 }
@@ -367,12 +389,12 @@ static int ramfs_unlink(inode_t* parent, const char* name) {
     // 释放文件数据
     ramfs_inode_t* file_inode = (ramfs_inode_t*)entry->inode->private_data;
     if (file_inode->data) {
-        kfree(file_inode->data);
+        vfree(file_inode->data);
     }
     
     // 释放文件项和inode
-    kfree(entry);
-    kfree(file_inode);
+    kmem_cache_free(dentry_cache, entry);
+    kmem_cache_free(inode_cache, file_inode);
     
     return 0;
 }
@@ -1,5 +1,6 @@
 #include <fs.h>
 #include <mm/paging.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <vga.h>
 #include <serial.h>
@@ -9,6 +10,7 @@ static mount_point_t mount_points[16];
 static int mount_point_count = 0;
 static file_descriptor_t file_descriptors[MAX_FILES];
 static uint32_t next_inode = 1;
+static kmem_cache_t* inode_cache = NULL;
 
 // 文件系统私有数据
 typedef struct {
@@ -48,7 +50,7 @@ static inode_t* tmpfs_create(const char* path, uint8_t type, uint16_t permission
     }
     
     // 分配inode
-    inode_t* inode = (inode_t*)kmalloc(sizeof(inode_t));
+    inode_t* inode = (inode_t*)kmem_cache_alloc(inode_cache);
     if (!inode) {
         return NULL;
     }
@@ -112,20 +114,23 @@ static int tmpfs_write(inode_t* inode, const void* buf, size_t count, uint32_t o
         return -1;
     }
     
-    // 确保有足够的空间
-    if (offset + count > inode->size) {
-        void* new_data = kmalloc(offset + count);
+    // 确保有足够的空间：容量按比例增长，krealloc 尽量原地扩展，连续追加的总开销为线性
+    size_t new_size = offset + count;
+    size_t capacity = ksize(inode->data);
+    if (new_size > capacity) {
+        void* new_data = krealloc(inode->data, kcapacity_hint(capacity, new_size));
         if (!new_data) {
             return -1;
         }
-        
-        if (inode->data) {
-            memcpy(new_data, inode->data, inode->size);
-            kfree(inode->data);
-        }
-        
         inode->data = new_data;
-        inode->size = offset + count;
+    }
+    
+    // 写入位置超过文件末尾时，中间的空洞读出为零
+    if (offset > inode->size) {
+        memset((char*)inode->data + inode->size, 0, offset - inode->size);
+    }
+    if (new_size > inode->size) {
+        inode->size = new_size;
     }
     
     memcpy((char*)inode->data + offset, buf, count);
@@ -145,7 +150,7 @@ static int tmpfs_unlink(const char* path) {
     if (inode->data) {
         kfree(inode->data);
     }
-    kfree(inode);
+    kmem_cache_free(inode_cache, inode);
     
     return 0;
 }
@@ -167,7 +172,7 @@ static int tmpfs_rmdir(const char* path) {
     if (inode->children) {
         kfree(inode->children);
     }
-    kfree(inode);
+    kmem_cache_free(inode_cache, inode);
     
     return 0;
 }
@@ -216,6 +221,11 @@ void init_filesystem(void) {
         file_descriptors[i].flags = 0;
     }
     
+    // inode 从专用对象缓存分配
+    if (!inode_cache) {
+        inode_cache = kmem_cache_create("tmpfs_inode", sizeof(inode_t), 0, NULL);
+    }
+    
     // 挂载根文件系统
     mount(NULL, "/", FS_TYPE_TMPFS, 0);
     
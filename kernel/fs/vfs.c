@@ -1,23 +1,29 @@
 #include <fs/vfs.h>
 #include <mm/kheap.h>
+#include <mm/slab.h>
 #include <string.h>
 #include <vga.h>
 
 // 全局变量
 static mount_point_t* mount_points = NULL;
 static inode_t* root_inode = NULL;
+static kmem_cache_t* mount_cache = NULL;
 
 // 初始化虚拟文件系统
 void vfs_init(void) {
     mount_points = NULL;
     root_inode = NULL;
+    
+    if (!mount_cache) {
+        mount_cache = kmem_cache_create("mount_point", sizeof(mount_point_t), 0, NULL);
+    }
     kprintf("[VFS] Virtual File System initialized\n");
 }
 
 // 挂载文件系统
 int vfs_mount(const char* device, const char* mount_point, file_operations_t* f_ops, inode_t* root_inode) {
     // 创建挂载点结构
-    mount_point_t* new_mount = (mount_point_t*)kmalloc(sizeof(mount_point_t));
+    mount_point_t* new_mount = (mount_point_t*)kmem_cache_alloc(mount_cache);
     if (!new_mount) {
         return -1;
     }
@@ -25,7 +31,7 @@ int vfs_mount(const char* device, const char* mount_point, file_operations_t* f_
     // 分配内存并复制路径
     new_mount->mount_point = (char*)kmalloc(strlen(mount_point) + 1);
     if (!new_mount->mount_point) {
-        kfree(new_mount);
+        kmem_cache_free(mount_cache, new_mount);
         return -1;
     }
     strcpy(new_mount->mount_point, mount_point);
@@ -64,7 +70,7 @@ int vfs_umount(const char* mount_point) {
             
             // 释放资源
             kfree(current->mount_point);
-            kfree(current);
+            kmem_cache_free(mount_cache, current);
             
             kprintf("[VFS] Unmounted filesystem from %s\n", mount_point);
             return 0;
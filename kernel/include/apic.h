@@ -0,0 +1,78 @@
+#ifndef _APIC_H_
+#define _APIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 本地 APIC：每个处理器一个，负责处理器间中断（IPI）和本处理器的定时器
+// 外部设备中断仍经 8259A 送到 BSP（虚拟线模式），不使用 I/O APIC
+#define LAPIC_DEFAULT_BASE 0xFEE00000
+
+// 寄存器偏移
+#define LAPIC_ID 0x020
+#define LAPIC_VERSION 0x030
+#define LAPIC_TPR 0x080
+#define LAPIC_EOI 0x0B0
+#define LAPIC_SVR 0x0F0
+#define LAPIC_IRR 0x200           // 中断请求寄存器（8 个，间隔 0x10，每个 32 位）
+#define LAPIC_ESR 0x280
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_LINT0 0x350
+#define LAPIC_LVT_LINT1 0x360
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_INIT 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3E0
+
+// 寄存器位
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_DIV_16 0x3
+#define LAPIC_ICR_INIT 0x500
+#define LAPIC_ICR_STARTUP 0x600
+#define LAPIC_ICR_PENDING 0x1000
+#define LAPIC_ICR_ASSERT 0x4000
+#define LAPIC_ICR_LEVEL 0x8000
+
+// 中断向量
+#define LAPIC_TIMER_VECTOR 0x30   // AP 的时钟滴答
+#define RESCHED_VECTOR 0x31       // 重新调度 IPI
+#define TLB_SHOOTDOWN_VECTOR 0x32 // 刷新内核地址的 TLB 项
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+// 映射寄存器页（BSP 调用一次），返回是否成功
+bool lapic_map(uint32_t phys_base);
+
+// 开启本处理器的 APIC；AP 屏蔽 LINT0/LINT1，外部中断只送到 BSP
+void lapic_enable(bool bsp);
+
+uint32_t lapic_id(void);
+void lapic_eoi(void);
+
+// 发送 INIT 和 STARTUP（启动代码位于 page * 4096）
+void lapic_send_init(uint32_t apic_id);
+void lapic_send_startup(uint32_t apic_id, uint32_t page);
+
+// 向指定处理器发送固定向量的中断
+void lapic_send_ipi(uint32_t apic_id, uint32_t vector);
+
+// 用 PIT 校准：返回一个 PIT 周期（一个时钟滴答）内的 APIC 定时器计数
+// 调用者关中断，PIT 处于周期模式
+uint32_t lapic_timer_calibrate(void);
+
+// 周期定时器：每 count 个计数产生一次 LAPIC_TIMER_VECTOR 中断
+void lapic_timer_start(uint32_t count);
+
+// 单次定时器：count 个计数后产生一次 LAPIC_TIMER_VECTOR 中断
+void lapic_timer_oneshot(uint32_t count);
+
+// 定时器的剩余计数（单次定时到期后为 0）
+uint32_t lapic_timer_remaining(void);
+
+// 本处理器上 vector 号中断是否已请求但尚未处理
+bool lapic_irq_pending(uint32_t vector);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// 基准测试条目
+typedef struct {
+    const char* name;
+    void (*func)(void);
+    const char* description;
+} bench_t;
+
+// 读取时间戳计数器低 32 位（测量短区间足够）
+uint32_t bench_cycles(void);
+
+// 按名称运行基准测试，name 为 NULL 时列出所有测试
+int bench_run(const char* name);
+
+// 各基准测试
+void bench_tlb_switch(void);
+void bench_unmap_range(void);
+void bench_page_fault(void);
+void bench_append(void);
+void bench_sched(void);
+void bench_timer(void);
+void bench_smp(void);
+
+#endif // BENCH_H
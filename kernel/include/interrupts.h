@@ -5,6 +5,9 @@
 
 #define IDT_ENTRIES 256
 
+// EFLAGS 的中断允许位
+#define EFLAGS_IF 0x200
+
 typedef struct {
     uint16_t offset_low;
     uint16_t selector;
@@ -38,8 +41,11 @@ void idt_init(void);
 void idt_set_gate(uint8_t num, uint64_t base, uint16_t sel, uint8_t flags);
 void isr_install(void);
 void irq_install(void);
+void idt_load(void);
 
 void keyboard_handler(void);
 void keyboard_handler_wrapper(void);
+void serial_handler(void);
+void serial_handler_wrapper(void);
 
 #endif
@@ -10,6 +10,8 @@
 #define KEYBOARD_STATUS_OUTPUT_FULL 0x01
 #define KEYBOARD_STATUS_INPUT_FULL 0x02
 
+#define KEYBOARD_BUFFER_SIZE 64
+
 typedef struct {
     char scancode;
     char ascii;
@@ -20,5 +22,6 @@ void keyboard_init(void);
 bool keyboard_read(key_event_t* event);
 char keyboard_get_scancode(void);
 char scancode_to_ascii(char scancode);
+void keyboard_irq(void);
 
 #endif
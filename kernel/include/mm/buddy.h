@@ -0,0 +1,51 @@
+#ifndef MM_BUDDY_H
+#define MM_BUDDY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mm/page.h>
+
+// 最大阶数：2^10 帧 = 4MB（与 PSE 大页大小一致）
+#define BUDDY_MAX_ORDER 10
+#define BUDDY_ORDER_COUNT (BUDDY_MAX_ORDER + 1)
+
+// 内存区域：NORMAL 位于内核直接映射内，HIGH 只能通过页表映射访问
+#define BUDDY_ZONE_NORMAL 0
+#define BUDDY_ZONE_HIGH 1
+#define BUDDY_ZONE_COUNT 2
+
+// 每阶空闲区域
+typedef struct {
+    page_list_t free_list;    // 空闲块链表（块首帧的描述符）
+    uint32_t alloc_count;     // 该阶的分配次数
+    uint32_t split_count;     // 该阶块被拆分的次数
+    uint32_t merge_count;     // 该阶块被合并的次数
+} buddy_free_area_t;
+
+// 初始化伙伴分配器（使用 mem_map 描述符数组），初始时所有帧均视为已占用
+// 帧号小于 normal_frames 的帧属于 NORMAL 区域，normal_frames 须按最大块对齐
+void buddy_init(uint32_t total_frames, uint32_t normal_frames);
+
+// 将 [start, start + count) 范围的帧交给伙伴分配器管理
+void buddy_free_range(uint32_t start, uint32_t count);
+
+// 从指定区域分配 2^order 个连续帧，返回首帧帧号，失败返回 0
+uint32_t buddy_alloc(uint32_t order, uint32_t zone);
+
+// 释放 buddy_alloc 分配的块
+void buddy_free(uint32_t frame, uint32_t order);
+
+// 返回能容纳 count 个帧的最小阶数
+uint32_t buddy_order_for(uint32_t count);
+
+// 空闲帧数量
+uint32_t buddy_free_frames(void);
+uint32_t buddy_zone_free_frames(uint32_t zone);
+
+// 获取指定区域、指定阶的空闲区域统计
+const buddy_free_area_t* buddy_get_free_area(uint32_t zone, uint32_t order);
+
+// 打印每阶空闲块统计
+void buddy_dump(void);
+
+#endif // MM_BUDDY_H
@@ -0,0 +1,68 @@
+#ifndef MM_KHEAP_H
+#define MM_KHEAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 内核堆虚拟地址窗口：只保留地址空间，物理帧随堆增长按需映射
+#define KHEAP_START 0xC0000000
+#define KHEAP_MAX_SIZE 0x20000000     // 最多 512MB
+#define KHEAP_INITIAL_SIZE 0x40000    // 启动时映射 256KB
+#define KHEAP_GROW_MIN 0x10000        // 每次至少扩展 64KB，减少扩展次数
+
+// 内核堆统计
+typedef struct {
+    size_t total_size;        // 堆总大小
+    size_t used_size;         // 已分配块占用的大小（包括块头）
+    size_t free_size;         // 空闲块的总大小
+    size_t largest_free;      // 最大空闲块的大小
+    uint32_t free_blocks;     // 空闲块数量
+    uint32_t used_blocks;     // 已分配块数量
+    uint32_t fragmentation;   // 外部碎片率（百分比）：1 - 最大空闲块 / 空闲总量
+    size_t peak_size;         // 堆大小的历史最高值
+    size_t peak_used;         // 已用大小的历史最高值
+    uint32_t grow_count;      // 扩展次数
+    uint32_t trim_count;      // 收缩次数
+    uint32_t realloc_inplace; // krealloc 原地完成的次数
+    uint32_t realloc_moved;   // krealloc 重新分配并复制的次数
+    uint32_t alloc_count;     // 累计分配次数
+    uint32_t free_count;      // 累计释放次数
+} kheap_stats_t;
+
+// 初始化内核堆
+void init_kheap(void);
+
+// 分配 size 字节（8 字节对齐），失败返回 NULL；分配和释放均为 O(1)
+void* kmalloc(size_t size);
+
+// 分配 size 字节，起始地址按 align（2 的幂）对齐，用 kfree 释放，失败返回 NULL
+void* kmalloc_aligned(size_t size, size_t align);
+
+// 释放 kmalloc 分配的内存，相邻空闲块立即合并
+void kfree(void* ptr);
+
+// 调整已分配内存的大小，内容保留到新旧大小中较小者
+// 后面紧邻的空闲块足够大（或块位于堆末尾可扩展堆）时原地完成，否则重新分配并复制
+// 也接受 vmalloc 分配的内存；ptr 为 NULL 时等同 kmalloc，size 为 0 时释放并返回 NULL
+// 失败返回 NULL，原内存保持不变；重新分配时不保留 kmalloc_aligned 的对齐
+void* krealloc(void* ptr, size_t size);
+
+// 已分配内存的实际可用大小（可能大于请求的大小），调用者可直接使用全部容量
+size_t ksize(const void* ptr);
+
+// 容量提示：当前容量为 current、需要 needed 字节时建议分配的新容量（按比例增长）
+size_t kcapacity_hint(size_t current, size_t needed);
+
+// 将堆末尾完全空闲的页归还给帧分配器（内存紧张时调用），返回释放的帧数
+uint32_t kheap_trim(void);
+
+// 获取内核堆的总大小、已用大小和空闲大小
+void get_kheap_info(size_t* total, size_t* used, size_t* free);
+
+// 获取内核堆的详细统计（包括碎片信息）
+void get_kheap_stats(kheap_stats_t* stats);
+
+// 按大小级别统计空闲块：counts[n] 和 bytes[n] 为大小在 [2^n, 2^(n+1)) 的空闲块数和字节数
+void kheap_free_histogram(uint32_t* counts, size_t* bytes, uint32_t classes);
+
+#endif // MM_KHEAP_H
@@ -0,0 +1,49 @@
+#ifndef MM_KHEAPPROF_H
+#define MM_KHEAPPROF_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// 采样间隔：每 8 次分配记录一次，统计值按间隔放大为估计值
+#define KHEAP_PROF_RATE 8
+
+// 不小于该大小的分配总是采样（大块是内存膨胀的主要来源，不能漏掉）
+#define KHEAP_PROF_LARGE 4096
+
+// 调用点表和采样记录表的容量（均为 2 的幂）
+#define KHEAP_PROF_SITES 128
+#define KHEAP_PROF_SAMPLES 512
+
+// 大小级别数：级别 n 覆盖 [2^n, 2^(n+1)) 字节
+#define KHEAP_PROF_CLASSES 32
+
+// 调用点统计（字节数和次数均为按采样权重放大后的估计值）
+typedef struct {
+    uint32_t caller;          // 调用 kmalloc/krealloc 的返回地址（0 为空槽）
+    uint32_t allocs;          // 累计分配次数
+    uint32_t frees;           // 累计释放次数
+    uint32_t live_count;      // 尚未释放的分配数
+    size_t live_bytes;        // 尚未释放的字节数
+    size_t total_bytes;       // 累计分配的字节数
+    uint32_t freed_samples;   // 已释放的采样数
+    uint32_t lifetime_ticks;  // 已释放采样的存活时间总和（时钟滴答）
+    uint32_t class_mask;      // 出现过的大小级别（位 n 对应级别 n）
+} kheap_site_t;
+
+// 记录一次分配；返回 true 表示该分配被采样，释放或原地调整大小时须通知分析器
+bool kheap_prof_alloc(void* ptr, size_t size, uint32_t caller);
+
+// 采样的分配被释放
+void kheap_prof_free(void* ptr);
+
+// 采样的分配原地调整为 size 字节
+void kheap_prof_resize(void* ptr, size_t size);
+
+// 清空所有调用点和采样记录
+void kheap_prof_reset(void);
+
+// 生成 /proc/kheapprof 内容：按存活字节排序的调用点、分配速率、空闲块直方图，返回写入的字节数
+int kheap_prof_info(char* buf, size_t buf_size);
+
+#endif // MM_KHEAPPROF_H
@@ -0,0 +1,41 @@
+#ifndef MM_MEMMAP_H
+#define MM_MEMMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 最多记录的内存区域数量
+#define MEMMAP_MAX_REGIONS 32
+
+// 引导信息缺失时假设的可用内存上界（保守值）
+#define MEMMAP_FALLBACK_END 0x01000000
+
+// 物理内存区域 [start, end)
+typedef struct {
+    uint32_t start;
+    uint32_t end;
+} memmap_region_t;
+
+// 解析引导加载器提供的内存图（支持 Multiboot2 和 Multiboot1）
+void memmap_init(uint32_t magic, uint32_t mbi_addr);
+
+// 可用内存区域
+uint32_t memmap_usable_count(void);
+const memmap_region_t* memmap_usable_region(uint32_t index);
+
+// 可用内存的最高物理地址（不含）
+uint32_t memmap_highest_usable(void);
+
+// 可用内存的总字节数
+uint32_t memmap_usable_bytes(void);
+
+// 从 limit 以下可用且未保留的内存中分配引导期内存，分配结果自动标记为保留，失败返回 0
+uint32_t memmap_alloc_early(uint32_t size, uint32_t align, uint32_t limit);
+
+// 对每段可用且未保留的帧范围调用 fn(start_frame, frame_count)
+void memmap_for_each_free(void (*fn)(uint32_t start_frame, uint32_t count));
+
+// 打印内存图
+void memmap_dump(void);
+
+#endif // MM_MEMMAP_H
@@ -0,0 +1,57 @@
+#ifndef MM_PAGE_H
+#define MM_PAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 物理帧状态标志
+#define PG_RESERVED 0x01      // 帧不受分配器管理（内存空洞、内核镜像、引导数据等）
+#define PG_BUDDY 0x02         // 帧是伙伴分配器中空闲块的首帧
+#define PG_HEAD 0x04          // 帧是已分配块的首帧
+#define PG_DIRTY 0x08         // 帧内容已修改
+#define PG_PINNED 0x10        // 帧被固定，回收代码不得移动或换出
+#define PG_ZEROED 0x20        // 帧内容已清零
+#define PG_SLAB 0x40          // 帧属于 slab 缓存
+#define PG_LRU 0x80           // 帧位于 LRU 链表中
+
+// 物理帧描述符（16 字节，描述符数组按页对齐，每个描述符不会跨越缓存行）
+typedef struct page {
+    struct page* next;        // 链表中的下一个描述符（空闲链表、LRU 等）
+    struct page* prev;        // 链表中的上一个描述符
+    void* owner;              // 拥有者（slab 缓存、地址空间等），由使用者解释
+    uint8_t flags;            // PG_* 状态标志
+    uint8_t order;            // 块的阶数（仅块首帧有效）
+    uint16_t refcount;        // 引用计数（仅已分配块的首帧有效；处理器之间共享，只通过 page_ref_* 原子修改）
+} page_t;
+
+// 描述符链表
+typedef struct {
+    page_t* head;             // 链表头
+    uint32_t count;           // 链表中的描述符数量
+} page_list_t;
+
+// 描述符数组（按帧号索引）
+extern page_t* mem_map;
+
+// 计算管理 total_frames 个帧所需的描述符数组大小（字节）
+size_t page_array_size(uint32_t total_frames);
+
+// 初始化描述符数组，所有帧初始标记为 PG_RESERVED
+void page_array_init(void* array, uint32_t total_frames);
+
+// 帧号与描述符互相转换
+page_t* pfn_to_page(uint32_t frame);
+uint32_t page_to_pfn(page_t* page);
+
+// 引用计数：返回操作后的计数
+uint32_t page_ref_get(page_t* page);
+uint32_t page_ref_put(page_t* page);
+uint32_t page_ref_count(page_t* page);
+
+// 链表操作
+void page_list_init(page_list_t* list);
+void page_list_add(page_list_t* list, page_t* page);
+void page_list_remove(page_list_t* list, page_t* page);
+page_t* page_list_pop(page_list_t* list);
+
+#endif // MM_PAGE_H
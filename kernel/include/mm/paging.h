@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include <mm/kheap.h>
 
 // 页大小：4KB
 #define PAGE_SIZE 4096
@@ -21,6 +23,39 @@
 #define PAGE_DIRTY 0x40       // 页被修改过
 #define PAGE_PAT 0x80         // 页属性表
 #define PAGE_GLOBAL 0x100     // 全局页（CPU 不刷新 TLB）
+#define PAGE_LARGE 0x80       // 页目录项：4MB 大页（PS 位，需要 CR4.PSE）
+#define PAGE_COW 0x200        // 软件位：写时复制页（硬件只读）
+
+// 页表项中的物理地址掩码
+#define PAGE_FRAME_MASK 0xFFFFF000
+#define LARGE_PAGE_FRAME_MASK 0xFFC00000
+
+// 大页大小：4MB
+#define LARGE_PAGE_SIZE 0x400000
+
+// 批量操作超过该页数时整体刷新 TLB，而不是逐页 invlpg
+#define TLB_FLUSH_THRESHOLD 32
+
+// CR4 控制位
+#define CR4_PSE 0x10          // 页大小扩展（4MB 页）
+#define CR4_PGE 0x80          // 全局页（重载 CR3 不刷新全局页的 TLB 项）
+
+// 虚拟地址空间布局
+// 0x00000000 - 0x07FFFFFF: 内核直接映射（物理地址恒等映射，4MB 大页）
+// 0x08000000 - 0xBFFFFFFF: 用户空间
+// 0xC0000000 - 0xDFFFFFFF: 内核堆（按需增长）
+// 0xE0000000 - 0xFFBFFFFF: 内核虚拟区域（vmalloc）
+// 0xFFC00000 - 0xFFFFFFFF: 固定映射（临时映射槽位等）
+#define KERNEL_DIRECT_MAP_END 0x08000000
+#define USER_SPACE_START 0x08000000
+#define USER_SPACE_END 0xC0000000
+#define KERNEL_VIRT_START 0xC0000000
+
+// 内核临时映射槽位（内核虚拟地址的最后一页）
+#define KMAP_TEMP_ADDR 0xFFFFF000
+
+// 本地 APIC 寄存器的固定映射（不缓存，所有处理器共用同一虚拟地址，各自访问自己的 APIC）
+#define LAPIC_VIRT_ADDR 0xFFFFE000
 
 // 页目录项和页表项的结构（32位）
 typedef uint32_t page_entry_t;
@@ -31,9 +66,9 @@ typedef page_entry_t page_table_t[PAGE_TABLE_ENTRIES];
 
 // 物理帧分配器状态
 typedef struct {
-    uint32_t total_frames;     // 总物理帧数
+    uint32_t total_frames;     // 帧号范围（含内存空洞）
+    uint32_t usable_frames;    // 可用内存中的物理帧数
     uint32_t used_frames;      // 已使用的物理帧数
-    uint32_t* frame_bitmap;    // 物理帧位图
 } frame_allocator_t;
 
 // 分页初始化函数
@@ -42,23 +77,51 @@ void init_paging(void);
 // 物理帧分配和释放函数
 uint32_t alloc_frame(void);
 void free_frame(uint32_t frame);
+uint32_t alloc_frames(uint32_t order);
+void free_frames(uint32_t frame, uint32_t order);
+// 优先分配直接映射以外的高端帧，仅适用于只通过页表映射访问的内存
+uint32_t alloc_frame_high(void);
+// 从指定区域（BUDDY_ZONE_*）分配一个物理帧，不回退
+uint32_t alloc_frame_zone(uint32_t zone);
+// 将物理帧清零（高端帧通过临时映射访问）
+void clear_frame(uint32_t frame);
+// 物理帧引用计数：分配时为 1，free_frame 减少计数，归零时才真正释放
+void frame_ref(uint32_t frame);
+uint32_t frame_refcount(uint32_t frame);
 
-// 页表操作函数
+// TLB 刷新函数
+void tlb_flush_page(void* virtual_addr);  // 刷新单页（包括全局页）
+void tlb_flush_user(void);                // 重载 CR3，只刷新非全局页
+void tlb_flush_all(void);                 // 刷新全部 TLB（包括内核全局页）
+void tlb_flush_kernel_range(uint32_t start, uint32_t end);  // 刷新本处理器上内核地址范围的 TLB 项
+void paging_set_global_pages(bool enable); // 开关 CR4.PGE（用于基准测试）
+
+// 页表操作函数（用户空间地址作用于当前页目录，内核空间地址作用于共享的内核页表）
 void map_page(void* virtual_addr, uint32_t physical_addr, uint32_t flags);
 void unmap_page(void* virtual_addr);
+// 批量映射连续物理内存，失败返回 -1
+int map_range(void* virtual_addr, uint32_t physical_addr, size_t size, uint32_t flags);
+// 批量取消映射并释放对帧的引用，返回取消映射的页数
+uint32_t unmap_range(void* virtual_addr, size_t size);
 uint32_t get_physical_addr(void* virtual_addr);
+page_entry_t* paging_get_pte(void* virtual_addr);
 
-// 内核堆管理函数
-void* kmalloc(size_t size);
-void kfree(void* ptr);
-void init_kheap(void);
-void get_kheap_info(size_t* total, size_t* used, size_t* free);
+// 临时映射任意物理页（用于访问直接映射以外的帧），单槽位，不可嵌套
+void* kmap_temp(uint32_t physical_addr);
+void kunmap_temp(void);
 
 // 内存信息获取函数
 size_t get_total_memory(void);
 size_t get_used_memory(void);
 size_t get_free_memory(void);
 
+// 页目录管理函数（页目录独占一个物理帧，地址可直接装入 CR3）
+page_directory_t* paging_create_dir(void);
+page_directory_t* paging_clone_dir(page_directory_t* page_dir);
+void paging_destroy_dir(page_directory_t* page_dir);
+void paging_switch_dir(page_directory_t* page_dir);
+page_directory_t* paging_current_dir(void);
+
 // 获取内核页目录
 page_directory_t* get_kernel_page_dir(void);
 
@@ -0,0 +1,51 @@
+#ifndef MM_SCRATCH_H
+#define MM_SCRATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 临时内存区（scratch arena）：顺序分配、不单独释放，在请求边界整体重置
+// 系统调用返回时自动重置当前进程的临时区，shell 每执行完一条命令重置一次
+// 适合路径缓冲区、procfs 格式化输出、参数副本等只在一次请求内使用的数据
+// 中断处理函数不得使用（会与被中断的系统调用共用同一临时区）
+
+// 分配对齐
+#define SCRATCH_ALIGN 8
+
+// 单次分配的上限（更大的临时数据请使用 vmalloc）
+#define SCRATCH_MAX_ORDER 4                           // 2^4 帧 = 64KB
+#define SCRATCH_MAX_SIZE ((PAGE_SIZE << SCRATCH_MAX_ORDER) - sizeof(scratch_chunk_t))
+
+// 临时区的内存块（位于块首部，之后是可分配空间）
+typedef struct scratch_chunk {
+    struct scratch_chunk* next;   // 更早的内存块（链表头为当前分配的块）
+    uint32_t size;                // 块大小（包括头部）
+    uint32_t used;                // 已使用的字节数（包括头部）
+    uint32_t order;               // 块的阶数
+} scratch_chunk_t;
+
+// 临时区
+typedef struct {
+    scratch_chunk_t* chunk;       // 当前内存块；重置时只保留最早的一块
+    uint32_t bytes;               // 本次请求已分配的字节数
+    uint32_t peak;                // 单次请求分配字节数的历史最高值
+    uint32_t overflows;           // 当前块放不下、链接新块的次数
+} scratch_arena_t;
+
+// 初始化临时区（第一块在首次分配时才申请）
+void scratch_init(scratch_arena_t* arena);
+
+// 从当前进程的临时区分配 size 字节（8 字节对齐），失败返回 NULL
+void* scratch_alloc(size_t size);
+
+// 在临时区中复制内存或字符串，失败返回 NULL
+void* scratch_memdup(const void* src, size_t size);
+char* scratch_strdup(const char* str);
+
+// 重置当前进程的临时区：之前分配的内存全部失效，多出的内存块归还给帧分配器
+void scratch_reset(void);
+
+// 释放临时区的全部内存块（进程退出时调用）
+void scratch_release(scratch_arena_t* arena);
+
+#endif // MM_SCRATCH_H
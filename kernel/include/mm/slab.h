@@ -0,0 +1,93 @@
+#ifndef MM_SLAB_H
+#define MM_SLAB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <spinlock.h>
+
+// 缓存名称最大长度（含结尾 0）
+#define SLAB_NAME_LEN 24
+
+// 单个 slab 的最大阶数（2^3 帧 = 32KB）
+#define SLAB_MAX_ORDER 3
+
+// 着色步长：相邻 slab 的首个对象错开一个缓存行
+#define SLAB_COLOUR_ALIGN 32
+
+// 对象最小对齐
+#define SLAB_MIN_ALIGN 8
+
+// 对象构造函数：对象所在 slab 创建时调用一次，释放对象时调用者须将其恢复到构造后的状态
+typedef void (*kmem_ctor_t)(void* obj);
+
+struct kmem_cache;
+
+// slab 头部（位于 slab 首帧开头，之后是空闲索引数组和对象区）
+typedef struct slab {
+    struct slab* next;            // 所在链表中的下一个 slab
+    struct slab* prev;            // 所在链表中的上一个 slab
+    struct kmem_cache* cache;     // 所属缓存
+    void* s_mem;                  // 第一个对象的地址（已加上着色偏移）
+    uint16_t inuse;               // 已分配的对象数
+    uint16_t free;                // 第一个空闲对象的索引
+    uint16_t colour_off;          // 着色偏移（字节）
+    uint16_t frame_count;         // slab 占用的帧数
+} slab_t;
+
+// slab 链表
+typedef struct {
+    slab_t* head;
+    uint32_t count;
+} slab_list_t;
+
+// 对象缓存
+typedef struct kmem_cache {
+    char name[SLAB_NAME_LEN];     // 缓存名称
+    uint32_t object_size;         // 对象大小（调用者请求的大小）
+    uint32_t size;                // 对齐后每个对象占用的大小
+    uint32_t align;               // 对象对齐
+    uint32_t order;               // 每个 slab 的阶数
+    uint32_t objs_per_slab;       // 每个 slab 的对象数
+    uint32_t obj_offset;          // 未着色时第一个对象相对 slab 起始的偏移
+    kmem_ctor_t ctor;             // 构造函数（可为 NULL）
+    spinlock_t lock;              // 保护 slab 链表和统计
+
+    slab_list_t slabs_full;       // 所有对象已分配的 slab
+    slab_list_t slabs_partial;    // 部分对象已分配的 slab
+    slab_list_t slabs_free;       // 没有对象被分配的 slab
+
+    uint32_t colour_count;        // 可用的着色数量
+    uint32_t colour_next;         // 下一个 slab 使用的着色
+
+    uint32_t active_objs;         // 已分配的对象数
+    uint32_t total_objs;          // 所有 slab 中的对象总数
+    uint32_t allocs;              // 累计分配次数
+    uint32_t frees;               // 累计释放次数
+    uint32_t slabs_created;       // 累计创建的 slab 数
+    uint32_t slabs_destroyed;     // 累计释放的 slab 数
+
+    struct kmem_cache* next;      // 全局缓存链表
+} kmem_cache_t;
+
+// 创建对象缓存，align 为 0 时使用 SLAB_MIN_ALIGN，失败返回 NULL
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_t ctor);
+
+// 销毁对象缓存（缓存中不得有未释放的对象），成功返回 0
+int kmem_cache_destroy(kmem_cache_t* cache);
+
+// 从缓存分配一个对象，失败返回 NULL
+void* kmem_cache_alloc(kmem_cache_t* cache);
+
+// 将对象归还给缓存
+void kmem_cache_free(kmem_cache_t* cache, void* obj);
+
+// 释放缓存中所有空闲 slab，返回归还的帧数
+uint32_t kmem_cache_shrink(kmem_cache_t* cache);
+
+// 生成 slabinfo 格式的统计信息，返回写入的字节数
+int kmem_cache_info(char* buf, size_t buf_size);
+
+// 所有缓存的 slab 占用的帧数
+uint32_t kmem_cache_frames(void);
+
+#endif // MM_SLAB_H
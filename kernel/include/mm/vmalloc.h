@@ -0,0 +1,51 @@
+#ifndef MM_VMALLOC_H
+#define MM_VMALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// 内核虚拟区域窗口：位于内核堆之后，最后 4MB 留给临时映射等固定用途
+#define VMALLOC_START 0xE0000000
+#define VMALLOC_END 0xFFC00000
+
+// 每个区域之后保留一个不映射的保护页，越界访问会触发缺页异常
+#define VMALLOC_GUARD_SIZE 0x1000
+
+// 内核虚拟区域
+typedef struct vmap_area {
+    uint32_t addr;                // 起始地址（页对齐）
+    uint32_t pages;               // 已映射的页数（不含保护页）
+    struct vmap_area* next;       // 下一个区域（按地址排序）
+} vmap_area_t;
+
+// 内核虚拟区域统计
+typedef struct {
+    uint32_t areas;               // 区域数量
+    uint32_t pages;               // 已映射的页数
+    uint32_t largest_gap;         // 最大的空闲虚拟地址区间（字节）
+} vmalloc_stats_t;
+
+// 初始化内核虚拟区域分配器（需在 init_kheap 之后调用）
+void vmalloc_init(void);
+
+// 分配 size 字节页对齐、虚拟地址连续的内存，物理帧不要求连续，失败返回 NULL
+void* vmalloc(size_t size);
+
+// 释放 vmalloc 分配的内存
+void vfree(void* addr);
+
+// 调整大小：后面的虚拟地址空闲时原地扩展，否则把原有的帧重新映射到新地址（不复制数据）
+// 失败返回 NULL，原内存保持不变
+void* vrealloc(void* ptr, size_t size);
+
+// vmalloc 分配的内存的实际大小（页的整数倍），ptr 无效时返回 0
+size_t vmalloc_size(const void* ptr);
+
+// 判断地址是否位于内核虚拟区域窗口内
+bool is_vmalloc_addr(const void* addr);
+
+// 获取统计信息
+void vmalloc_get_stats(vmalloc_stats_t* stats);
+
+#endif // MM_VMALLOC_H
@@ -0,0 +1,82 @@
+#ifndef MM_VMM_H
+#define MM_VMM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mm/paging.h>
+
+// 虚拟内存区域权限（与 mmap 的 prot 参数一致）
+#define VM_READ 0x1
+#define VM_WRITE 0x2
+#define VM_EXEC 0x4
+
+// 未指定地址时 mmap 的起始搜索地址
+#define VMM_MMAP_BASE 0x80000000
+
+// 缺页异常错误码
+#define PF_PRESENT 0x1        // 页存在（权限错误），否则为缺页
+#define PF_WRITE 0x2          // 写访问
+#define PF_USER 0x4           // 用户态访问
+
+// 虚拟内存区域：[start, end) 内的页在首次访问时按需分配并清零
+typedef struct vm_area {
+    uint32_t start;               // 起始地址（页对齐）
+    uint32_t end;                 // 结束地址（页对齐，不含）
+    uint32_t flags;               // VM_READ / VM_WRITE / VM_EXEC
+    struct vm_area* next;         // 下一个区域（按地址排序）
+} vm_area_t;
+
+// 进程地址空间
+typedef struct vm_space {
+    page_directory_t* page_dir;   // 页目录（独占物理帧，可直接装入 CR3）
+    uint32_t refcount;            // 引用计数（共享地址空间的进程数）
+    vm_area_t* areas;             // 虚拟内存区域链表
+    uint32_t total_pages;         // 所有区域覆盖的页数
+    uint32_t rss_pages;           // 已驻留的用户页数
+    uint32_t fault_count;         // 已处理的缺页次数
+    uint32_t cow_copies;          // 写时复制实际复制的页数
+} vm_space_t;
+
+// 初始化地址空间管理（需在 init_kheap 之后调用）
+void vmm_init(void);
+
+// 内核地址空间（内核线程和空闲进程使用，永不释放）
+vm_space_t* vm_space_kernel(void);
+
+// 当前进程的地址空间
+vm_space_t* vm_space_current(void);
+
+// 创建新的地址空间：用户部分为空，内核部分与所有地址空间共享
+vm_space_t* vm_space_create(void);
+
+// 复制地址空间用于 fork：用户页以写时复制方式共享，开销与页表数量成正比
+vm_space_t* vm_space_fork(vm_space_t* parent);
+
+// 增加引用计数
+vm_space_t* vm_space_get(vm_space_t* space);
+
+// 减少引用计数，计数归零时释放页目录、用户页表和用户页
+void vm_space_put(vm_space_t* space);
+
+// 切换到指定地址空间
+void vm_space_switch(vm_space_t* space);
+
+// 登记 [start, end) 区域，只建立描述符不分配物理页；与已有区域重叠时返回 -1
+int vm_area_map(vm_space_t* space, uint32_t start, uint32_t end, uint32_t flags);
+
+// 取消 [start, end) 内的区域，只释放被取消区域中已驻留的页（space 须为当前地址空间）
+void vm_area_unmap(vm_space_t* space, uint32_t start, uint32_t end);
+
+// 查找包含 addr 的区域
+vm_area_t* vm_area_find(vm_space_t* space, uint32_t addr);
+
+// 在 VMM_MMAP_BASE 以上查找 size 字节的空闲虚拟地址，失败返回 0
+uint32_t vm_area_find_free(vm_space_t* space, uint32_t size);
+
+// 处理缺页：地址位于区域内且访问合法时分配清零的页或复制写时复制页，成功返回 0
+int vm_handle_fault(vm_space_t* space, uint32_t addr, uint32_t error_code);
+
+// 缺页异常处理函数（由 page_fault_handler_wrapper 调用）
+void page_fault_handler(uint32_t error_code, uint32_t eip);
+
+#endif // MM_VMM_H
@@ -0,0 +1,39 @@
+#ifndef MM_ZEROPOOL_H
+#define MM_ZEROPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <mm/buddy.h>
+
+// 每个区域预先清零的帧数上限
+#define ZERO_POOL_TARGET 64
+
+// 空闲进程每次最多清零的帧数（单次清零一帧约数微秒，保持调度延迟可控）
+#define ZERO_POOL_BATCH 4
+
+// 预清零帧池统计
+typedef struct {
+    uint32_t pooled;          // 池中的帧数
+    uint32_t hits;            // 直接从池中取得已清零帧的次数
+    uint32_t misses;          // 池为空、同步清零的次数
+    uint32_t refilled;        // 后台清零的帧数
+} zero_pool_stats_t;
+
+// 分配一个已清零的物理帧：优先从预清零池取，池为空时同步清零
+// HIGH 区域不足时回退到 NORMAL 区域，失败返回 0
+uint32_t alloc_zeroed_frame(uint32_t zone);
+
+// 后台补充预清零池（由空闲进程调用），最多清零 max_frames 帧，返回实际清零的帧数
+uint32_t zero_pool_refill(uint32_t max_frames);
+
+// 将池中的帧归还给伙伴分配器（内存紧张时使用），返回归还的帧数
+uint32_t zero_pool_drain(void);
+
+// 开关预清零池（关闭时池中的帧被归还，用于基准测试对比）
+void zero_pool_set_enabled(bool enable);
+bool zero_pool_enabled(void);
+
+// 获取指定区域的统计信息
+const zero_pool_stats_t* zero_pool_get_stats(uint32_t zone);
+
+#endif // MM_ZEROPOOL_H
@@ -0,0 +1,42 @@
+#ifndef _MULTIBOOT_H_
+#define _MULTIBOOT_H_
+
+#include <stdint.h>
+
+// Multiboot1 引导信息（boot.asm 使用 Multiboot1 头，QEMU -kernel 走此协议）
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+#define MULTIBOOT_INFO_MEMORY 0x00000001
+#define MULTIBOOT_INFO_MODS 0x00000008
+#define MULTIBOOT_INFO_MEM_MAP 0x00000040
+
+#define MULTIBOOT_MEMORY_AVAILABLE 1
+
+struct multiboot_info {
+    uint32_t flags;
+    uint32_t mem_lower;
+    uint32_t mem_upper;
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+} __attribute__((packed));
+
+struct multiboot_mmap_entry_v1 {
+    uint32_t size;
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} __attribute__((packed));
+
+struct multiboot_mod_list {
+    uint32_t mod_start;
+    uint32_t mod_end;
+    uint32_t cmdline;
+    uint32_t pad;
+};
+
+#endif
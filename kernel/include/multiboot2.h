@@ -42,6 +42,12 @@
 #define MULTIBOOT_TAG_TYPE_EFI64_IH 20
 #define MULTIBOOT_TAG_TYPE_LOAD_BASE_ADDR 21
 
+#define MULTIBOOT2_MEMORY_AVAILABLE 1
+#define MULTIBOOT2_MEMORY_RESERVED 2
+#define MULTIBOOT2_MEMORY_ACPI_RECLAIMABLE 3
+#define MULTIBOOT2_MEMORY_NVS 4
+#define MULTIBOOT2_MEMORY_BADRAM 5
+
 struct multiboot_header_tag {
     uint16_t type;
     uint16_t flags;
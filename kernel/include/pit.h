@@ -0,0 +1,36 @@
+#ifndef _PIT_H_
+#define _PIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 8253/8254 可编程间隔定时器，通道 0 接 IRQ0
+#define PIT_FREQUENCY 1193182     // 输入时钟频率（Hz）
+#define PIT_CHANNEL0 0x40
+#define PIT_COMMAND 0x43
+#define PIT_MAX_COUNT 0xFFFF      // 16 位计数器的最大初值（约 54.9ms）
+
+// 命令字：通道 0，先低后高字节访问，二进制计数
+#define PIT_CMD_ONESHOT 0x30      // 模式 0：计数到 0 时产生一次中断
+#define PIT_CMD_PERIODIC 0x34     // 模式 2：周期性产生中断
+#define PIT_CMD_LATCH 0x00        // 锁存通道 0 的当前计数
+
+// 每秒 hz 次中断时的计数初值
+uint32_t pit_period_count(uint32_t hz);
+
+// 周期模式：每 1/hz 秒产生一次中断
+void pit_set_periodic(uint32_t hz);
+
+// 单次模式：count 个输入时钟后产生一次中断（1 <= count <= PIT_MAX_COUNT）
+void pit_set_oneshot(uint32_t count);
+
+// 读取通道 0 的剩余计数
+uint32_t pit_read_count(void);
+
+// IRQ0 已经产生但尚未处理（中断关闭期间）
+bool pit_irq_pending(void);
+
+// 忙等 periods 个周期（周期模式下，不依赖中断；第一个周期可能不完整）
+void pit_wait_periods(uint32_t periods);
+
+#endif
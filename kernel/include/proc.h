@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <mm/paging.h>
+#include <mm/vmm.h>
 
 // 进程状态
 typedef enum {
@@ -21,7 +22,8 @@ typedef struct process_control_block {
     char name[32];                   // 进程名称
     uint32_t* esp;                   // 栈指针
     uint32_t* ebp;                   // 基址指针
-    page_directory_t* page_dir;      // 进程页目录
+    vm_space_t* mm;                  // 进程地址空间
+    page_directory_t* page_dir;      // 进程页目录（即 mm->page_dir）
     uint32_t priority;               // 进程优先级
     uint64_t ticks;                  // 进程运行时间片
     struct process_control_block* next;  // 下一个进程（用于链表）
@@ -0,0 +1,156 @@
+#ifndef PROC_SCHED_H
+#define PROC_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <rbtree.h>
+#include <spinlock.h>
+#include <proc/task.h>
+
+// 调度策略（每个进程一个，决定由哪个调度类管理）
+#define SCHED_PRIO 0              // 固定优先级 + 同优先级轮转（默认）
+#define SCHED_FAIR 1              // 按权重分享处理器时间（vruntime）
+#define SCHED_NR_POLICIES 2
+
+// nice 值范围，nice 0 对应权重 1024
+#define NICE_MIN (-20)
+#define NICE_MAX 19
+#define NICE_0_LOAD 1024
+
+// 公平调度参数（微秒）
+#define SCHED_TICK_US (1000000 / TIMER_HZ)       // 一个时钟滴答
+#define SCHED_LATENCY_US 60000                   // 调度周期：每个就绪进程在周期内至少运行一次
+#define SCHED_MIN_GRANULARITY_US 10000           // 被选中后至少运行的时间
+#define SCHED_WAKEUP_GRANULARITY_US 10000        // 被唤醒进程领先超过该值才抢占当前进程
+
+// 负载均衡：空闲处理器从最忙的就绪队列窃取进程
+#define SCHED_MIGRATION_COST_TICKS 2             // 最近这么多滴答内运行过的进程视为缓存热，不迁移
+#define SCHED_CACHE_NICE_TRIES 3                 // 连续这么多次只找到缓存热的进程后不再顾及缓存
+
+// 入队标志
+#define ENQUEUE_WAKEUP 0x1        // 阻塞后被唤醒（公平调度类限制睡眠期间积累的补偿）
+
+// 单个优先级的就绪链表（先进先出：入队到队尾，从队首取出）
+typedef struct {
+    task_t* head;
+    task_t* tail;
+    uint32_t count;
+} run_list_t;
+
+// 优先级调度类的队列：每个优先级一个链表，位图第 n 位表示优先级 n 的链表非空
+typedef struct {
+    uint16_t bitmap;
+    uint32_t nr_ready;
+    run_list_t lists[MAX_PRIORITY];
+} prio_rq_t;
+
+// 公平调度类的队列：就绪进程按 vruntime 排列在红黑树中，最左节点单独缓存
+typedef struct {
+    rb_root_t tasks;
+    task_t* leftmost;             // vruntime 最小的就绪进程
+    task_t* curr;                 // 正在运行的公平调度进程（不在树中）
+    uint32_t min_vruntime;        // 单调递增的 vruntime 下限，用于放置新进程和被唤醒的进程
+    uint32_t load;                // 树中进程的权重之和
+    uint32_t nr_ready;
+} fair_rq_t;
+
+// 就绪队列：处于 TASK_READY 状态的进程都在队列中，正在运行的进程不在队列中
+// 每个处理器一个，由 lock 保护（其他处理器唤醒进程时也会访问）
+typedef struct {
+    uint32_t nr_ready;            // 所有调度类的就绪进程数
+    prio_rq_t prio;
+    fair_rq_t fair;
+    
+    spinlock_t lock;
+    uint32_t cpu;                 // 所属处理器
+    task_t* curr;                 // 正在运行的进程
+    task_t* idle;                 // 本处理器的空闲进程（从不入队）
+    task_t* prev;                 // 刚被换下、上下文可能尚未保存完的进程
+    bool need_resched;            // 被唤醒的进程应抢占当前进程
+    uint32_t busy_ticks;          // 运行非空闲进程的时钟滴答数
+    uint32_t idle_ticks;          // 运行空闲进程的时钟滴答数
+    uint32_t context_switches;    // 上下文切换次数
+    
+    // 负载均衡（由本处理器的空闲进程在持有本队列的锁时更新，nr_stolen 由窃取者持有本队列的锁时更新）
+    uint32_t next_balance;        // 窃取失败后下次重试的时钟（rq 时钟，见 sched.c）
+    uint32_t balance_failed;      // 连续因进程缓存热而放弃窃取的次数
+    uint32_t nr_steals;           // 从其他处理器窃取的进程数
+    uint32_t nr_stolen;           // 被其他处理器窃取的进程数
+    uint32_t hot_skips;           // 因缓存热而跳过的进程数
+    
+    // AP 空闲时停止本地 APIC 定时器的周期滴答（由本处理器在关中断时访问；BSP 停止的是 PIT，见 sched.c）
+    bool lapic_stopped;           // 本地 APIC 定时器处于单次模式
+    uint32_t lapic_programmed;    // 停止滴答时设定的单次计数
+    uint32_t lapic_residual;      // 补记后不足一个滴答的计数
+} runqueue_t;
+
+// 窃取时判断就绪进程能否迁移
+typedef bool (*sched_steal_filter_t)(task_t* task, void* arg);
+
+// 调度类接口：调用者持有就绪队列的锁（私有队列只需关中断）
+// 选择下一个进程时按 sched_classes 的顺序询问，前面的调度类有就绪进程时总是优先
+typedef struct sched_class {
+    const char* name;
+
+    // 进程加入/移出就绪队列（flags 为 ENQUEUE_*）
+    void (*enqueue)(runqueue_t* rq, task_t* task, int flags);
+    void (*dequeue)(runqueue_t* rq, task_t* task);
+
+    // 取出下一个要运行的进程，没有就绪进程时返回 NULL
+    task_t* (*pick_next)(runqueue_t* rq);
+
+    // 正在运行的进程被换下（仍可运行时随后重新入队）
+    void (*put_prev)(runqueue_t* rq, task_t* task);
+
+    // 时钟滴答，返回 true 表示应抢占当前进程
+    bool (*tick)(runqueue_t* rq, task_t* curr);
+
+    // 同一调度类的进程被唤醒，返回 true 表示应抢占当前进程
+    bool (*check_preempt)(runqueue_t* rq, task_t* curr, task_t* woken);
+
+    // 进程刚切换到该调度类（尚未入队），初始化调度类私有的状态
+    void (*switched_to)(runqueue_t* rq, task_t* task);
+
+    // 选出一个可以被其他处理器窃取的就绪进程（不移出队列），优先选择在本队列中最晚才会运行的进程
+    task_t* (*steal)(runqueue_t* rq, sched_steal_filter_t filter, void* arg);
+
+    // 已移出 src 的进程即将加入另一个处理器的 dst，换算调度类私有的相对状态（可为 NULL）
+    void (*migrate)(runqueue_t* src, runqueue_t* dst, task_t* task);
+
+    // 正在运行的进程改由该调度类管理（不入队），记录为调度类的当前进程（可为 NULL）
+    void (*set_curr)(runqueue_t* rq, task_t* task);
+} sched_class_t;
+
+extern const sched_class_t prio_sched_class;
+extern const sched_class_t fair_sched_class;
+
+// 进程所属的调度类
+const sched_class_t* task_sched_class(const task_t* task);
+
+// 就绪队列操作（按进程的调度类分派，调用者持有 rq->lock）
+void rq_init(runqueue_t* rq);
+void rq_enqueue(runqueue_t* rq, task_t* task, int flags);  // 入队后状态为 TASK_READY
+void rq_dequeue(runqueue_t* rq, task_t* task);
+task_t* rq_pick_next(runqueue_t* rq);   // 取出下一个进程，队列为空时返回 NULL
+
+// nice 值对应的权重
+uint32_t sched_nice_to_weight(int nice);
+
+// 设置进程的调度策略和 nice 值，成功返回 0，参数无效返回 -1
+int sched_setscheduler(task_t* task, uint32_t policy, int nice);
+
+// 调度策略名称（"prio" / "fair"）
+const char* sched_policy_name(uint32_t policy);
+
+// 多处理器：AP 的空闲进程栈（启动代码直接使用），AP 进入调度器（不返回）
+uint32_t sched_idle_stack_top(uint32_t cpu);
+void sched_ap_start(uint32_t lapic_ticks);
+
+// AP 的本地 APIC 定时器中断和重新调度 IPI（由汇编包装函数调用）
+void sched_lapic_tick(void);
+void sched_resched_ipi(void);
+
+// 切换完成后调用：换下的进程的上下文已经保存
+void finish_task_switch(void);
+
+#endif // PROC_SCHED_H
@@ -0,0 +1,84 @@
+#ifndef PROC_SMP_H
+#define PROC_SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 多处理器：从 ACPI MADT（或 MP 配置表）枚举处理器，BSP 通过 INIT-SIPI-SIPI 启动其余处理器（AP）
+// 每个处理器有自己的 GDT、TSS、空闲进程和就绪队列，各自独立调度
+#define MAX_CPUS 8
+
+// AP 启动代码的物理地址（1MB 以下、页对齐，SIPI 向量为其页号）
+#define TRAMPOLINE_BASE 0x8000
+
+// GDT 布局（每个处理器一份，选择子在所有处理器上相同）
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_PERCPU 0x18           // 基址为本处理器的 cpu_t，gs 始终装入该选择子
+#define GDT_TSS 0x20
+#define GDT_ENTRIES 5
+
+// 任务状态段（只使用 ss0/esp0：特权级切换时使用的内核栈）
+typedef struct {
+    uint32_t prev_tss;
+    uint32_t esp0, ss0, esp1, ss1, esp2, ss2;
+    uint32_t cr3, eip, eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs, ldt;
+    uint16_t trap, iomap_base;
+} __attribute__((packed)) tss_t;
+
+// 每处理器数据：通过 gs 段访问，self 必须是第一个字段
+typedef struct cpu {
+    struct cpu* self;
+    uint32_t id;                  // 逻辑编号（BSP 为 0），即就绪队列的下标
+    uint32_t apic_id;             // 本地 APIC ID
+    volatile bool online;         // 已进入调度器
+    uint64_t gdt[GDT_ENTRIES];
+    tss_t tss;
+} cpu_t;
+
+// 当前处理器（调用者关中断或关抢占，否则读到后可能被迁移到其他处理器）
+static inline cpu_t* this_cpu(void)
+{
+    cpu_t* cpu;
+    asm("mov %%gs:0, %0" : "=r" (cpu));
+    return cpu;
+}
+
+static inline uint32_t smp_processor_id(void)
+{
+    return this_cpu()->id;
+}
+
+// 装入 BSP 的 GDT 和 TSS，之后才能使用 this_cpu 和 current_task（内核入口最先调用）
+void smp_early_init(void);
+
+// 枚举处理器、开启本地 APIC 并启动所有 AP（需要分页、内核堆和调度器已初始化）
+void smp_init(void);
+
+// 处理器信息
+uint32_t smp_num_cpus(void);
+bool smp_cpu_online(uint32_t id);
+cpu_t* smp_cpu(uint32_t id);
+
+// 新进程切换进来时更新特权级切换使用的内核栈
+void smp_set_kernel_stack(uint32_t esp0);
+
+// 通知处理器重新调度（唤醒停机中的空闲处理器）
+void smp_send_resched(uint32_t id);
+
+// TLB 击落：让其他在线处理器刷新内核地址范围 [start, end) 的 TLB 项，返回时均已确认
+// 内核映射在所有处理器间共享，取消或替换映射后须在帧被重新使用前调用
+// 调用者须开中断且不持有任何自旋锁：其他处理器在调用者持有的锁上关中断自旋时无法确认，双方都不能继续
+// （有其他处理器在线时断言中断已开启）
+void smp_tlb_shootdown(uint32_t start, uint32_t end);
+
+// 处理发给本处理器、尚未处理的刷新请求（关中断调用）
+// 关中断等待其他处理器的进程须在等待循环中调用，否则正在发起击落的一方等不到本处理器的确认
+void smp_tlb_shootdown_poll(void);
+
+// TLB 击落 IPI 的处理函数（由汇编包装函数调用）
+void smp_tlb_shootdown_ipi(void);
+
+#endif // PROC_SMP_H
@@ -2,7 +2,12 @@
 #define PROC_TASK_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <mm/paging.h>
+#include <mm/vmm.h>
+#include <mm/scratch.h>
+#include <rbtree.h>
+#include <proc/wait.h>
 
 // 进程状态枚举
 typedef enum {
@@ -20,13 +25,14 @@ typedef struct {
 } regs_context_t;
 
 // 进程控制块（PCB）
+// 注意：switch.asm 按固定偏移访问 page_dir 和 regs，新字段请添加在结构体末尾
 typedef struct task {
     uint32_t pid;                    // 进程ID
     task_state_t state;              // 状态
     uint32_t priority;               // 优先级（0-15）
     
     // 内存管理集成点（关键！）
-    page_directory_t* page_dir;      // 页目录指针（利用现有内存保护）
+    page_directory_t* page_dir;      // 页目录指针（即 mm->page_dir，供 switch.asm 使用）
     uint32_t kernel_stack_top;       // 内核栈顶
     uint32_t user_stack_top;         // 用户栈顶
     uint32_t heap_start;             // 堆起始地址
@@ -48,20 +54,122 @@ typedef struct task {
     // 资源统计（为AI监控准备）
     uint32_t memory_usage_kb;        // 内存使用（KB）
     char name[32];                   // 进程名
+    
+    vm_space_t* mm;                  // 地址空间
+    scratch_arena_t scratch;         // 系统调用临时区（系统调用返回时重置）
+    
+    struct task* rq_next;            // 就绪队列中的下一个进程
+    struct task* rq_prev;            // 就绪队列中的上一个进程
+    struct task* task_next;          // 全局进程链表（包括阻塞和僵尸进程）
+    
+    uint32_t policy;                 // 调度策略（SCHED_PRIO / SCHED_FAIR，见 proc/sched.h）
+    int nice;                        // nice 值（-20 ~ 19，公平调度类按其换算权重）
+    uint32_t weight;                 // 公平调度权重（nice 0 为 1024）
+    uint32_t vruntime;               // 加权虚拟运行时间（微秒，允许回绕）
+    uint32_t slice_start;            // 本次被选中运行时的 total_runtime
+    rb_node_t rb_node;               // 公平调度类红黑树节点
+    
+    int exit_code;                   // 退出码（僵尸进程由父进程读取）
+    wait_queue_t child_exit;         // 等待子进程退出的队列（本进程是等待者）
+    
+    uint32_t cpu;                    // 所在处理器（就绪队列的下标）
+    volatile bool on_cpu;            // 正在运行或上下文尚未保存完，不能回收
+    uint32_t last_ran;               // 最近一次被换下时所在处理器的 rq_clock（该处理器的忙碌加空闲滴答，判断缓存是否仍热）
+    uint32_t nr_migrations;          // 被迁移到其他处理器的次数
+    volatile bool killed;            // 已被终止，在下一个安全点自行退出
+    uint32_t usage;                  // 引用计数（进程链表持有一个，find_task 的调用者各持有一个；受 tasklist_lock 保护）
 } task_t;
 
 // 最大优先级
 #define MAX_PRIORITY 16
 
-// 全局变量声明
-extern task_t* current_task;
+// 时钟中断频率（每秒的时钟滴答数）
+#define TIMER_HZ 100
+
+// 负载均值的定点小数位数
+#define LOAD_FSHIFT 11
+
+// 调度统计
+typedef struct {
+    uint32_t load_avg[3];         // 1、5、15 分钟负载均值（定点数，低 LOAD_FSHIFT 位为小数）
+    uint32_t nr_running;          // 可运行进程数（就绪进程加上正在运行的非空闲进程）
+    uint32_t nr_tasks;            // 未退出的进程数（包括空闲进程）
+    uint32_t busy_ticks;          // 运行非空闲进程的时钟滴答数
+    uint32_t idle_ticks;          // 运行空闲进程的时钟滴答数
+    uint32_t context_switches;    // 上下文切换次数
+    uint32_t timer_interrupts;    // 实际发生的时钟中断次数
+    uint32_t nohz_ticks;          // 空闲时停止时钟滴答、醒来后补记的滴答数
+    uint32_t last_pid;            // 最近分配的 PID
+    uint32_t nr_cpus;             // 在线处理器数
+    uint32_t nr_migrations;       // 负载均衡迁移的进程数
+} sched_stats_t;
+
+// 单个处理器的调度统计
+typedef struct {
+    uint32_t nr_running;          // 就绪进程加上正在运行的非空闲进程
+    uint32_t busy_ticks;
+    uint32_t idle_ticks;
+    uint32_t context_switches;
+    uint32_t curr_pid;            // 正在运行的进程
+    uint32_t nr_steals;           // 从其他处理器窃取的进程数
+    uint32_t nr_stolen;           // 被其他处理器窃取的进程数
+    uint32_t hot_skips;           // 因缓存热而跳过的进程数
+} sched_cpu_stats_t;
+
+// 当前处理器上正在运行的进程
+#define current_task (get_current_task())
 
 // 进程管理函数声明
 void sched_init(void);
 task_t* create_task(void (*entry)(void), const char* name, uint32_t priority);
+
+// 分两步创建：create_task_stopped 只分配和初始化（尚无 PID，不在进程链表和就绪队列中），
+// 调用者补充设置（如 fork 复制寄存器和地址空间）后由 sched_wake_up_new 发布
+task_t* create_task_stopped(void (*entry)(void), const char* name, uint32_t priority);
+void sched_wake_up_new(task_t* task);
 void schedule(void);
 void switch_to(task_t* old_task, task_t* new_task);
+void task_entry_stub(void);      // 新进程的起点：调用 finish_task_switch 和 regs.ebx 中的入口函数
 void task_exit(int status);
 task_t* get_current_task(void);
 
+// 终止进程：设置标记并唤醒，进程在下一个安全点（等待结束、睡眠返回、系统调用返回、时钟滴答）自行退出
+// 这样它挂在等待队列或时间轮上的栈上对象由它自己摘除，退出码、父进程通知和地址空间与正常退出相同
+bool sched_kill(task_t* task);
+
+// 当前进程已被终止时退出（不返回），否则直接返回
+void sched_exit_if_killed(void);
+
+uint32_t get_system_ticks(void);
+
+// 将进程放入/移出所在处理器的就绪队列（内部加锁），入队后状态为 TASK_READY
+// 入队视为唤醒：优先于当前进程时在下一个时钟滴答抢占
+void sched_enqueue(task_t* task);
+void sched_dequeue(task_t* task);
+
+// 唤醒阻塞的进程（可在中断处理函数中调用），进程不处于阻塞状态时返回 false
+bool sched_wakeup(task_t* task);
+
+// 在所在处理器的 rq->lock 下设置当前进程的状态（与 sched_wakeup、schedule 和负载均衡互斥）
+void set_current_state(task_state_t state);
+
+// 按 PID 查找进程并持有一个引用，用完后调用 task_put（进程可能同时被回收）
+task_t* find_task(uint32_t pid);
+void task_put(task_t* task);
+
+// 在 tasklist_lock 下对每个进程（包括阻塞和僵尸进程）调用 fn，fn 不能睡眠
+void sched_for_each_task(void (*fn)(task_t* task, void* arg), void* arg);
+
+// 查找子进程（pid 不大于 0 时匹配任意子进程，zombie 为 true 时只匹配已退出的子进程）
+task_t* sched_find_child(task_t* parent, int pid, bool zombie);
+
+// 回收已退出的进程（移出进程链表，最后一个引用释放时释放进程控制块和内核栈）
+void sched_reap(task_t* task);
+
+// 获取负载均值和处理器时间统计
+void sched_get_stats(sched_stats_t* stats);
+
+// 获取单个处理器的调度统计，处理器不在线时返回 false
+bool sched_get_cpu_stats(uint32_t cpu, sched_cpu_stats_t* stats);
+
 #endif // PROC_TASK_H
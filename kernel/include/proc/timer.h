@@ -0,0 +1,70 @@
+#ifndef PROC_TIMER_H
+#define PROC_TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 分层时间轮：定时器按到期时间与当前时间的距离放入不同层的槽中
+// 第 0 层 256 个槽，每槽一个时钟滴答；之后 4 层各 64 个槽，每层的槽宽是上一层的 64 倍
+// 第 0 层转完一圈时把上一层的下一个槽重新分散到下层（级联），插入和取消都是 O(1)
+#define TVR_BITS 8
+#define TVN_BITS 6
+#define TVR_SIZE (1 << TVR_BITS)
+#define TVN_SIZE (1 << TVN_BITS)
+#define TVR_MASK (TVR_SIZE - 1)
+#define TVN_MASK (TVN_SIZE - 1)
+#define TVN_LEVELS 4
+
+// 双向循环链表节点（槽的表头为哨兵节点）
+typedef struct timer_link {
+    struct timer_link* next;
+    struct timer_link* prev;
+} timer_link_t;
+
+struct ktimer;
+typedef void (*ktimer_func_t)(struct ktimer* timer);
+
+// 定时器：由使用者分配（可以在栈上），到期时在时钟中断中调用 func
+typedef struct ktimer {
+    timer_link_t link;            // 所在槽的链表（未挂入时 next 为 NULL）
+    uint32_t expires;             // 到期的时钟滴答（允许回绕）
+    ktimer_func_t func;           // 到期回调（中断上下文，不能睡眠）
+    void* data;                   // 回调参数
+} ktimer_t;
+
+// 时间轮
+typedef struct {
+    uint32_t now;                 // 下一个要处理的时钟滴答
+    uint32_t pending;             // 挂入的定时器数
+    timer_link_t tv1[TVR_SIZE];
+    timer_link_t tvn[TVN_LEVELS][TVN_SIZE];
+} timer_wheel_t;
+
+// 时间轮操作（调用者负责关中断）
+void timer_wheel_init(timer_wheel_t* wheel, uint32_t now);
+void timer_wheel_add(timer_wheel_t* wheel, ktimer_t* timer);
+void timer_wheel_cancel(timer_wheel_t* wheel, ktimer_t* timer);
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint32_t now);   // 处理到 now 为止到期的定时器，返回回调次数
+uint32_t timer_wheel_next(const timer_wheel_t* wheel, uint32_t limit);  // 距下一个可能到期的滴答数，最多 limit
+
+// 初始化定时器
+void timer_setup(ktimer_t* timer, ktimer_func_t func, void* data);
+
+// 定时器是否已挂入时间轮
+static inline bool timer_pending(const ktimer_t* timer)
+{
+    return timer->link.next != NULL;
+}
+
+// 系统时间轮（由时钟中断推进，内部关中断）
+void timer_init(void);
+void timer_add(ktimer_t* timer, uint32_t expires);    // 在时钟滴答 expires 到期；已挂入时先取消
+bool timer_cancel(ktimer_t* timer);                   // 返回定时器是否仍未到期
+void timer_run(uint32_t now);                         // 时钟中断中调用
+uint32_t timer_next_event(uint32_t limit);            // 距下一个定时器到期的滴答数，最多 limit
+
+// 当前进程睡眠 ticks 个时钟滴答（期间不占用处理器），返回提前被唤醒时剩余的滴答数
+uint32_t timer_sleep(uint32_t ticks);
+
+#endif // PROC_TIMER_H
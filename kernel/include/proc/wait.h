@@ -0,0 +1,83 @@
+#ifndef PROC_WAIT_H
+#define PROC_WAIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <proc/timer.h>
+
+// 等待队列：等待某个条件的进程挂在队列上并阻塞，条件可能成立时由唤醒者（通常是中断处理函数）唤醒
+// 被唤醒的等待项自动移出队列，进程醒来后重新检查条件，条件仍不成立时再次入队
+// 独占等待项排在队尾，wake_up 唤醒所有非独占等待项和一个独占等待项，避免惊群
+
+struct task;
+
+// 等待项标志
+#define WAIT_EXCLUSIVE 0x1        // 独占等待
+#define WAIT_TIMEOUT 0x2          // 带超时（内部使用）
+
+// 等待项（通常位于等待者的栈上）
+typedef struct wait_entry {
+    struct wait_entry* next;
+    struct wait_entry* prev;
+    struct task* task;            // 等待的进程（不能阻塞时为 NULL，改为停机等待中断）
+    uint32_t flags;
+    bool queued;                  // 是否在等待队列中
+    uint32_t irq_flags;           // 等待开始前的 EFLAGS
+    uint32_t expires;             // 超时的时钟滴答
+    ktimer_t timer;               // 超时定时器
+} wait_entry_t;
+
+// 等待队列（全零即为空队列，可以静态定义）
+typedef struct {
+    wait_entry_t* head;
+    wait_entry_t* tail;
+} wait_queue_t;
+
+void wait_queue_init(wait_queue_t* wq);
+bool wait_queue_active(const wait_queue_t* wq);
+
+// 等待项入队/出队（入队按 flags 决定放在队首还是队尾）
+void wait_queue_add(wait_queue_t* wq, wait_entry_t* entry);
+void wait_queue_remove(wait_queue_t* wq, wait_entry_t* entry);
+
+// 唤醒：nr_exclusive 为最多唤醒的独占等待项数，0 表示全部唤醒；返回被唤醒的进程数
+uint32_t wake_up_nr(wait_queue_t* wq, uint32_t nr_exclusive);
+uint32_t wake_up(wait_queue_t* wq);
+uint32_t wake_up_all(wait_queue_t* wq);
+
+// 等待的各个步骤（由下面的宏使用）：begin 关中断并准备等待项，end 恢复中断
+void wait_begin(wait_entry_t* entry, uint32_t flags, uint32_t timeout);
+void prepare_to_wait(wait_queue_t* wq, wait_entry_t* entry);
+void wait_schedule(wait_entry_t* entry);
+bool wait_timed_out(const wait_entry_t* entry);
+bool wait_killed(const wait_entry_t* entry);
+uint32_t wait_end(wait_queue_t* wq, wait_entry_t* entry, bool done);
+
+// 等待直到 condition 成立；先入队并标记阻塞再检查条件，其他处理器上的唤醒不会丢失
+// 进程被终止时停止等待，wait_end 摘除等待项和定时器后让进程退出，不返回调用者
+// 返回值：条件成立时为剩余的滴答数（至少为 1，无超时时为 1），超时为 0
+#define __wait_event(wq, condition, flags, timeout) ({                  \
+    wait_entry_t __wait;                                                \
+    bool __done;                                                        \
+    wait_begin(&__wait, (flags), (timeout));                            \
+    for (;;) {                                                          \
+        prepare_to_wait(&(wq), &__wait);                                \
+        if ((__done = (condition)) || wait_timed_out(&__wait) ||        \
+            wait_killed(&__wait)) {                                     \
+            break;                                                      \
+        }                                                               \
+        wait_schedule(&__wait);                                         \
+    }                                                                   \
+    wait_end(&(wq), &__wait, __done);                                   \
+})
+
+#define wait_event(wq, condition) \
+    ((void)__wait_event(wq, condition, 0, 0))
+
+#define wait_event_exclusive(wq, condition) \
+    ((void)__wait_event(wq, condition, WAIT_EXCLUSIVE, 0))
+
+#define wait_event_timeout(wq, condition, ticks) \
+    __wait_event(wq, condition, WAIT_TIMEOUT, ticks)
+
+#endif // PROC_WAIT_H
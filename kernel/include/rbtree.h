@@ -0,0 +1,49 @@
+#ifndef _RBTREE_H_
+#define _RBTREE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 红黑树（侵入式）：节点嵌入在使用者的结构体中，由使用者负责比较和查找插入位置
+#define RB_RED 0
+#define RB_BLACK 1
+
+typedef struct rb_node {
+    struct rb_node* parent;
+    struct rb_node* left;
+    struct rb_node* right;
+    int color;
+} rb_node_t;
+
+typedef struct {
+    rb_node_t* node;
+} rb_root_t;
+
+// 由节点地址得到包含它的结构体
+#define rb_entry(ptr, type, member) ((type*)((char*)(ptr) - offsetof(type, member)))
+
+// 将节点挂到查找得到的位置（*link 为 parent 的左或右子指针），之后须调用 rb_insert_color
+static inline void rb_link_node(rb_node_t* node, rb_node_t* parent, rb_node_t** link)
+{
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->color = RB_RED;
+    *link = node;
+}
+
+// 插入后重新平衡
+void rb_insert_color(rb_node_t* node, rb_root_t* root);
+
+// 删除节点
+void rb_erase(rb_node_t* node, rb_root_t* root);
+
+// 最小节点和中序后继，不存在时返回 NULL
+rb_node_t* rb_first(const rb_root_t* root);
+rb_node_t* rb_next(const rb_node_t* node);
+
+// 最大节点和中序前驱，不存在时返回 NULL
+rb_node_t* rb_last(const rb_root_t* root);
+rb_node_t* rb_prev(const rb_node_t* node);
+
+#endif
@@ -12,11 +12,15 @@
 #define SERIAL_DATA_READY 0x01
 #define SERIAL_TRANSMITTER_EMPTY 0x20
 
+#define SERIAL_BUFFER_SIZE 256
+
 void serial_init(void);
 void serial_write_char(char c);
 void serial_write_string(const char* str);
 bool serial_can_read(void);
 char serial_read_char(void);
 bool serial_received(void);
+bool serial_wait(uint32_t timeout_ticks);
+void serial_irq(void);
 
 #endif
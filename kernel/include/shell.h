@@ -6,6 +6,10 @@
 #define SHELL_BUFFER_SIZE 256
 #define SHELL_MAX_ARGS 16
 
+// ai 命令等待回复的超时（时钟滴答）：首个字符 30 秒，后续字符之间 5 秒
+#define AI_RESPONSE_TIMEOUT (30 * TIMER_HZ)
+#define AI_CHAR_TIMEOUT (5 * TIMER_HZ)
+
 typedef struct {
     char* name;
     void (*func)(int argc, char** argv);
@@ -24,6 +28,10 @@ void shell_cmd_version(int argc, char** argv);
 void shell_cmd_ai(int argc, char** argv);
 void shell_cmd_ps(int argc, char** argv);
 void shell_cmd_free(int argc, char** argv);
+void shell_cmd_slabinfo(int argc, char** argv);
+void shell_cmd_kheapprof(int argc, char** argv);
 void shell_cmd_top(int argc, char** argv);
+void shell_cmd_setsched(int argc, char** argv);
+void shell_cmd_bench(int argc, char** argv);
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 自旋锁：处理器之间互斥，持有期间不能阻塞或调度
+// 中断处理函数也会获取的锁必须使用 irqsave 版本，否则同一处理器上的中断会在锁上自旋而死锁
+typedef struct {
+    volatile uint32_t locked;
+} spinlock_t;
+
+#define SPINLOCK_INIT {0}
+
+static inline void spin_lock_init(spinlock_t* lock)
+{
+    lock->locked = 0;
+}
+
+// 尝试获取锁（xchg 隐含 lock 前缀）
+static inline bool spin_trylock(spinlock_t* lock)
+{
+    uint32_t old = 1;
+    asm volatile("xchg %0, %1" : "+r" (old), "+m" (lock->locked) : : "memory");
+    return old == 0;
+}
+
+// 获取锁：等待期间只读不写，避免缓存行在处理器之间来回传递
+static inline void spin_lock(spinlock_t* lock)
+{
+    while (!spin_trylock(lock)) {
+        while (lock->locked) {
+            asm volatile("pause");
+        }
+    }
+}
+
+// 释放锁：x86 的写操作不会越过之前的读写，只需编译器屏障
+static inline void spin_unlock(spinlock_t* lock)
+{
+    asm volatile("" : : : "memory");
+    lock->locked = 0;
+}
+
+// 关中断并获取锁，返回之前的 EFLAGS
+static inline uint32_t spin_lock_irqsave(spinlock_t* lock)
+{
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    spin_lock(lock);
+    return flags;
+}
+
+// 释放锁并恢复 EFLAGS
+static inline void spin_unlock_irqrestore(spinlock_t* lock, uint32_t flags)
+{
+    spin_unlock(lock);
+    asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
+#endif // SPINLOCK_H
@@ -17,7 +17,16 @@ enum syscall_num {
     SYS_munmap = 8,
     SYS_sbrk = 9,
     SYS_sleep = 10,
-    SYS_execve = 11
+    SYS_execve = 11,
+    SYS_nanosleep = 12
+};
+
+// nanosleep 的时间参数
+#define NSEC_PER_SEC 1000000000
+
+struct timespec {
+    uint32_t tv_sec;
+    uint32_t tv_nsec;             // 0 ~ NSEC_PER_SEC - 1
 };
 
 // 系统调用处理函数类型
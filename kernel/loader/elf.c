@@ -2,9 +2,12 @@
 #include <fs/vfs.h>
 #include <mm/kheap.h>
 #include <mm/paging.h>
+#include <mm/vmalloc.h>
+#include <mm/vmm.h>
 #include <proc/task.h>
 #include <vga.h>
 #include <string.h>
+#include <common.h>
 
 // 读取文件内容
 static ssize_t read_file(inode_t* inode, void* buf, size_t count, off_t offset) {
@@ -43,8 +46,25 @@ static int elf_validate_header(elf32_ehdr_t* ehdr) {
     return 0;
 }
 
-// 加载ELF段到内存
-static int elf_load_segment(elf32_phdr_t* phdr, inode_t* inode) {
+// 段的最后一页可能与下一个段共用，它的区域推迟到下一个段合并权限之后再登记
+typedef struct {
+    uint32_t addr;        // 挂起的页地址，0 表示没有
+    uint32_t vm_flags;    // 已覆盖该页的各段权限的并集
+} elf_tail_t;
+
+// 登记挂起的末页区域
+static int elf_flush_tail(vm_space_t* space, elf_tail_t* tail) {
+    if (tail->addr == 0) {
+        return 0;
+    }
+    
+    int ret = vm_area_map(space, tail->addr, tail->addr + PAGE_SIZE, tail->vm_flags);
+    tail->addr = 0;
+    return ret;
+}
+
+// 加载ELF段到当前地址空间
+static int elf_load_segment(elf32_phdr_t* phdr, inode_t* inode, elf_tail_t* tail) {
     // 检查段类型（只处理可加载段）
     if (phdr->p_type != PT_LOAD) {
         return 0;
@@ -56,31 +76,86 @@ static int elf_load_segment(elf32_phdr_t* phdr, inode_t* inode) {
         return 0;
     }
     
-    // 分配内存（使用kmalloc）
-    void* mem = kmalloc(mem_size);
-    if (!mem) {
+    uint32_t start = ALIGN_DOWN(phdr->p_vaddr, PAGE_SIZE);
+    uint32_t end = ALIGN_UP(phdr->p_vaddr + mem_size, PAGE_SIZE);
+    if (phdr->p_filesz > mem_size || start < USER_SPACE_START || end > USER_SPACE_END || end <= start) {
+        kprintf("[ELF] Invalid segment at 0x%x (size %d)\n", phdr->p_vaddr, mem_size);
+        return -1;
+    }
+    
+    // 段内容先读入页对齐的暂存区（每页对应一个用户页），不占用内核堆
+    uint8_t* stage = (uint8_t*)vmalloc(end - start);
+    if (!stage) {
         kprintf("[ELF] Failed to allocate memory for segment\n");
         return -1;
     }
     
-    // 读取段内容
+    // 清零后读取段内容，文件中没有的部分（.bss段）保持为零
+    memset(stage, 0, end - start);
     if (phdr->p_filesz > 0) {
-        ssize_t bytes_read = read_file(inode, mem, phdr->p_filesz, phdr->p_offset);
+        ssize_t bytes_read = read_file(inode, stage + (phdr->p_vaddr - start), phdr->p_filesz, phdr->p_offset);
         if (bytes_read != phdr->p_filesz) {
             kprintf("[ELF] Failed to read segment data\n");
-            kfree(mem);
+            vfree(stage);
             return -1;
         }
     }
     
-    // 初始化未初始化的数据（.bss段）
-    if (phdr->p_filesz < phdr->p_memsz) {
-        memset(mem + phdr->p_filesz, 0, phdr->p_memsz - phdr->p_filesz);
+    uint32_t page_flags = PAGE_PRESENT | PAGE_USER;
+    uint32_t vm_flags = VM_READ;
+    if (phdr->p_flags & PF_W) {
+        page_flags |= PAGE_WRITABLE;
+        vm_flags |= VM_WRITE;
+    }
+    if (phdr->p_flags & PF_X) {
+        vm_flags |= VM_EXEC;
     }
     
-    // 映射内存到进程的虚拟地址空间
-    // 简化实现：直接使用物理地址作为虚拟地址（实际系统中需要使用页表映射）
-    current_task->page_dir->tables[phdr->p_vaddr / (1024 * 1024)] = (page_table_t*)mem;
+    // 将暂存区的帧直接映射到用户地址，不再复制
+    vm_space_t* space = vm_space_current();
+    for (uint32_t addr = start; addr < end; addr += PAGE_SIZE) {
+        uint8_t* src = stage + (addr - start);
+        page_entry_t* pte = paging_get_pte((void*)addr);
+        
+        if (pte && (*pte & PAGE_PRESENT)) {
+            // 与前一个段共用的页：只复制本段覆盖的部分，页权限取两个段的并集
+            uint32_t from = MAX(addr, phdr->p_vaddr);
+            uint32_t to = MIN(addr + PAGE_SIZE, phdr->p_vaddr + mem_size);
+            uint8_t* dst = (uint8_t*)kmap_temp(*pte & PAGE_FRAME_MASK);
+            memcpy(dst + (from - addr), src + (from - addr), to - from);
+            kunmap_temp();
+            
+            if ((page_flags & PAGE_WRITABLE) && !(*pte & PAGE_WRITABLE)) {
+                *pte |= PAGE_WRITABLE;
+                tlb_flush_page((void*)addr);
+            }
+            continue;
+        }
+        
+        // 暂存区释放时只减少引用计数，帧留给用户页
+        uint32_t phys = get_physical_addr(src);
+        frame_ref(phys / PAGE_SIZE);
+        map_page((void*)addr, phys, page_flags);
+        space->rss_pages++;
+    }
+    vfree(stage);
+    
+    // 登记虚拟内存区域：与前一个段共用的首页并入挂起的末页，本段的末页挂起等待下一个段
+    uint32_t area_start = start;
+    if (tail->addr == start) {
+        tail->vm_flags |= vm_flags;
+        area_start = start + PAGE_SIZE;
+    }
+    if (area_start < end) {
+        uint32_t last = end - PAGE_SIZE;
+        if (elf_flush_tail(space, tail) < 0 ||
+            (area_start < last && vm_area_map(space, area_start, last, vm_flags) < 0)) {
+            kprintf("[ELF] Segment at 0x%x overlaps an existing area\n", phdr->p_vaddr);
+            return -1;
+        }
+        tail->addr = last;
+        tail->vm_flags = vm_flags;
+    }
     
     // Debug: Loaded segment at 0x%x-0x%x (flags: 0x%x)
     // kprintf("[ELF] Loaded segment at 0x%x-0x%x (flags: 0x%x)\n", 
@@ -114,8 +189,9 @@ int elf_load(const char* path, uint32_t* entry_point) {
         goto cleanup;
     }
     
-    // 读取程序头表
+    // 读取程序头表（PT_LOAD 段按地址递增排列，相邻段最多共用一页）
     elf32_phdr_t phdr;
+    elf_tail_t tail = {0, 0};
     for (int i = 0; i < ehdr.e_phnum; i++) {
         // 计算程序头偏移量
         off_t phdr_offset = ehdr.e_phoff + i * ehdr.e_phentsize;
@@ -128,11 +204,17 @@ int elf_load(const char* path, uint32_t* entry_point) {
         }
         
         // 加载段
-        if (elf_load_segment(&phdr, inode) < 0) {
+        if (elf_load_segment(&phdr, inode, &tail) < 0) {
             goto cleanup;
         }
     }
     
+    // 登记最后一个段的末页
+    if (elf_flush_tail(vm_space_current(), &tail) < 0) {
+        kprintf("[ELF] Failed to register the last segment page\n");
+        goto cleanup;
+    }
+    
     // 设置程序入口点
     *entry_point = ehdr.e_entry;
     
@@ -7,14 +7,15 @@
 #include <interrupts.h>
 #include <shell.h>
 #include <mm/paging.h>
+#include <mm/memmap.h>
+#include <mm/vmm.h>
+#include <mm/vmalloc.h>
 #include <proc.h>
+#include <proc/smp.h>
 #include <fs.h>
 
 void kernel_main(uint32_t magic, uint32_t mbi_addr)
 {
-    UNUSED(magic);
-    UNUSED(mbi_addr);
-
     vga_init();
 
     kprint("Synapse OS v");
@@ -23,6 +24,8 @@ void kernel_main(uint32_t magic, uint32_t mbi_addr)
     kprint("AI-Native Operating System\n");
     kprint("Initializing...\n");
 
+    smp_early_init();
+
     kprint("VGA driver initialized\n");
 
     keyboard_init();
@@ -31,12 +34,21 @@ void kernel_main(uint32_t magic, uint32_t mbi_addr)
     idt_init();
     kprint("IDT initialized\n");
 
+    memmap_init(magic, mbi_addr);
+    kprint("Memory map parsed\n");
+
     init_paging();
     kprint("Paging initialized\n");
 
     init_kheap();
     kprint("Kernel heap initialized\n");
 
+    vmm_init();
+    kprint("Address spaces initialized\n");
+
+    vmalloc_init();
+    kprint("Kernel virtual areas initialized\n");
+
     tasking_init();
     kprint("Process scheduling initialized\n");
 
@@ -52,6 +64,9 @@ void kernel_main(uint32_t magic, uint32_t mbi_addr)
     irq_install();
     kprint("IRQ installed\n");
 
+    smp_init();
+    kprint("Application processors started\n");
+
     kprint("System ready\n");
 
     shell_init();
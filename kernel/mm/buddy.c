@@ -0,0 +1,235 @@
+#include <mm/buddy.h>
+#include <string.h>
+#include <vga.h>
+#include <spinlock.h>
+
+// 伙伴分配器状态
+typedef struct {
+    uint32_t total_frames;                        // 管理的帧总数
+    uint32_t normal_frames;                       // NORMAL 区域的帧数
+    uint32_t free_frames[BUDDY_ZONE_COUNT];       // 每个区域的空闲帧数量
+    buddy_free_area_t free_area[BUDDY_ZONE_COUNT][BUDDY_ORDER_COUNT]; // 每区域每阶空闲链表
+} buddy_allocator_t;
+
+static buddy_allocator_t buddy = {0};
+static spinlock_t buddy_lock = SPINLOCK_INIT;     // 保护空闲链表和计数
+
+// 帧所属的区域（区域边界按最大块对齐，块不会跨越区域）
+static uint32_t zone_of(uint32_t frame)
+{
+    return frame < buddy.normal_frames ? BUDDY_ZONE_NORMAL : BUDDY_ZONE_HIGH;
+}
+
+// 将块加入对应阶的空闲链表
+static void free_list_add(uint32_t frame, uint32_t order)
+{
+    page_t* page = &mem_map[frame];
+
+    page->order = order;
+    page->flags = PG_BUDDY;
+    page_list_add(&buddy.free_area[zone_of(frame)][order].free_list, page);
+}
+
+// 将块从对应阶的空闲链表中移除
+static void free_list_remove(uint32_t frame, uint32_t order)
+{
+    page_t* page = &mem_map[frame];
+
+    page_list_remove(&buddy.free_area[zone_of(frame)][order].free_list, page);
+    page->flags = 0;
+}
+
+// 释放一个块，并与空闲的伙伴逐级合并
+static void free_block(uint32_t frame, uint32_t order)
+{
+    while (order < BUDDY_MAX_ORDER) {
+        uint32_t buddy_frame = frame ^ (1 << order);
+
+        if (buddy_frame >= buddy.total_frames) {
+            break;
+        }
+
+        page_t* page = &mem_map[buddy_frame];
+        if (!(page->flags & PG_BUDDY) || page->order != order) {
+            break;
+        }
+
+        // 伙伴空闲且阶数相同，合并为更高一阶的块
+        free_list_remove(buddy_frame, order);
+        buddy.free_area[zone_of(frame)][order].merge_count++;
+        frame &= ~(1 << order);
+        order++;
+    }
+
+    free_list_add(frame, order);
+}
+
+// 初始化伙伴分配器
+void buddy_init(uint32_t total_frames, uint32_t normal_frames)
+{
+    buddy.total_frames = total_frames;
+    buddy.normal_frames = normal_frames;
+
+    // 描述符数组初始将所有帧标记为保留，由调用者通过 buddy_free_range 释放可用区域
+    for (uint32_t zone = 0; zone < BUDDY_ZONE_COUNT; zone++) {
+        buddy.free_frames[zone] = 0;
+        for (uint32_t order = 0; order < BUDDY_ORDER_COUNT; order++) {
+            buddy_free_area_t* area = &buddy.free_area[zone][order];
+            page_list_init(&area->free_list);
+            area->alloc_count = 0;
+            area->split_count = 0;
+            area->merge_count = 0;
+        }
+    }
+}
+
+// 释放一段连续帧，按最大对齐块插入
+void buddy_free_range(uint32_t start, uint32_t count)
+{
+    uint32_t end = start + count;
+    if (end > buddy.total_frames) {
+        end = buddy.total_frames;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&buddy_lock);
+    uint32_t frame = start;
+    while (frame < end) {
+        uint32_t order = BUDDY_MAX_ORDER;
+
+        // 寻找既对齐又不越界的最大块
+        while (order > 0 && ((frame & ((1 << order) - 1)) || frame + (1 << order) > end)) {
+            order--;
+        }
+
+        for (uint32_t i = 0; i < (1U << order); i++) {
+            mem_map[frame + i].flags &= ~PG_RESERVED;
+        }
+
+        buddy.free_frames[zone_of(frame)] += 1 << order;
+        free_block(frame, order);
+        frame += 1 << order;
+    }
+    spin_unlock_irqrestore(&buddy_lock, flags);
+}
+
+// 从指定区域分配 2^order 个连续帧
+uint32_t buddy_alloc(uint32_t order, uint32_t zone)
+{
+    if (order > BUDDY_MAX_ORDER || zone >= BUDDY_ZONE_COUNT) {
+        kprintf("[BUDDY] Invalid allocation: order %d, zone %d\n", order, zone);
+        return 0;
+    }
+
+    buddy_free_area_t* areas = buddy.free_area[zone];
+    uint32_t flags = spin_lock_irqsave(&buddy_lock);
+
+    // 找到第一个有空闲块的阶
+    uint32_t current = order;
+    while (current < BUDDY_ORDER_COUNT && areas[current].free_list.head == NULL) {
+        current++;
+    }
+
+    if (current >= BUDDY_ORDER_COUNT) {
+        spin_unlock_irqrestore(&buddy_lock, flags);
+        return 0;
+    }
+
+    uint32_t frame = page_to_pfn(areas[current].free_list.head);
+    free_list_remove(frame, current);
+
+    // 逐级拆分，将后半部分放回低一阶的空闲链表
+    while (current > order) {
+        areas[current].split_count++;
+        current--;
+        free_list_add(frame + (1 << current), current);
+    }
+
+    page_t* page = &mem_map[frame];
+    page->order = order;
+    page->flags = PG_HEAD;
+    page->refcount = 1;
+    page->owner = NULL;
+    areas[order].alloc_count++;
+    buddy.free_frames[zone] -= 1 << order;
+
+    spin_unlock_irqrestore(&buddy_lock, flags);
+    return frame;
+}
+
+// 释放块
+void buddy_free(uint32_t frame, uint32_t order)
+{
+    if (frame >= buddy.total_frames || order > BUDDY_MAX_ORDER) {
+        kprintf("[BUDDY] Invalid free: frame %d, order %d\n", frame, order);
+        return;
+    }
+
+    page_t* page = &mem_map[frame];
+    if (!(page->flags & PG_HEAD)) {
+        kprintf("[BUDDY] Frame %d is not an allocated block!\n", frame);
+        return;
+    }
+
+    if (page->order != order) {
+        kprintf("[BUDDY] Order mismatch for frame %d: %d != %d\n", frame, order, page->order);
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&buddy_lock);
+    page->flags = 0;
+    page->refcount = 0;
+    page->owner = NULL;
+    buddy.free_frames[zone_of(frame)] += 1 << order;
+    free_block(frame, order);
+    spin_unlock_irqrestore(&buddy_lock, flags);
+}
+
+// 计算能容纳 count 个帧的最小阶数
+uint32_t buddy_order_for(uint32_t count)
+{
+    uint32_t order = 0;
+    while ((1U << order) < count) {
+        order++;
+    }
+    return order;
+}
+
+// 获取空闲帧数量
+uint32_t buddy_free_frames(void)
+{
+    return buddy.free_frames[BUDDY_ZONE_NORMAL] + buddy.free_frames[BUDDY_ZONE_HIGH];
+}
+
+// 获取指定区域的空闲帧数量
+uint32_t buddy_zone_free_frames(uint32_t zone)
+{
+    if (zone >= BUDDY_ZONE_COUNT) {
+        return 0;
+    }
+    return buddy.free_frames[zone];
+}
+
+// 获取指定区域、指定阶的空闲区域统计
+const buddy_free_area_t* buddy_get_free_area(uint32_t zone, uint32_t order)
+{
+    if (zone >= BUDDY_ZONE_COUNT || order > BUDDY_MAX_ORDER) {
+        return NULL;
+    }
+    return &buddy.free_area[zone][order];
+}
+
+// 打印每阶空闲块统计
+void buddy_dump(void)
+{
+    static const char* zone_names[BUDDY_ZONE_COUNT] = {"Normal", "HighMem"};
+
+    for (uint32_t zone = 0; zone < BUDDY_ZONE_COUNT; zone++) {
+        kprintf("Zone %s: %d free frames\n", zone_names[zone], buddy.free_frames[zone]);
+        kprintf("Order\tFree\tAllocs\tSplits\tMerges\n");
+        for (uint32_t order = 0; order < BUDDY_ORDER_COUNT; order++) {
+            buddy_free_area_t* area = &buddy.free_area[zone][order];
+            kprintf("%d\t%d\t%d\t%d\t%d\n", order, area->free_list.count, area->alloc_count,
+                    area->split_count, area->merge_count);
+        }
+    }
+}
@@ -1,166 +1,707 @@
+#include <mm/kheap.h>
 #include <mm/paging.h>
+#include <mm/vmalloc.h>
+#include <mm/kheapprof.h>
 #include <string.h>
+#include <common.h>
 #include <vga.h>
+#include <spinlock.h>
+#include <proc/smp.h>
+#include <proc/task.h>
+#include <interrupts.h>
 
-// 内核堆配置
-#define KHEAP_START 0xC0000000
-#define KHEAP_SIZE 0x1000000  // 16MB
+// 两级分离适配（TLSF）参数
+#define ALIGN_SIZE_LOG2 3                                  // 8 字节对齐
+#define ALIGN_SIZE (1 << ALIGN_SIZE_LOG2)
+#define SL_INDEX_COUNT_LOG2 4                              // 每个一级区间分为 16 个二级区间
+#define SL_INDEX_COUNT (1 << SL_INDEX_COUNT_LOG2)
+#define FL_INDEX_MAX 30                                    // 最大块 1GB
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE (1 << FL_INDEX_SHIFT)             // 小于 128 字节的块按 8 字节线性分级
 
-// 堆块头结构
+// 块标志（保存在 size 的低位，块大小总是 8 的倍数）
+#define BLOCK_FREE 0x1
+#define BLOCK_SAMPLED 0x2                                  // 已分配块被分析器采样
+#define BLOCK_FLAG_MASK 0x7
+
+// 堆块头结构：prev_phys 和 size 构成边界标记，空闲链表指针只在空闲块中有效
 typedef struct heap_block {
-    size_t size;              // 块大小（包括头）
-    struct heap_block* next;  // 下一个块
-    struct heap_block* prev;  // 上一个块
-    bool is_free;             // 是否空闲
+    struct heap_block* prev_phys; // 物理上相邻的前一个块（首块为 NULL）
+    size_t size;                  // 块大小（包括头），低位为 BLOCK_* 标志
+    struct heap_block* next_free; // 同一区间空闲链表中的下一个块
+    struct heap_block* prev_free; // 同一区间空闲链表中的上一个块
 } heap_block_t;
 
+// 已分配块的头部开销（空闲链表指针与用户数据重叠）
+#define BLOCK_OVERHEAD (sizeof(heap_block_t*) + sizeof(size_t))
+#define BLOCK_MIN_SIZE sizeof(heap_block_t)
+
 // 内核堆状态
 typedef struct {
-    heap_block_t* free_list;  // 空闲块链表
+    uint32_t fl_bitmap;                                    // 非空的一级区间
+    uint32_t sl_bitmap[FL_INDEX_COUNT];                    // 每个一级区间中非空的二级区间
+    heap_block_t* blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];  // 空闲链表
     void* start;              // 堆起始地址
     void* end;                // 堆结束地址
     size_t total_size;        // 总大小
     size_t used_size;         // 已使用大小
+    uint32_t free_blocks;     // 空闲块数量
+    uint32_t used_blocks;     // 已分配块数量
+    size_t peak_size;         // 堆大小的历史最高值
+    size_t peak_used;         // 已用大小的历史最高值
+    uint32_t grow_count;      // 扩展次数
+    uint32_t trim_count;      // 收缩次数
+    uint32_t realloc_inplace; // krealloc 原地完成的次数
+    uint32_t realloc_moved;   // krealloc 重新分配并复制的次数
+    uint32_t alloc_count;     // 累计分配次数
+    uint32_t free_count;      // 累计释放次数
+    bool resizing;            // 正在扩展（扩展中分配帧触发内存回收时不得收缩堆）
+    volatile bool trimming;   // 收缩掉的页正在锁外取消映射，完成前不得在原地址上扩展或再次收缩
+    task_t* trim_task;        // 正在取消映射的进程
 } kheap_t;
 
 static kheap_t kheap = {0};
 
+// 保护整个堆：公开接口加锁后调用不加锁的内部函数（关中断，中断处理函数中也可分配）
+static spinlock_t kheap_lock = SPINLOCK_INIT;
+
+// 最高/最低置位的位号（x 不为 0）
+static inline uint32_t fls(uint32_t x)
+{
+    return 31 - __builtin_clz(x);
+}
+
+static inline uint32_t ffs(uint32_t x)
+{
+    return __builtin_ctz(x);
+}
+
+// 块大小和标志
+static inline size_t block_size(heap_block_t* block)
+{
+    return block->size & ~BLOCK_FLAG_MASK;
+}
+
+static inline bool block_is_free(heap_block_t* block)
+{
+    return block->size & BLOCK_FREE;
+}
+
+static inline void block_set_size(heap_block_t* block, size_t size)
+{
+    block->size = size | (block->size & BLOCK_FLAG_MASK);
+}
+
+// 物理上相邻的下一个块（堆末尾有大小为 0 的哨兵块）
+static inline heap_block_t* block_next(heap_block_t* block)
+{
+    return (heap_block_t*)((uint8_t*)block + block_size(block));
+}
+
+// 将块大小映射到所在区间
+static void mapping_insert(size_t size, uint32_t* fl, uint32_t* sl)
+{
+    if (size < SMALL_BLOCK_SIZE) {
+        *fl = 0;
+        *sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+    } else {
+        uint32_t bit = fls(size);
+        *sl = (size >> (bit - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+        *fl = bit - (FL_INDEX_SHIFT - 1);
+    }
+}
+
+// 将请求大小向上取整到区间边界，保证该区间中任一块都能满足请求
+static void mapping_search(size_t size, uint32_t* fl, uint32_t* sl)
+{
+    if (size >= SMALL_BLOCK_SIZE) {
+        size += (1 << (fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+// 查找不小于 (fl, sl) 区间的第一个非空区间
+static heap_block_t* search_suitable_block(uint32_t* fl, uint32_t* sl)
+{
+    if (*fl >= FL_INDEX_COUNT) {
+        return NULL;
+    }
+    
+    uint32_t sl_map = kheap.sl_bitmap[*fl] & (~0U << *sl);
+    if (!sl_map) {
+        // 当前一级区间没有足够大的块，转到更大的一级区间
+        uint32_t fl_map = (*fl + 1 < 32) ? kheap.fl_bitmap & (~0U << (*fl + 1)) : 0;
+        if (!fl_map) {
+            return NULL;
+        }
+        *fl = ffs(fl_map);
+        sl_map = kheap.sl_bitmap[*fl];
+    }
+    *sl = ffs(sl_map);
+    
+    return kheap.blocks[*fl][*sl];
+}
+
+// 将空闲块加入所在区间的链表
+static void insert_free_block(heap_block_t* block)
+{
+    uint32_t fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    
+    block->next_free = kheap.blocks[fl][sl];
+    block->prev_free = NULL;
+    if (block->next_free) {
+        block->next_free->prev_free = block;
+    }
+    kheap.blocks[fl][sl] = block;
+    
+    kheap.fl_bitmap |= 1U << fl;
+    kheap.sl_bitmap[fl] |= 1U << sl;
+    kheap.free_blocks++;
+}
+
+// 将空闲块从所在区间的链表中移除
+static void remove_free_block(heap_block_t* block)
+{
+    uint32_t fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        kheap.blocks[fl][sl] = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    
+    // 区间变空时清除位图
+    if (!kheap.blocks[fl][sl]) {
+        kheap.sl_bitmap[fl] &= ~(1U << sl);
+        if (!kheap.sl_bitmap[fl]) {
+            kheap.fl_bitmap &= ~(1U << fl);
+        }
+    }
+    kheap.free_blocks--;
+}
+
+// 在 [start, end) 范围逐页映射物理帧，返回实际映射到的结束地址
+static uint32_t kheap_map_pages(uint32_t start, uint32_t end)
+{
+    kheap.resizing = true;
+    
+    uint32_t addr = start;
+    while (addr < end) {
+        uint32_t frame = alloc_frame_high();
+        if (frame == 0) {
+            break;
+        }
+        map_page((void*)addr, frame * PAGE_SIZE, PAGE_PRESENT | PAGE_WRITABLE);
+        addr += PAGE_SIZE;
+    }
+    
+    kheap.resizing = false;
+    return addr;
+}
+
 // 初始化内核堆
 void init_kheap(void)
 {
+    memset(&kheap, 0, sizeof(kheap));
+    
+    // 只映射初始大小，其余虚拟地址留待堆增长时按需映射
+    uint32_t end = kheap_map_pages(KHEAP_START, KHEAP_START + KHEAP_INITIAL_SIZE);
+    uint32_t heap_size = end - KHEAP_START;
+    if (heap_size == 0) {
+        kprintf("[KHEAP] Out of frames, kernel heap unavailable\n");
+        return;
+    }
+    
     // 初始化堆
     kheap.start = (void*)KHEAP_START;
-    kheap.end = (void*)(KHEAP_START + KHEAP_SIZE);
-    kheap.total_size = KHEAP_SIZE;
+    kheap.end = (void*)end;
+    kheap.total_size = heap_size;
     kheap.used_size = 0;
+    kheap.peak_size = heap_size;
+    
+    // 整个堆作为一个空闲块，末尾放置一个大小为 0 的已分配哨兵块，合并时无需检查边界
+    heap_block_t* block = (heap_block_t*)kheap.start;
+    block->prev_phys = NULL;
+    block->size = (heap_size - BLOCK_OVERHEAD) | BLOCK_FREE;
     
-    // 创建初始空闲块
-    kheap.free_list = (heap_block_t*)kheap.start;
-    kheap.free_list->size = KHEAP_SIZE;
-    kheap.free_list->next = NULL;
-    kheap.free_list->prev = NULL;
-    kheap.free_list->is_free = true;
+    heap_block_t* sentinel = block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size = 0;
     
-    kprintf("[KHEAP] Kernel heap initialized at 0x%x-0x%x (%dMB)\n", 
-            KHEAP_START, KHEAP_START + KHEAP_SIZE, KHEAP_SIZE / (1024 * 1024));
+    insert_free_block(block);
+    
+    kprintf("[KHEAP] Kernel heap initialized at 0x%x-0x%x (%d KB, up to %dMB)\n", 
+            KHEAP_START, end, heap_size / 1024, KHEAP_MAX_SIZE / (1024 * 1024));
 }
 
 // 对齐大小到最近的 8 字节
 static size_t align_size(size_t size)
 {
-    return (size + 7) & ~7;
+    return (size + ALIGN_SIZE - 1) & ~(ALIGN_SIZE - 1);
 }
 
-// 寻找适合大小的空闲块
-static heap_block_t* find_free_block(size_t size)
+// 分割块：前 size 字节留给调用者，剩余部分作为新空闲块
+static void split_block(heap_block_t* block, size_t size)
 {
-    heap_block_t* current = kheap.free_list;
+    if (block_size(block) - size < BLOCK_MIN_SIZE) {
+        // 剩余部分太小，无法分割
+        return;
+    }
     
-    // 首次适配算法
-    while (current) {
-        if (current->is_free && current->size >= size) {
-            return current;
-        }
-        current = current->next;
+    heap_block_t* remaining = (heap_block_t*)((uint8_t*)block + size);
+    remaining->prev_phys = block;
+    remaining->size = (block_size(block) - size) | BLOCK_FREE;
+    block_next(remaining)->prev_phys = remaining;
+    
+    block_set_size(block, size);
+    insert_free_block(remaining);
+}
+
+// 与物理相邻的空闲块合并（边界标记使合并为 O(1)），返回合并后的块
+static heap_block_t* merge_blocks(heap_block_t* block)
+{
+    // 合并下一个块
+    heap_block_t* next = block_next(block);
+    if (block_is_free(next)) {
+        remove_free_block(next);
+        block_set_size(block, block_size(block) + block_size(next));
+    }
+    
+    // 合并上一个块
+    heap_block_t* prev = block->prev_phys;
+    if (prev && block_is_free(prev)) {
+        remove_free_block(prev);
+        block_set_size(prev, block_size(prev) + block_size(block));
+        block = prev;
     }
     
-    return NULL;
+    block_next(block)->prev_phys = block;
+    return block;
 }
 
-// 分割块
-static void split_block(heap_block_t* block, size_t size)
+// 缩小已分配的块：尾部多余部分作为空闲块归还，并与后面的空闲块合并
+static void shrink_block(heap_block_t* block, size_t size)
 {
-    if (block->size - size < sizeof(heap_block_t) + 8) {
-        // 块太小，无法分割
+    if (block_size(block) - size < BLOCK_MIN_SIZE) {
         return;
     }
     
-    heap_block_t* new_block = (heap_block_t*)((uint8_t*)block + size);
-    new_block->size = block->size - size;
-    new_block->is_free = true;
-    new_block->next = block->next;
-    new_block->prev = block;
+    heap_block_t* remaining = (heap_block_t*)((uint8_t*)block + size);
+    remaining->prev_phys = block;
+    remaining->size = (block_size(block) - size) | BLOCK_FREE;
+    block_next(remaining)->prev_phys = remaining;
+    
+    block_set_size(block, size);
+    kheap.used_size -= block_size(remaining);
+    insert_free_block(merge_blocks(remaining));
+}
+
+// 扩展堆：在堆末尾映射至少 bytes 字节的新页，返回实际扩展的字节数
+static size_t kheap_grow(size_t bytes)
+{
+    // 新页映射在收缩掉的地址上，必须等其他处理器确认 TLB 刷新之后；等待期间响应击落请求
+    // 收缩的进程没有在其他处理器上运行时（被本处理器中断或抢占）等不到它完成，本次扩展失败
+    while (kheap.trimming) {
+        task_t* trimmer = kheap.trim_task;
+        if (!trimmer || trimmer == get_current_task() || !trimmer->on_cpu) {
+            return 0;
+        }
+        smp_tlb_shootdown_poll();
+        asm volatile("pause");
+    }
+    
+    uint32_t old_end = (uint32_t)kheap.end;
+    uint32_t limit = KHEAP_START + KHEAP_MAX_SIZE;
+    size_t grow = ALIGN_UP(MAX(bytes, KHEAP_GROW_MIN), PAGE_SIZE);
+    if (grow > limit - old_end) {
+        grow = limit - old_end;
+    }
+    if (grow == 0) {
+        return 0;
+    }
     
-    if (block->next) {
-        block->next->prev = new_block;
+    uint32_t new_end = kheap_map_pages(old_end, old_end + grow);
+    if (new_end == old_end) {
+        return 0;
     }
     
-    block->next = new_block;
-    block->size = size;
+    // 原哨兵块变为新空闲块的头部，新哨兵块放在新的末尾
+    heap_block_t* block = (heap_block_t*)(old_end - BLOCK_OVERHEAD);
+    block->size = (new_end - old_end) | BLOCK_FREE;
+    
+    heap_block_t* sentinel = block_next(block);
+    sentinel->prev_phys = block;
+    sentinel->size = 0;
+    
+    insert_free_block(merge_blocks(block));
+    
+    kheap.end = (void*)new_end;
+    kheap.total_size += new_end - old_end;
+    kheap.peak_size = MAX(kheap.peak_size, kheap.total_size);
+    kheap.grow_count++;
+    
+    return new_end - old_end;
 }
 
-// 合并相邻的空闲块
-static void merge_blocks(heap_block_t* block)
+static bool heap_trim(uint32_t* start, uint32_t* end);
+
+// 收缩堆：释放末尾空闲块中完整的页
+uint32_t kheap_trim(void)
 {
-    // 合并下一个块
-    if (block->next && block->next->is_free) {
-        block->size += block->next->size;
-        block->next = block->next->next;
-        if (block->next) {
-            block->next->prev = block;
-        }
+    // 扩展堆时分配帧可能触发内存回收，此时本处理器已持有锁；其他处理器正在使用堆时也不收缩
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    if (!spin_trylock(&kheap_lock)) {
+        asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+        return 0;
     }
     
-    // 合并上一个块
-    if (block->prev && block->prev->is_free) {
-        block->prev->size += block->size;
-        block->prev->next = block->next;
-        if (block->next) {
-            block->next->prev = block->prev;
-        }
-        block = block->prev;
+    // 取消映射要等其他处理器确认 TLB 刷新：调用者关中断时可能持有 irqsave 锁，此时不收缩
+    uint32_t start, end;
+    bool trimmed = false;
+    if ((flags & EFLAGS_IF) || smp_num_cpus() <= 1) {
+        trimmed = heap_trim(&start, &end);
+    }
+    if (trimmed) {
+        kheap.trimming = true;
+        kheap.trim_task = get_current_task();
     }
+    spin_unlock_irqrestore(&kheap_lock, flags);
+    if (!trimmed) {
+        return 0;
+    }
+    
+    // 收缩掉的页已不属于堆，在锁外取消映射，击落期间其他处理器仍可使用堆
+    uint32_t reclaimed = unmap_range((void*)start, end - start);
+    kheap.trimming = false;
+    return reclaimed;
 }
 
-// 内核内存分配
-void* kmalloc(size_t size)
+// 收缩堆，返回需要取消映射的范围 [start, end)（调用者持有 kheap_lock）
+static bool heap_trim(uint32_t* start, uint32_t* end)
 {
-    if (size == 0) {
-        return NULL;
+    if (!kheap.start || kheap.resizing || kheap.trimming) {
+        return false;
+    }
+    
+    uint32_t old_end = (uint32_t)kheap.end;
+    heap_block_t* sentinel = (heap_block_t*)(old_end - BLOCK_OVERHEAD);
+    heap_block_t* last = sentinel->prev_phys;
+    if (!last || !block_is_free(last)) {
+        return false;
+    }
+    
+    // 新的哨兵块放在新末尾之前；末尾空闲块剩余部分不足以构成一个块时多保留一页
+    uint32_t new_end = MAX(ALIGN_UP((uint32_t)last + BLOCK_OVERHEAD, PAGE_SIZE),
+                           KHEAP_START + KHEAP_INITIAL_SIZE);
+    size_t remain = new_end - BLOCK_OVERHEAD - (uint32_t)last;
+    if (remain != 0 && remain < BLOCK_MIN_SIZE) {
+        new_end += PAGE_SIZE;
+        remain += PAGE_SIZE;
+    }
+    if (new_end >= old_end) {
+        return false;
+    }
+    
+    remove_free_block(last);
+    
+    heap_block_t* prev = last->prev_phys;
+    sentinel = (heap_block_t*)(new_end - BLOCK_OVERHEAD);
+    if (remain == 0) {
+        // 末尾空闲块整体被释放，哨兵块占据它的位置
+        sentinel->prev_phys = prev;
+    } else {
+        last->size = remain | BLOCK_FREE;
+        sentinel->prev_phys = last;
+        insert_free_block(last);
     }
+    sentinel->size = 0;
     
-    // 计算实际需要的大小（包括堆块头）
-    size_t actual_size = align_size(size) + sizeof(heap_block_t);
+    kheap.end = (void*)new_end;
+    kheap.total_size -= old_end - new_end;
+    kheap.trim_count++;
     
-    // 寻找合适的空闲块
-    heap_block_t* block = find_free_block(actual_size);
+    *start = new_end;
+    *end = old_end;
+    return true;
+}
+
+// 计算实际需要的块大小（包括堆块头）
+static size_t block_size_for(size_t size)
+{
+    size_t actual_size = align_size(size) + BLOCK_OVERHEAD;
+    if (actual_size < BLOCK_MIN_SIZE) {
+        actual_size = BLOCK_MIN_SIZE;
+    }
+    return actual_size;
+}
+
+// 取出一个不小于 actual_size 的空闲块（已移出空闲链表），必要时扩展堆
+static heap_block_t* block_take(size_t actual_size)
+{
+    // 通过位图直接找到能满足请求的最小非空区间
+    uint32_t fl, sl;
+    mapping_search(actual_size, &fl, &sl);
+    heap_block_t* block = search_suitable_block(&fl, &sl);
+    if (!block) {
+        // 没有足够大的空闲块时扩展堆；多扩展一个区间宽度，保证向上取整后的区间中有块
+        size_t need = actual_size + (actual_size >> SL_INDEX_COUNT_LOG2) + BLOCK_OVERHEAD;
+        if (kheap_grow(need) > 0) {
+            mapping_search(actual_size, &fl, &sl);
+            block = search_suitable_block(&fl, &sl);
+        }
+    }
     if (!block) {
         kprintf("[ERROR] Out of memory!\n");
         return NULL;
     }
     
+    remove_free_block(block);
+    return block;
+}
+
+// 标记块为已使用并交给分析器采样，返回可用内存的地址（跳过块头）
+static void* block_mark_used(heap_block_t* block, size_t size, void* caller)
+{
+    block->size &= ~BLOCK_FREE;
+    kheap.used_size += block_size(block);
+    kheap.used_blocks++;
+    kheap.alloc_count++;
+    kheap.peak_used = MAX(kheap.peak_used, kheap.used_size);
+    
+    void* ptr = (uint8_t*)block + BLOCK_OVERHEAD;
+    if (kheap_prof_alloc(ptr, size, (uint32_t)caller)) {
+        block->size |= BLOCK_SAMPLED;
+    }
+    return ptr;
+}
+
+// 分配 size 字节，caller 为分析器记录的调用点（调用者持有 kheap_lock）
+static void* heap_alloc(size_t size, void* caller)
+{
+    if (size == 0 || size > KHEAP_MAX_SIZE) {
+        return NULL;
+    }
+    
+    size_t actual_size = block_size_for(size);
+    heap_block_t* block = block_take(actual_size);
+    if (!block) {
+        return NULL;
+    }
+    
     // 分割块
     split_block(block, actual_size);
     
-    // 标记块为已使用
-    block->is_free = false;
-    kheap.used_size += actual_size;
+    return block_mark_used(block, size, caller);
+}
+
+// 内核内存分配
+void* kmalloc(size_t size)
+{
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    void* ptr = heap_alloc(size, __builtin_return_address(0));
+    spin_unlock_irqrestore(&kheap_lock, flags);
+    return ptr;
+}
+
+// 按 align 对齐分配（调用者持有 kheap_lock）
+static void* heap_alloc_aligned(size_t size, size_t align, void* caller)
+{
+    if (align <= ALIGN_SIZE) {
+        return heap_alloc(size, caller);
+    }
+    if (size == 0 || size > KHEAP_MAX_SIZE || (align & (align - 1)) != 0 || align > KHEAP_MAX_SIZE) {
+        return NULL;
+    }
+    
+    // 多取 align + 最小块大小，保证对齐后前面切下的部分能单独成为空闲块
+    size_t actual_size = block_size_for(size);
+    heap_block_t* block = block_take(actual_size + align + BLOCK_MIN_SIZE);
+    if (!block) {
+        return NULL;
+    }
+    
+    uint32_t payload = (uint32_t)block + BLOCK_OVERHEAD;
+    uint32_t aligned = ALIGN_UP(payload, align);
+    if (aligned != payload && aligned - payload < BLOCK_MIN_SIZE) {
+        aligned += align;
+    }
     
-    // 返回可用内存的地址（跳过块头）
-    return (void*)((uint8_t*)block + sizeof(heap_block_t));
+    // 切下对齐前的部分归还空闲链表（与前一个空闲块合并）
+    size_t gap = aligned - payload;
+    if (gap > 0) {
+        heap_block_t* front = block;
+        block = (heap_block_t*)((uint8_t*)front + gap);
+        block->prev_phys = front;
+        block->size = block_size(front) - gap;
+        block_next(block)->prev_phys = block;
+        block_set_size(front, gap);
+        insert_free_block(merge_blocks(front));
+    }
+    
+    // 切下多余的尾部
+    split_block(block, actual_size);
+    
+    return block_mark_used(block, size, caller);
 }
 
-// 内核内存释放
-void kfree(void* ptr)
+// 按 align 对齐的内核内存分配
+void* kmalloc_aligned(size_t size, size_t align)
 {
-    if (!ptr) {
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    void* ptr = heap_alloc_aligned(size, align, __builtin_return_address(0));
+    spin_unlock_irqrestore(&kheap_lock, flags);
+    return ptr;
+}
+
+// 释放（调用者持有 kheap_lock）
+static void heap_free(void* ptr)
+{
+    if (ptr < kheap.start || ptr >= kheap.end) {
+        kprintf("[ERROR] Invalid free of 0x%x\n", (uint32_t)ptr);
         return;
     }
     
     // 获取块头
-    heap_block_t* block = (heap_block_t*)((uint8_t*)ptr - sizeof(heap_block_t));
+    heap_block_t* block = (heap_block_t*)((uint8_t*)ptr - BLOCK_OVERHEAD);
     
-    if (block->is_free) {
+    if (block_is_free(block)) {
         kprintf("[ERROR] Double free detected!\n");
         return;
     }
     
+    if (block->size & BLOCK_SAMPLED) {
+        kheap_prof_free(ptr);
+        block->size &= ~BLOCK_SAMPLED;
+    }
+    
     // 标记块为空闲
-    block->is_free = true;
-    kheap.used_size -= block->size;
+    kheap.used_size -= block_size(block);
+    kheap.used_blocks--;
+    kheap.free_count++;
+    block->size |= BLOCK_FREE;
     
     // 合并相邻的空闲块
-    merge_blocks(block);
+    insert_free_block(merge_blocks(block));
+}
+
+// 内核内存释放
+void kfree(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    heap_free(ptr);
+    spin_unlock_irqrestore(&kheap_lock, flags);
+}
+
+// 调整大小（调用者持有 kheap_lock）
+static void* heap_realloc(void* ptr, size_t size, void* caller)
+{
+    if (size == 0) {
+        heap_free(ptr);
+        return NULL;
+    }
+    
+    if (ptr < kheap.start || ptr >= kheap.end || size > KHEAP_MAX_SIZE) {
+        kprintf("[ERROR] Invalid realloc of 0x%x\n", (uint32_t)ptr);
+        return NULL;
+    }
+    
+    heap_block_t* block = (heap_block_t*)((uint8_t*)ptr - BLOCK_OVERHEAD);
+    if (block_is_free(block)) {
+        kprintf("[ERROR] Realloc of freed block 0x%x\n", (uint32_t)ptr);
+        return NULL;
+    }
+    
+    size_t actual_size = block_size_for(size);
+    if (actual_size > block_size(block)) {
+        // 块位于堆末尾时先扩展堆，新空间紧跟在块之后
+        heap_block_t* next = block_next(block);
+        if (block_size(next) == 0) {
+            kheap_grow(actual_size - block_size(block) + BLOCK_OVERHEAD);
+            next = block_next(block);
+        }
+        
+        // 下一个块空闲且足够大时吞并它，原地扩展
+        if (block_is_free(next) && block_size(block) + block_size(next) >= actual_size) {
+            remove_free_block(next);
+            kheap.used_size += block_size(next);
+            block_set_size(block, block_size(block) + block_size(next));
+            block_next(block)->prev_phys = block;
+            kheap.peak_used = MAX(kheap.peak_used, kheap.used_size);
+        }
+    }
+    
+    if (actual_size <= block_size(block)) {
+        shrink_block(block, actual_size);
+        if (block->size & BLOCK_SAMPLED) {
+            kheap_prof_resize(ptr, size);
+        }
+        kheap.realloc_inplace++;
+        return ptr;
+    }
+    
+    // 无法原地扩展：重新分配并复制，失败时原内存保持不变
+    void* new_ptr = heap_alloc(size, caller);
+    if (!new_ptr) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, block_size(block) - BLOCK_OVERHEAD);
+    heap_free(ptr);
+    kheap.realloc_moved++;
+    
+    return new_ptr;
+}
+
+// 调整已分配内存的大小
+void* krealloc(void* ptr, size_t size)
+{
+    if (ptr && is_vmalloc_addr(ptr)) {
+        return vrealloc(ptr, size);
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    void* new_ptr = ptr ? heap_realloc(ptr, size, __builtin_return_address(0))
+                        : heap_alloc(size, __builtin_return_address(0));
+    spin_unlock_irqrestore(&kheap_lock, flags);
+    return new_ptr;
+}
+
+// 已分配内存的实际可用大小
+size_t ksize(const void* ptr)
+{
+    if (!ptr) {
+        return 0;
+    }
+    if (is_vmalloc_addr(ptr)) {
+        return vmalloc_size(ptr);
+    }
+    
+    heap_block_t* block = (heap_block_t*)((uint8_t*)ptr - BLOCK_OVERHEAD);
+    return block_size(block) - BLOCK_OVERHEAD;
+}
+
+// 计算增长后的容量：至少增长一半，使连续追加的总复制量与最终大小成正比
+size_t kcapacity_hint(size_t current, size_t needed)
+{
+    if (needed <= current) {
+        return current;
+    }
+    
+    size_t capacity = MAX(needed, current + current / 2);
+    if (capacity >= PAGE_SIZE) {
+        return ALIGN_UP(capacity, PAGE_SIZE);
+    }
+    return MAX(align_size(capacity), (size_t)32);
 }
 
 // 获取内核堆信息
@@ -176,3 +717,72 @@ void get_kheap_info(size_t* total, size_t* used, size_t* free)
         *free = kheap.total_size - kheap.used_size;
     }
 }
+
+// 获取内核堆的详细统计
+void get_kheap_stats(kheap_stats_t* stats)
+{
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    
+    stats->total_size = kheap.total_size;
+    stats->used_size = kheap.used_size;
+    // 堆末尾哨兵块的头部不属于任何块，不计入空闲量
+    stats->free_size = kheap.total_size - kheap.used_size - BLOCK_OVERHEAD;
+    stats->free_blocks = kheap.free_blocks;
+    stats->used_blocks = kheap.used_blocks;
+    stats->peak_size = kheap.peak_size;
+    stats->peak_used = kheap.peak_used;
+    stats->grow_count = kheap.grow_count;
+    stats->trim_count = kheap.trim_count;
+    stats->realloc_inplace = kheap.realloc_inplace;
+    stats->realloc_moved = kheap.realloc_moved;
+    stats->alloc_count = kheap.alloc_count;
+    stats->free_count = kheap.free_count;
+    stats->largest_free = 0;
+    
+    // 最大空闲块位于最高的非空区间，只需扫描该区间的链表
+    if (kheap.fl_bitmap) {
+        uint32_t fl = fls(kheap.fl_bitmap);
+        uint32_t sl = fls(kheap.sl_bitmap[fl]);
+        for (heap_block_t* block = kheap.blocks[fl][sl]; block; block = block->next_free) {
+            if (block_size(block) > stats->largest_free) {
+                stats->largest_free = block_size(block);
+            }
+        }
+    }
+    
+    // 外部碎片率：空闲内存中无法满足最大请求的比例
+    if (stats->free_size == 0) {
+        stats->fragmentation = 0;
+    } else if (stats->free_size < 100) {
+        stats->fragmentation = 100 - stats->largest_free * 100 / stats->free_size;
+    } else {
+        uint32_t contiguous = stats->largest_free / (stats->free_size / 100);
+        stats->fragmentation = (contiguous >= 100) ? 0 : 100 - contiguous;
+    }
+    
+    spin_unlock_irqrestore(&kheap_lock, flags);
+}
+
+// 按大小级别统计空闲块（级别 n 覆盖 [2^n, 2^(n+1)) 字节）
+void kheap_free_histogram(uint32_t* counts, size_t* bytes, uint32_t classes)
+{
+    memset(counts, 0, classes * sizeof(uint32_t));
+    memset(bytes, 0, classes * sizeof(size_t));
+    
+    uint32_t flags = spin_lock_irqsave(&kheap_lock);
+    
+    // 只遍历位图中非空的区间
+    for (uint32_t fl_map = kheap.fl_bitmap; fl_map; fl_map &= fl_map - 1) {
+        uint32_t fl = ffs(fl_map);
+        for (uint32_t sl_map = kheap.sl_bitmap[fl]; sl_map; sl_map &= sl_map - 1) {
+            uint32_t sl = ffs(sl_map);
+            for (heap_block_t* block = kheap.blocks[fl][sl]; block; block = block->next_free) {
+                uint32_t class = MIN(fls(block_size(block)), classes - 1);
+                counts[class]++;
+                bytes[class] += block_size(block);
+            }
+        }
+    }
+    
+    spin_unlock_irqrestore(&kheap_lock, flags);
+}
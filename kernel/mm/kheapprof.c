@@ -0,0 +1,260 @@
+#include <mm/kheapprof.h>
+#include <mm/kheap.h>
+#include <proc/task.h>
+#include <string.h>
+#include <common.h>
+#include <vga.h>
+
+// 输出中列出的调用点数量上限
+#define KHEAP_PROF_TOP 16
+
+// 采样记录表最多填充 3/4，保持线性探测的探测长度较短
+#define KHEAP_PROF_SAMPLES_MAX (KHEAP_PROF_SAMPLES * 3 / 4)
+
+// 一次采样的分配
+typedef struct {
+    void* ptr;                // 分配的内存（NULL 为空槽）
+    kheap_site_t* site;       // 分配所在的调用点
+    size_t size;              // 请求的大小
+    uint32_t weight;          // 采样权重（该记录代表的分配次数）
+    uint32_t alloc_tick;      // 分配时的时钟滴答
+} kheap_sample_t;
+
+// 调用点表（按调用地址开放寻址）和采样记录表（按内存地址开放寻址）
+static kheap_site_t sites[KHEAP_PROF_SITES];
+static kheap_sample_t samples[KHEAP_PROF_SAMPLES];
+
+static uint32_t sample_count = 0;                    // 采样记录表中的记录数
+static uint32_t sample_countdown = KHEAP_PROF_RATE;  // 距下一次采样的分配次数
+static uint32_t dropped = 0;                         // 表已满而放弃的采样数
+
+// 乘法散列
+static inline uint32_t prof_hash(uint32_t key, uint32_t size)
+{
+    return ((key * 2654435761U) >> 16) & (size - 1);
+}
+
+// 大小级别：最高置位的位号
+static inline uint32_t size_class(size_t size)
+{
+    return size ? 31 - __builtin_clz(size) : 0;
+}
+
+// 查找调用点，不存在时占用一个空槽，表满时返回 NULL
+static kheap_site_t* site_lookup(uint32_t caller)
+{
+    uint32_t index = prof_hash(caller, KHEAP_PROF_SITES);
+    for (uint32_t i = 0; i < KHEAP_PROF_SITES; i++) {
+        kheap_site_t* site = &sites[index];
+        if (site->caller == caller) {
+            return site;
+        }
+        if (site->caller == 0) {
+            site->caller = caller;
+            return site;
+        }
+        index = (index + 1) & (KHEAP_PROF_SITES - 1);
+    }
+    return NULL;
+}
+
+// 查找 ptr 的采样记录
+static kheap_sample_t* sample_find(void* ptr)
+{
+    uint32_t index = prof_hash((uint32_t)ptr, KHEAP_PROF_SAMPLES);
+    while (samples[index].ptr) {
+        if (samples[index].ptr == ptr) {
+            return &samples[index];
+        }
+        index = (index + 1) & (KHEAP_PROF_SAMPLES - 1);
+    }
+    return NULL;
+}
+
+// 删除采样记录：把后面同一探测链上的记录前移填补空位，无需墓碑标记
+static void sample_remove(kheap_sample_t* sample)
+{
+    uint32_t hole = sample - samples;
+    uint32_t index = hole;
+
+    while (1) {
+        index = (index + 1) & (KHEAP_PROF_SAMPLES - 1);
+        if (!samples[index].ptr) {
+            break;
+        }
+
+        // 记录的起始槽位于 (hole, index] 之外时才能移到空位上
+        uint32_t home = prof_hash((uint32_t)samples[index].ptr, KHEAP_PROF_SAMPLES);
+        bool reachable = (hole <= index) ? (home > hole && home <= index)
+                                         : (home > hole || home <= index);
+        if (!reachable) {
+            samples[hole] = samples[index];
+            hole = index;
+        }
+    }
+
+    samples[hole].ptr = NULL;
+    sample_count--;
+}
+
+// 记录一次分配
+bool kheap_prof_alloc(void* ptr, size_t size, uint32_t caller)
+{
+    // 大块总是采样（权重 1），小块每 KHEAP_PROF_RATE 次采样一次
+    uint32_t weight = 1;
+    if (size < KHEAP_PROF_LARGE) {
+        if (--sample_countdown > 0) {
+            return false;
+        }
+        sample_countdown = KHEAP_PROF_RATE;
+        weight = KHEAP_PROF_RATE;
+    }
+
+    if (sample_count >= KHEAP_PROF_SAMPLES_MAX) {
+        dropped++;
+        return false;
+    }
+    kheap_site_t* site = site_lookup(caller);
+    if (!site) {
+        dropped++;
+        return false;
+    }
+
+    uint32_t index = prof_hash((uint32_t)ptr, KHEAP_PROF_SAMPLES);
+    while (samples[index].ptr) {
+        index = (index + 1) & (KHEAP_PROF_SAMPLES - 1);
+    }
+
+    kheap_sample_t* sample = &samples[index];
+    sample->ptr = ptr;
+    sample->site = site;
+    sample->size = size;
+    sample->weight = weight;
+    sample->alloc_tick = get_system_ticks();
+    sample_count++;
+
+    site->allocs += weight;
+    site->live_count += weight;
+    site->live_bytes += size * weight;
+    site->total_bytes += size * weight;
+    site->class_mask |= 1U << size_class(size);
+
+    return true;
+}
+
+// 采样的分配被释放
+void kheap_prof_free(void* ptr)
+{
+    // 重置前采样的块仍带有采样标志，找不到记录时忽略
+    kheap_sample_t* sample = sample_find(ptr);
+    if (!sample) {
+        return;
+    }
+
+    kheap_site_t* site = sample->site;
+    site->frees += sample->weight;
+    site->live_count -= sample->weight;
+    site->live_bytes -= sample->size * sample->weight;
+    site->freed_samples++;
+    site->lifetime_ticks += get_system_ticks() - sample->alloc_tick;
+
+    sample_remove(sample);
+}
+
+// 采样的分配原地调整大小
+void kheap_prof_resize(void* ptr, size_t size)
+{
+    kheap_sample_t* sample = sample_find(ptr);
+    if (!sample) {
+        return;
+    }
+
+    kheap_site_t* site = sample->site;
+    site->live_bytes -= sample->size * sample->weight;
+    site->live_bytes += size * sample->weight;
+    if (size > sample->size) {
+        site->total_bytes += (size - sample->size) * sample->weight;
+    }
+    site->class_mask |= 1U << size_class(size);
+    sample->size = size;
+}
+
+// 清空所有调用点和采样记录
+void kheap_prof_reset(void)
+{
+    memset(sites, 0, sizeof(sites));
+    memset(samples, 0, sizeof(samples));
+    sample_count = 0;
+    sample_countdown = KHEAP_PROF_RATE;
+    dropped = 0;
+}
+
+// 生成分析结果
+int kheap_prof_info(char* buf, size_t buf_size)
+{
+    uint32_t seconds = MAX(get_system_ticks() / TIMER_HZ, 1U);
+
+    kheap_stats_t stats;
+    get_kheap_stats(&stats);
+
+    int offset = snprintf(buf, buf_size, "Heap: %d KB total, %d KB used, %d KB peak used\n",
+                          stats.total_size / 1024, stats.used_size / 1024, stats.peak_used / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "Allocs: %d (%d/s), frees: %d, live: %d\n",
+                       stats.alloc_count, stats.alloc_count / seconds, stats.free_count, stats.used_blocks);
+    offset += snprintf(buf + offset, buf_size - offset, "Sampling: 1/%d (always >= %d bytes), %d live samples, %d dropped\n",
+                       KHEAP_PROF_RATE, KHEAP_PROF_LARGE, sample_count, dropped);
+
+    // 按存活字节数从大到小排列调用点（插入排序，只保留前 KHEAP_PROF_TOP 个）
+    kheap_site_t* top[KHEAP_PROF_TOP];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < KHEAP_PROF_SITES; i++) {
+        kheap_site_t* site = &sites[i];
+        if (site->caller == 0) {
+            continue;
+        }
+
+        uint32_t pos = (count < KHEAP_PROF_TOP) ? count++ : KHEAP_PROF_TOP;
+        while (pos > 0 && top[pos - 1]->live_bytes < site->live_bytes) {
+            if (pos < KHEAP_PROF_TOP) {
+                top[pos] = top[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < KHEAP_PROF_TOP) {
+            top[pos] = site;
+        }
+    }
+
+    offset += snprintf(buf + offset, buf_size - offset,
+                       "\n# caller live_bytes live_objs allocs/s total_bytes avg_life_ms sizes\n");
+    for (uint32_t i = 0; i < count && offset < (int)buf_size; i++) {
+        kheap_site_t* site = top[i];
+        uint32_t life_ms = site->freed_samples
+            ? site->lifetime_ticks / site->freed_samples * (1000 / TIMER_HZ) : 0;
+        uint32_t min_size = 1U << __builtin_ctz(site->class_mask);
+        uint32_t max_size = (2U << (31 - __builtin_clz(site->class_mask))) - 1;
+
+        offset += snprintf(buf + offset, buf_size - offset, "%x %d %d %d %d %d %d-%d\n",
+                           site->caller, site->live_bytes, site->live_count, site->allocs / seconds,
+                           site->total_bytes, life_ms, min_size, max_size);
+    }
+
+    // 空闲块大小直方图
+    uint32_t counts[KHEAP_PROF_CLASSES];
+    size_t bytes[KHEAP_PROF_CLASSES];
+    kheap_free_histogram(counts, bytes, KHEAP_PROF_CLASSES);
+
+    offset += snprintf(buf + offset, buf_size - offset, "\n# free_size blocks bytes\n");
+    for (uint32_t i = 0; i < KHEAP_PROF_CLASSES && offset < (int)buf_size; i++) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        offset += snprintf(buf + offset, buf_size - offset, "%d-%d %d %d\n",
+                           1U << i, (2U << i) - 1, counts[i], bytes[i]);
+    }
+
+    offset += snprintf(buf + offset, buf_size - offset, "\nLargest free extent: %d bytes\nFragmentation: %d%%\n",
+                       stats.largest_free, stats.fragmentation);
+
+    return offset;
+}
@@ -0,0 +1,311 @@
+#include <mm/memmap.h>
+#include <mm/paging.h>
+#include <multiboot.h>
+#include <multiboot2.h>
+#include <string.h>
+#include <common.h>
+#include <stdbool.h>
+#include <vga.h>
+
+// 内核镜像起止地址（由链接脚本定义）
+extern uint8_t _kernel_start[];
+extern uint8_t _kernel_end[];
+
+// 32位物理地址空间内可管理的最高地址
+#define MEMMAP_ADDR_LIMIT 0xFFFFF000ULL
+
+// 内存图状态
+static memmap_region_t usable_regions[MEMMAP_MAX_REGIONS];
+static uint32_t usable_count = 0;
+static memmap_region_t reserved_regions[MEMMAP_MAX_REGIONS];
+static uint32_t reserved_count = 0;
+
+// 按起始地址有序插入区域
+static void region_insert(memmap_region_t* regions, uint32_t* count, uint32_t start, uint32_t end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    if (*count >= MEMMAP_MAX_REGIONS) {
+        kprintf("[MEMMAP] Too many regions, ignoring 0x%x-0x%x\n", start, end);
+        return;
+    }
+
+    uint32_t i = *count;
+    while (i > 0 && regions[i - 1].start > start) {
+        regions[i] = regions[i - 1];
+        i--;
+    }
+
+    regions[i].start = start;
+    regions[i].end = end;
+    (*count)++;
+}
+
+// 合并重叠或相邻的有序区域
+static void region_merge(memmap_region_t* regions, uint32_t* count)
+{
+    if (*count == 0) {
+        return;
+    }
+
+    uint32_t out = 0;
+    for (uint32_t i = 1; i < *count; i++) {
+        if (regions[i].start <= regions[out].end) {
+            if (regions[i].end > regions[out].end) {
+                regions[out].end = regions[i].end;
+            }
+        } else {
+            regions[++out] = regions[i];
+        }
+    }
+    *count = out + 1;
+}
+
+// 添加可用区域（向内对齐到页边界）
+static void add_usable(uint64_t addr, uint64_t len)
+{
+    if (addr >= MEMMAP_ADDR_LIMIT) {
+        return;
+    }
+
+    uint64_t end = addr + len;
+    if (end > MEMMAP_ADDR_LIMIT) {
+        end = MEMMAP_ADDR_LIMIT;
+    }
+
+    uint32_t start = ALIGN_UP((uint32_t)addr, PAGE_SIZE);
+    uint32_t stop = ALIGN_DOWN((uint32_t)end, PAGE_SIZE);
+    region_insert(usable_regions, &usable_count, start, stop);
+}
+
+// 添加保留区域（向外对齐到页边界）
+static void add_reserved(uint32_t start, uint32_t end)
+{
+    uint32_t stop = ALIGN_UP(end, PAGE_SIZE);
+    if (stop < end) {
+        stop = (uint32_t)MEMMAP_ADDR_LIMIT;
+    }
+    region_insert(reserved_regions, &reserved_count, ALIGN_DOWN(start, PAGE_SIZE), stop);
+}
+
+// 解析 Multiboot2 引导信息
+static void parse_multiboot2(uint32_t mbi_addr)
+{
+    uint32_t total_size = *(uint32_t*)mbi_addr;
+    bool have_mmap = false;
+    struct multiboot_tag_basic_meminfo* meminfo = NULL;
+
+    add_reserved(mbi_addr, mbi_addr + total_size);
+
+    struct multiboot_tag* tag = (struct multiboot_tag*)(mbi_addr + 8);
+    while (tag->type != MULTIBOOT_TAG_TYPE_END) {
+        switch (tag->type) {
+            case MULTIBOOT_TAG_TYPE_MMAP: {
+                struct multiboot_tag_mmap* mmap = (struct multiboot_tag_mmap*)tag;
+                uint8_t* entry = (uint8_t*)mmap->entries;
+                uint8_t* end = (uint8_t*)tag + tag->size;
+
+                while (entry < end) {
+                    struct multiboot_mmap_entry* e = (struct multiboot_mmap_entry*)entry;
+                    if (e->type == MULTIBOOT2_MEMORY_AVAILABLE) {
+                        add_usable(e->addr, e->len);
+                    }
+                    entry += mmap->entry_size;
+                }
+                have_mmap = true;
+                break;
+            }
+            case MULTIBOOT_TAG_TYPE_MODULE: {
+                struct multiboot_tag_module* module = (struct multiboot_tag_module*)tag;
+                add_reserved(module->mod_start, module->mod_end);
+                break;
+            }
+            case MULTIBOOT_TAG_TYPE_BASIC_MEMINFO:
+                meminfo = (struct multiboot_tag_basic_meminfo*)tag;
+                break;
+            default:
+                break;
+        }
+
+        // 标签按 8 字节对齐
+        tag = (struct multiboot_tag*)((uint8_t*)tag + ((tag->size + 7) & ~7));
+    }
+
+    if (!have_mmap && meminfo) {
+        add_usable(0x100000, (uint64_t)meminfo->mem_upper * 1024);
+    }
+}
+
+// 解析 Multiboot1 引导信息
+static void parse_multiboot1(uint32_t mbi_addr)
+{
+    struct multiboot_info* info = (struct multiboot_info*)mbi_addr;
+
+    add_reserved(mbi_addr, mbi_addr + sizeof(struct multiboot_info));
+
+    if (info->flags & MULTIBOOT_INFO_MEM_MAP) {
+        uint32_t entry = info->mmap_addr;
+        uint32_t end = info->mmap_addr + info->mmap_length;
+
+        add_reserved(info->mmap_addr, end);
+
+        while (entry < end) {
+            struct multiboot_mmap_entry_v1* e = (struct multiboot_mmap_entry_v1*)entry;
+            if (e->type == MULTIBOOT_MEMORY_AVAILABLE) {
+                add_usable(e->addr, e->len);
+            }
+            entry += e->size + sizeof(e->size);
+        }
+    } else if (info->flags & MULTIBOOT_INFO_MEMORY) {
+        add_usable(0x100000, (uint64_t)info->mem_upper * 1024);
+    }
+
+    if (info->flags & MULTIBOOT_INFO_MODS) {
+        struct multiboot_mod_list* mods = (struct multiboot_mod_list*)info->mods_addr;
+        add_reserved(info->mods_addr, info->mods_addr + info->mods_count * sizeof(struct multiboot_mod_list));
+        for (uint32_t i = 0; i < info->mods_count; i++) {
+            add_reserved(mods[i].mod_start, mods[i].mod_end);
+        }
+    }
+}
+
+// 解析引导加载器提供的内存图
+void memmap_init(uint32_t magic, uint32_t mbi_addr)
+{
+    usable_count = 0;
+    reserved_count = 0;
+
+    // 低 1MB（BIOS 数据区、VGA 显存等）和内核镜像始终保留
+    add_reserved(0, 0x100000);
+    add_reserved((uint32_t)_kernel_start, (uint32_t)_kernel_end);
+
+    if (magic == MULTIBOOT2_BOOTLOADER_MAGIC) {
+        parse_multiboot2(mbi_addr);
+    } else if (magic == MULTIBOOT_BOOTLOADER_MAGIC) {
+        parse_multiboot1(mbi_addr);
+    }
+
+    if (usable_count == 0) {
+        kprintf("[MEMMAP] No memory map from bootloader (magic 0x%x), assuming %dMB\n",
+                magic, MEMMAP_FALLBACK_END / (1024 * 1024));
+        add_usable(0x100000, MEMMAP_FALLBACK_END - 0x100000);
+    }
+
+    region_merge(usable_regions, &usable_count);
+    region_merge(reserved_regions, &reserved_count);
+
+    kprintf("[MEMMAP] %d usable regions, %d KB usable, highest address 0x%x\n",
+            usable_count, memmap_usable_bytes() / 1024, memmap_highest_usable());
+}
+
+// 可用区域数量
+uint32_t memmap_usable_count(void)
+{
+    return usable_count;
+}
+
+// 获取可用区域
+const memmap_region_t* memmap_usable_region(uint32_t index)
+{
+    if (index >= usable_count) {
+        return NULL;
+    }
+    return &usable_regions[index];
+}
+
+// 可用内存的最高物理地址
+uint32_t memmap_highest_usable(void)
+{
+    uint32_t highest = 0;
+    for (uint32_t i = 0; i < usable_count; i++) {
+        if (usable_regions[i].end > highest) {
+            highest = usable_regions[i].end;
+        }
+    }
+    return highest;
+}
+
+// 可用内存总字节数
+uint32_t memmap_usable_bytes(void)
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < usable_count; i++) {
+        total += usable_regions[i].end - usable_regions[i].start;
+    }
+    return total;
+}
+
+// 分配引导期内存
+uint32_t memmap_alloc_early(uint32_t size, uint32_t align, uint32_t limit)
+{
+    size = ALIGN_UP(size, PAGE_SIZE);
+
+    for (uint32_t i = 0; i < usable_count; i++) {
+        memmap_region_t* region = &usable_regions[i];
+        uint32_t region_end = MIN(region->end, limit);
+        uint32_t candidate = ALIGN_UP(region->start, align);
+
+        // 保留区域有序，依次跳过与候选区间重叠的部分
+        for (uint32_t j = 0; j < reserved_count; j++) {
+            memmap_region_t* reserved = &reserved_regions[j];
+            if (reserved->end <= candidate) {
+                continue;
+            }
+            if (reserved->start >= candidate + size) {
+                break;
+            }
+            candidate = ALIGN_UP(reserved->end, align);
+        }
+
+        if (candidate >= region->start && candidate + size <= region_end) {
+            add_reserved(candidate, candidate + size);
+            region_merge(reserved_regions, &reserved_count);
+            return candidate;
+        }
+    }
+
+    kprintf("[MEMMAP] Early allocation of %d bytes failed\n", size);
+    return 0;
+}
+
+// 遍历可用且未保留的帧范围
+void memmap_for_each_free(void (*fn)(uint32_t start_frame, uint32_t count))
+{
+    for (uint32_t i = 0; i < usable_count; i++) {
+        uint32_t cursor = usable_regions[i].start;
+        uint32_t end = usable_regions[i].end;
+
+        for (uint32_t j = 0; j < reserved_count && cursor < end; j++) {
+            memmap_region_t* reserved = &reserved_regions[j];
+            if (reserved->end <= cursor) {
+                continue;
+            }
+            if (reserved->start >= end) {
+                break;
+            }
+            if (reserved->start > cursor) {
+                fn(cursor / PAGE_SIZE, (reserved->start - cursor) / PAGE_SIZE);
+            }
+            cursor = reserved->end;
+        }
+
+        if (cursor < end) {
+            fn(cursor / PAGE_SIZE, (end - cursor) / PAGE_SIZE);
+        }
+    }
+}
+
+// 打印内存图
+void memmap_dump(void)
+{
+    kprintf("Usable regions:\n");
+    for (uint32_t i = 0; i < usable_count; i++) {
+        kprintf("  0x%x-0x%x\n", usable_regions[i].start, usable_regions[i].end);
+    }
+    kprintf("Reserved regions:\n");
+    for (uint32_t i = 0; i < reserved_count; i++) {
+        kprintf("  0x%x-0x%x\n", reserved_regions[i].start, reserved_regions[i].end);
+    }
+}
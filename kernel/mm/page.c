@@ -0,0 +1,128 @@
+#include <mm/page.h>
+#include <string.h>
+#include <vga.h>
+
+// 描述符大小固定为 16 字节，保证元数据开销低于 0.4%
+_Static_assert(sizeof(page_t) == 16, "page_t must be 16 bytes");
+
+// 描述符数组
+page_t* mem_map = NULL;
+
+// 帧总数
+static uint32_t mem_map_frames = 0;
+
+// 计算描述符数组大小
+size_t page_array_size(uint32_t total_frames)
+{
+    return total_frames * sizeof(page_t);
+}
+
+// 初始化描述符数组
+void page_array_init(void* array, uint32_t total_frames)
+{
+    mem_map = (page_t*)array;
+    mem_map_frames = total_frames;
+
+    memset(mem_map, 0, page_array_size(total_frames));
+    for (uint32_t i = 0; i < total_frames; i++) {
+        mem_map[i].flags = PG_RESERVED;
+    }
+}
+
+// 帧号转换为描述符
+page_t* pfn_to_page(uint32_t frame)
+{
+    if (frame >= mem_map_frames) {
+        return NULL;
+    }
+    return &mem_map[frame];
+}
+
+// 描述符转换为帧号
+uint32_t page_to_pfn(page_t* page)
+{
+    return (uint32_t)(page - mem_map);
+}
+
+// 增加引用计数
+uint32_t page_ref_get(page_t* page)
+{
+    if (!page || !(page->flags & PG_HEAD)) {
+        kprintf("[PAGE] Cannot reference unallocated frame %d\n", page ? page_to_pfn(page) : 0);
+        return 0;
+    }
+    return __atomic_add_fetch(&page->refcount, 1, __ATOMIC_ACQ_REL);
+}
+
+// 减少引用计数（计数归零时由调用者释放帧）
+uint32_t page_ref_put(page_t* page)
+{
+    if (!page || !(page->flags & PG_HEAD)) {
+        kprintf("[PAGE] Cannot release unallocated frame %d\n", page ? page_to_pfn(page) : 0);
+        return 0;
+    }
+
+    // 计数已为 0 时不再减少；其他处理器同时修改时比较交换失败，用新值重试
+    uint16_t old = __atomic_load_n(&page->refcount, __ATOMIC_RELAXED);
+    while (old > 0 && !__atomic_compare_exchange_n(&page->refcount, &old, old - 1, 0,
+                                                   __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    }
+    return old > 0 ? old - 1 : 0;
+}
+
+// 获取引用计数
+uint32_t page_ref_count(page_t* page)
+{
+    if (!page || !(page->flags & PG_HEAD)) {
+        return 0;
+    }
+    return __atomic_load_n(&page->refcount, __ATOMIC_ACQUIRE);
+}
+
+// 初始化链表
+void page_list_init(page_list_t* list)
+{
+    list->head = NULL;
+    list->count = 0;
+}
+
+// 将描述符加入链表头部
+void page_list_add(page_list_t* list, page_t* page)
+{
+    page->prev = NULL;
+    page->next = list->head;
+
+    if (list->head) {
+        list->head->prev = page;
+    }
+    list->head = page;
+    list->count++;
+}
+
+// 将描述符从链表中移除
+void page_list_remove(page_list_t* list, page_t* page)
+{
+    if (page->prev) {
+        page->prev->next = page->next;
+    } else {
+        list->head = page->next;
+    }
+
+    if (page->next) {
+        page->next->prev = page->prev;
+    }
+
+    page->next = NULL;
+    page->prev = NULL;
+    list->count--;
+}
+
+// 取出链表头部的描述符，链表为空时返回 NULL
+page_t* page_list_pop(page_list_t* list)
+{
+    page_t* page = list->head;
+    if (page) {
+        page_list_remove(list, page);
+    }
+    return page;
+}
@@ -1,101 +1,316 @@
 #include <mm/paging.h>
+#include <mm/buddy.h>
+#include <mm/page.h>
+#include <mm/zeropool.h>
+#include <mm/memmap.h>
 #include <string.h>
+#include <common.h>
+#include <stdbool.h>
 #include <vga.h>
 #include <serial.h>
+#include <spinlock.h>
+#include <proc/smp.h>
 
 // 物理帧分配器状态
 static frame_allocator_t frame_allocator = {0};
 
-// 全局页目录指针
-static page_directory_t* kernel_page_dir = NULL;
+// 内核页目录（位于直接映射内，虚拟地址即物理地址）
+static page_entry_t* kernel_page_dir = NULL;
+
+// 内核直接映射的结束地址
+static uint32_t direct_map_end = 0;
 
 // 初始化物理帧分配器
 static void init_frame_allocator(void)
 {
-    // 假设我们有 128MB 物理内存
-    uint32_t total_memory = 128 * 1024 * 1024;
-    frame_allocator.total_frames = total_memory / PAGE_SIZE;
-    frame_allocator.used_frames = 0;
-    
-    // 分配帧位图（每个帧占用 1 位）
-    uint32_t bitmap_size = (frame_allocator.total_frames + 31) / 32;
-    frame_allocator.frame_bitmap = (uint32_t*)0x100000; // 使用 1MB 处的内存
+    // 根据引导加载器提供的内存图确定物理内存大小
+    uint32_t highest = memmap_highest_usable();
+    frame_allocator.total_frames = highest / PAGE_SIZE;
+    frame_allocator.usable_frames = memmap_usable_bytes() / PAGE_SIZE;
     
-    // 初始化位图为 0（所有帧可用）
-    memset(frame_allocator.frame_bitmap, 0, bitmap_size * sizeof(uint32_t));
+    // 直接映射覆盖物理内存的低端部分（按 4MB 对齐），其余帧属于高端内存
+    direct_map_end = MIN(ALIGN_UP(highest, LARGE_PAGE_SIZE), KERNEL_DIRECT_MAP_END);
     
-    // 标记前 1MB 内存为已使用（包含内核代码和数据）
-    uint32_t reserved_frames = 0x100000 / PAGE_SIZE;
-    for (uint32_t i = 0; i < reserved_frames; i++) {
-        frame_allocator.frame_bitmap[i / 32] |= (1 << (i % 32));
+    // 物理帧描述符数组必须位于直接映射内
+    uint32_t mem_map_size = page_array_size(frame_allocator.total_frames);
+    uint32_t mem_map_addr = memmap_alloc_early(mem_map_size, PAGE_SIZE, direct_map_end);
+    if (!mem_map_addr) {
+        kprintf("[ERROR] Failed to place page descriptor array!\n");
+        return;
     }
-    frame_allocator.used_frames = reserved_frames;
+    page_array_init((void*)mem_map_addr, frame_allocator.total_frames);
+    buddy_init(frame_allocator.total_frames, direct_map_end / PAGE_SIZE);
+    
+    // 只将可用且未被内核、模块和元数据占用的帧交给伙伴分配器
+    memmap_for_each_free(buddy_free_range);
+    frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
     
     kprintf("[PAGING] Frame allocator initialized: %d total frames, %d used, %d free\n", 
-            frame_allocator.total_frames, frame_allocator.used_frames, 
-            frame_allocator.total_frames - frame_allocator.used_frames);
+            frame_allocator.usable_frames, frame_allocator.used_frames, 
+            frame_allocator.usable_frames - frame_allocator.used_frames);
+    kprintf("[PAGING] Page descriptors: %d KB at 0x%x\n", mem_map_size / 1024, mem_map_addr);
 }
 
-// 分配一个物理帧
-uint32_t alloc_frame(void)
+// 回收可立即释放的帧：预清零池中的帧和内核堆末尾的空闲页，返回回收的帧数
+static uint32_t reclaim_frames(void)
 {
-    // 遍历帧位图，寻找第一个可用帧
-    for (uint32_t i = 0; i < frame_allocator.total_frames; i++) {
-        uint32_t bitmap_idx = i / 32;
-        uint32_t bit_idx = i % 32;
-        
-        if (!(frame_allocator.frame_bitmap[bitmap_idx] & (1 << bit_idx))) {
-            // 标记帧为已使用
-            frame_allocator.frame_bitmap[bitmap_idx] |= (1 << bit_idx);
-            frame_allocator.used_frames++;
-            return i;
-        }
+    uint32_t reclaimed = zero_pool_drain();
+    reclaimed += kheap_trim();
+    return reclaimed;
+}
+
+// 分配 2^order 个连续物理帧（位于直接映射内），返回首帧帧号
+uint32_t alloc_frames(uint32_t order)
+{
+    uint32_t frame = buddy_alloc(order, BUDDY_ZONE_NORMAL);
+    
+    // 内存不足时先收回预清零池中的帧和内核堆末尾的空闲页再重试
+    if (frame == 0 && reclaim_frames() > 0) {
+        frame = buddy_alloc(order, BUDDY_ZONE_NORMAL);
     }
     
-    // 没有可用帧
-    kprintf("[ERROR] No free frames available!\n");
-    return 0;
+    if (frame == 0) {
+        kprintf("[ERROR] No free frames available for order %d!\n", order);
+        return 0;
+    }
+    
+    frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
+    return frame;
 }
 
-// 释放一个物理帧
-void free_frame(uint32_t frame)
+// 释放 alloc_frames 分配的连续物理帧（共享的帧只减少引用计数）
+void free_frames(uint32_t frame, uint32_t order)
 {
     if (frame >= frame_allocator.total_frames) {
         kprintf("[ERROR] Invalid frame number: %d\n", frame);
         return;
     }
     
-    // 标记帧为可用
-    uint32_t bitmap_idx = frame / 32;
-    uint32_t bit_idx = frame % 32;
-    
-    if (!(frame_allocator.frame_bitmap[bitmap_idx] & (1 << bit_idx))) {
-        kprintf("[ERROR] Frame %d is not allocated!\n", frame);
+    if (page_ref_put(pfn_to_page(frame)) > 0) {
         return;
     }
     
-    frame_allocator.frame_bitmap[bitmap_idx] &= ~(1 << bit_idx);
-    frame_allocator.used_frames--;
+    buddy_free(frame, order);
+    frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
 }
 
-// 初始化页表
-static page_table_t* create_page_table(void)
+// 分配一个物理帧
+uint32_t alloc_frame(void)
 {
-    // 分配一个物理帧用于页表
-    uint32_t frame = alloc_frame();
+    return alloc_frames(0);
+}
+
+// 释放一个物理帧
+void free_frame(uint32_t frame)
+{
+    free_frames(frame, 0);
+}
+
+// 分配一个物理帧，优先使用高端内存
+uint32_t alloc_frame_high(void)
+{
+    uint32_t frame = buddy_alloc(0, BUDDY_ZONE_HIGH);
+    if (frame == 0) {
+        frame = buddy_alloc(0, BUDDY_ZONE_NORMAL);
+    }
+    
+    // 两个区域都耗尽时回收后重试（内核堆收缩释放的帧可能属于任一区域）
+    if (frame == 0 && reclaim_frames() > 0) {
+        frame = buddy_alloc(0, BUDDY_ZONE_HIGH);
+        if (frame == 0) {
+            frame = buddy_alloc(0, BUDDY_ZONE_NORMAL);
+        }
+    }
+    
+    if (frame == 0) {
+        kprintf("[ERROR] No free frames available!\n");
+        return 0;
+    }
+    
+    frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
+    return frame;
+}
+
+// 从指定区域分配一个物理帧，不回退到其他区域，失败时不打印错误
+uint32_t alloc_frame_zone(uint32_t zone)
+{
+    uint32_t frame = buddy_alloc(0, zone);
+    if (frame != 0) {
+        frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
+    }
+    return frame;
+}
+
+// 增加物理帧的引用计数（多个映射共享同一帧时使用）
+void frame_ref(uint32_t frame)
+{
+    page_ref_get(pfn_to_page(frame));
+}
+
+// 获取物理帧的引用计数
+uint32_t frame_refcount(uint32_t frame)
+{
+    return page_ref_count(pfn_to_page(frame));
+}
+
+// 创建页表
+static page_entry_t* create_page_table(void)
+{
+    // 分配一个已清零的物理帧用于页表（位于直接映射内，可直接访问）
+    uint32_t frame = alloc_zeroed_frame(BUDDY_ZONE_NORMAL);
     if (frame == 0) {
         kprintf("[ERROR] Failed to allocate frame for page table!\n");
         return NULL;
     }
     
-    // 获取页表的物理地址
-    uint32_t phys_addr = frame * PAGE_SIZE;
+    return (page_entry_t*)(frame * PAGE_SIZE);
+}
+
+// 判断地址是否属于内核空间（所有地址空间共享，映射为全局页）
+static bool is_kernel_addr(uint32_t addr)
+{
+    return addr < KERNEL_DIRECT_MAP_END || addr >= KERNEL_VIRT_START;
+}
+
+// 当前装入 CR3 的页目录（页目录位于直接映射内，物理地址即虚拟地址）
+static page_entry_t* current_dir(void)
+{
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %%eax" : "=a" (cr3));
+    return (page_entry_t*)(cr3 & PAGE_FRAME_MASK);
+}
+
+// 获取虚拟地址所在的页表，必要时创建用户页表
+// 内核空间的页目录项在启动后不再改变：直接映射使用大页，内核虚拟地址的页表已预先分配
+static page_entry_t* get_page_table(page_entry_t* dir, uint32_t addr, bool create, uint32_t flags)
+{
+    uint32_t dir_idx = addr >> 22; // 高 10 位
+    page_entry_t pde = dir[dir_idx];
+    
+    if (pde & PAGE_LARGE) {
+        return NULL;
+    }
+    
+    if (!(pde & PAGE_PRESENT)) {
+        if (!create || is_kernel_addr(addr)) {
+            return NULL;
+        }
+        
+        page_entry_t* page_table = create_page_table();
+        if (!page_table) {
+            return NULL;
+        }
+        
+        // 页目录项保持宽松权限，实际权限由页表项控制
+        dir[dir_idx] = (uint32_t)page_table | PAGE_PRESENT | PAGE_WRITABLE | (flags & PAGE_USER);
+        return page_table;
+    }
+    
+    if ((flags & PAGE_USER) && !(pde & PAGE_USER) && !is_kernel_addr(addr)) {
+        dir[dir_idx] |= PAGE_USER;
+    }
+    
+    return (page_entry_t*)(pde & PAGE_FRAME_MASK);
+}
+
+// 获取当前页目录中虚拟地址对应的页表项，页表不存在时返回 NULL
+page_entry_t* paging_get_pte(void* virtual_addr)
+{
+    uint32_t addr = (uint32_t)virtual_addr;
+    page_entry_t* page_table = get_page_table(current_dir(), addr, false, 0);
+    if (!page_table) {
+        return NULL;
+    }
+    return &page_table[(addr >> 12) & 0x3FF];
+}
+
+// 临时映射期间保存的 EFLAGS（持有 kmap_lock 时有效）
+static uint32_t kmap_saved_flags = 0;
+static spinlock_t kmap_lock = SPINLOCK_INIT;
+
+// 将物理页临时映射到内核固定地址（单槽位，不可嵌套使用）
+// 映射期间关闭中断并持有锁，避免本处理器被抢占或其他处理器复用同一槽位
+// 每次映射都刷新本处理器的 TLB 项，其他处理器上残留的旧项在它们下次映射时刷新
+void* kmap_temp(uint32_t physical_addr)
+{
+    uint32_t flags = spin_lock_irqsave(&kmap_lock);
+    kmap_saved_flags = flags;
+    
+    page_entry_t* pte = paging_get_pte((void*)KMAP_TEMP_ADDR);
+    *pte = (physical_addr & PAGE_FRAME_MASK) | PAGE_PRESENT | PAGE_WRITABLE | PAGE_GLOBAL;
+    tlb_flush_page((void*)KMAP_TEMP_ADDR);
+    return (void*)KMAP_TEMP_ADDR;
+}
+
+// 解除临时映射（不释放物理帧）
+void kunmap_temp(void)
+{
+    page_entry_t* pte = paging_get_pte((void*)KMAP_TEMP_ADDR);
+    *pte = 0;
+    tlb_flush_page((void*)KMAP_TEMP_ADDR);
     
-    // 将页表清零
-    memset((void*)phys_addr, 0, PAGE_SIZE);
+    spin_unlock_irqrestore(&kmap_lock, kmap_saved_flags);
+}
+
+// 将物理帧清零：直接映射内的帧直接访问，高端帧通过临时映射访问
+void clear_frame(uint32_t frame)
+{
+    uint32_t phys_addr = frame * PAGE_SIZE;
     
-    // 返回页表的虚拟地址
-    return (page_table_t*)phys_addr;
+    if (phys_addr < direct_map_end) {
+        memset((void*)phys_addr, 0, PAGE_SIZE);
+    } else {
+        memset(kmap_temp(phys_addr), 0, PAGE_SIZE);
+        kunmap_temp();
+    }
+}
+
+// 刷新单页的 TLB 项（invlpg 对全局页同样有效）
+void tlb_flush_page(void* virtual_addr)
+{
+    asm volatile("invlpg (%0)" : : "r" (virtual_addr) : "memory");
+}
+
+// 重载 CR3：刷新用户空间的 TLB 项，内核全局页保留
+void tlb_flush_user(void)
+{
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %%eax" : "=a" (cr3));
+    asm volatile("mov %%eax, %%cr3" : : "a" (cr3) : "memory");
+}
+
+// 刷新全部 TLB：清除再恢复 CR4.PGE 会使包括全局页在内的所有 TLB 项失效
+void tlb_flush_all(void)
+{
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %%eax" : "=a" (cr4));
+    asm volatile("mov %%eax, %%cr4" : : "a" (cr4 & ~CR4_PGE) : "memory");
+    asm volatile("mov %%eax, %%cr4" : : "a" (cr4) : "memory");
+}
+
+// 刷新本处理器上 [start, end) 的 TLB 项：页数超过阈值时整体刷新（内核页为全局页，需要刷新全部）
+void tlb_flush_kernel_range(uint32_t start, uint32_t end)
+{
+    if ((end - start) / PAGE_SIZE > TLB_FLUSH_THRESHOLD) {
+        tlb_flush_all();
+        return;
+    }
+    for (uint32_t addr = start; addr < end; addr += PAGE_SIZE) {
+        tlb_flush_page((void*)addr);
+    }
+}
+
+// 开关全局页支持（切换 CR4.PGE 会同时刷新全部 TLB）
+void paging_set_global_pages(bool enable)
+{
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %%eax" : "=a" (cr4));
+    if (enable) {
+        cr4 |= CR4_PGE;
+    } else {
+        cr4 &= ~CR4_PGE;
+    }
+    asm volatile("mov %%eax, %%cr4" : : "a" (cr4) : "memory");
 }
 
 // 初始化分页机制
@@ -105,97 +320,200 @@ void init_paging(void)
     init_frame_allocator();
     
     // 分配页目录
-    kernel_page_dir = (page_directory_t*)alloc_frame() * PAGE_SIZE;
+    kernel_page_dir = (page_entry_t*)(alloc_frame() * PAGE_SIZE);
     memset(kernel_page_dir, 0, PAGE_SIZE);
     
-    // 映射前 4MB 物理内存到相同的虚拟地址
-    for (uint32_t i = 0; i < 1024; i++) {
-        // 创建页表
-        page_table_t* page_table = create_page_table();
+    // 用 4MB 全局大页恒等映射内核直接映射区，不需要任何页表
+    for (uint32_t addr = 0; addr < direct_map_end; addr += LARGE_PAGE_SIZE) {
+        kernel_page_dir[addr >> 22] = addr | PAGE_PRESENT | PAGE_WRITABLE | PAGE_LARGE | PAGE_GLOBAL;
+    }
+    
+    // 预先分配内核虚拟地址区的全部页表，所有地址空间共享这些页表，
+    // 之后内核映射的变化无需同步到各个进程的页目录
+    for (uint32_t idx = KERNEL_VIRT_START >> 22; idx < PAGE_DIR_ENTRIES; idx++) {
+        page_entry_t* page_table = create_page_table();
         if (!page_table) {
-            kprintf("[ERROR] Failed to create page table!\n");
+            kprintf("[ERROR] Failed to allocate shared kernel page tables!\n");
             return;
         }
-        
-        // 将页表的物理地址添加到页目录
-        uint32_t table_phys = ((uint32_t)page_table) & 0xFFFFF000;
-        kernel_page_dir[i] = table_phys | PAGE_PRESENT | PAGE_WRITABLE;
-        
-        // 映射页表中的所有页
-        for (uint32_t j = 0; j < PAGE_TABLE_ENTRIES; j++) {
-            uint32_t phys_addr = (i * PAGE_TABLE_ENTRIES + j) * PAGE_SIZE;
-            page_table[j] = phys_addr | PAGE_PRESENT | PAGE_WRITABLE;
-        }
+        kernel_page_dir[idx] = (uint32_t)page_table | PAGE_PRESENT | PAGE_WRITABLE;
     }
     
+    // 启用 PSE 和全局页
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %%eax" : "=a" (cr4));
+    cr4 |= CR4_PSE | CR4_PGE;
+    asm volatile("mov %%eax, %%cr4" : : "a" (cr4));
+    
+    // 加载页目录
+    asm volatile("mov %%eax, %%cr3" : : "a" (kernel_page_dir));
+    
     // 启用分页
     uint32_t cr0;
     asm volatile("mov %%cr0, %%eax" : "=a" (cr0));
     cr0 |= 0x80000000; // 设置 CR0.PG 位
+    cr0 |= 0x00010000; // 设置 CR0.WP 位：内核写只读用户页同样触发缺页（写时复制依赖此位）
     asm volatile("mov %%eax, %%cr0" : : "a" (cr0));
     
-    kprintf("[PAGING] Paging enabled with %dMB memory mapped\n", 4);
+    kprintf("[PAGING] Paging enabled with %dMB direct-mapped using 4MB pages, %d shared kernel page tables\n",
+            direct_map_end / (1024 * 1024), PAGE_DIR_ENTRIES - (KERNEL_VIRT_START >> 22));
 }
 
 // 映射一个虚拟地址到物理地址
 void map_page(void* virtual_addr, uint32_t physical_addr, uint32_t flags)
 {
     uint32_t addr = (uint32_t)virtual_addr;
-    uint32_t dir_idx = addr >> 22; // 高 10 位
     uint32_t table_idx = (addr >> 12) & 0x3FF; // 中间 10 位
     
-    // 检查页目录项是否存在
-    if (!(kernel_page_dir[dir_idx] & PAGE_PRESENT)) {
-        // 创建新的页表
-        page_table_t* page_table = create_page_table();
-        if (!page_table) {
-            kprintf("[ERROR] Failed to create page table for mapping!\n");
-            return;
-        }
-        
-        // 将页表的物理地址添加到页目录
-        uint32_t table_phys = ((uint32_t)page_table) & 0xFFFFF000;
-        kernel_page_dir[dir_idx] = table_phys | PAGE_PRESENT | flags;
+    // 获取页表（内核直接映射区不可重新映射）
+    page_entry_t* page_table = get_page_table(current_dir(), addr, true, flags);
+    if (!page_table) {
+        kprintf("[ERROR] Failed to get page table for mapping 0x%x!\n", addr);
+        return;
     }
     
-    // 获取页表的物理地址并转换为虚拟地址
-    uint32_t table_phys = kernel_page_dir[dir_idx] & 0xFFFFF000;
-    page_table_t* page_table = (page_table_t*)table_phys;
+    // 内核空间的映射在所有地址空间中相同，标记为全局页
+    if (is_kernel_addr(addr)) {
+        flags |= PAGE_GLOBAL;
+    }
     
     // 映射页
-    page_table[table_idx] = (physical_addr & 0xFFFFF000) | flags | PAGE_PRESENT;
+    page_table[table_idx] = (physical_addr & PAGE_FRAME_MASK) | flags | PAGE_PRESENT;
     
     // 刷新 TLB
-    asm volatile("invlpg (%0)" : : "r" (virtual_addr));
+    tlb_flush_page(virtual_addr);
 }
 
 // 取消映射一个虚拟地址
 void unmap_page(void* virtual_addr)
 {
-    uint32_t addr = (uint32_t)virtual_addr;
-    uint32_t dir_idx = addr >> 22;
-    uint32_t table_idx = (addr >> 12) & 0x3FF;
+    unmap_range(virtual_addr, PAGE_SIZE);
+}
+
+// 范围内当前页表覆盖部分的结束地址（注意 4GB 处回绕）
+static uint32_t table_range_end(uint32_t addr, uint32_t end)
+{
+    uint32_t table_end = ALIGN_DOWN(addr, LARGE_PAGE_SIZE) + LARGE_PAGE_SIZE;
+    return (table_end == 0 || table_end > end) ? end : table_end;
+}
+
+// 范围较大时整体刷新 TLB，否则已逐页 invlpg
+// 内核映射在所有处理器间共享，还要让其他处理器刷新；用户映射只属于当前地址空间，切换时已刷新
+static void tlb_flush_range(uint32_t start, uint32_t end, uint32_t pages)
+{
+    if (pages == 0) {
+        return;
+    }
     
-    if (!(kernel_page_dir[dir_idx] & PAGE_PRESENT)) {
-        return; // 页目录项不存在
+    bool kernel = is_kernel_addr(start) || is_kernel_addr(end - 1);
+    if (kernel) {
+        smp_tlb_shootdown(start, end);
     }
     
-    // 获取页表
-    uint32_t table_phys = kernel_page_dir[dir_idx] & 0xFFFFF000;
-    page_table_t* page_table = (page_table_t*)table_phys;
-    
-    // 检查页表项是否存在
-    if (page_table[table_idx] & PAGE_PRESENT) {
-        // 释放物理帧
-        uint32_t frame = (page_table[table_idx] & 0xFFFFF000) / PAGE_SIZE;
-        free_frame(frame);
+    if (pages <= TLB_FLUSH_THRESHOLD) {
+        return;
+    }
+    
+    // 内核空间为全局页，重载 CR3 无法刷新
+    if (kernel) {
+        tlb_flush_all();
+    } else {
+        tlb_flush_user();
+    }
+}
+
+// 批量映射连续物理内存，每个页表只查找一次
+int map_range(void* virtual_addr, uint32_t physical_addr, size_t size, uint32_t flags)
+{
+    uint32_t start = ALIGN_DOWN((uint32_t)virtual_addr, PAGE_SIZE);
+    uint32_t end = ALIGN_UP((uint32_t)virtual_addr + size, PAGE_SIZE);
+    uint32_t phys = physical_addr & PAGE_FRAME_MASK;
+    page_entry_t* dir = current_dir();
+    uint32_t replaced = 0;
+    
+    // 内核空间的映射在所有地址空间中相同，标记为全局页
+    if (is_kernel_addr(start)) {
+        flags |= PAGE_GLOBAL;
+    }
+    
+    uint32_t addr = start;
+    while (addr < end) {
+        uint32_t table_end = table_range_end(addr, end);
+        page_entry_t* page_table = get_page_table(dir, addr, true, flags);
+        if (!page_table) {
+            kprintf("[ERROR] Failed to get page table for mapping 0x%x!\n", addr);
+            tlb_flush_range(start, addr, replaced);
+            return -1;
+        }
+        
+        for (; addr < table_end; addr += PAGE_SIZE, phys += PAGE_SIZE) {
+            page_entry_t* pte = &page_table[(addr >> 12) & 0x3FF];
+            
+            // 新建的映射不会留在 TLB 中，只有覆盖已有映射时才需要刷新
+            if (*pte & PAGE_PRESENT) {
+                if (++replaced <= TLB_FLUSH_THRESHOLD) {
+                    tlb_flush_page((void*)addr);
+                }
+            }
+            *pte = phys | flags | PAGE_PRESENT;
+        }
+    }
+    
+    tlb_flush_range(start, end, replaced);
+    return 0;
+}
+
+// 批量取消映射，每个页表只查找一次；释放的帧先收集起来，TLB 刷新之后才归还分配器
+uint32_t unmap_range(void* virtual_addr, size_t size)
+{
+    uint32_t start = ALIGN_DOWN((uint32_t)virtual_addr, PAGE_SIZE);
+    uint32_t end = ALIGN_UP((uint32_t)virtual_addr + size, PAGE_SIZE);
+    page_entry_t* dir = current_dir();
+    page_list_t gather;
+    uint32_t unmapped = 0;
+    
+    page_list_init(&gather);
+    
+    uint32_t addr = start;
+    while (addr < end) {
+        uint32_t table_end = table_range_end(addr, end);
         
-        // 取消映射
-        page_table[table_idx] = 0;
+        // 页目录项不存在或属于直接映射时跳过整个页表
+        page_entry_t* page_table = get_page_table(dir, addr, false, 0);
+        if (!page_table) {
+            addr = table_end;
+            continue;
+        }
         
-        // 刷新 TLB
-        asm volatile("invlpg (%0)" : : "r" (virtual_addr));
+        for (; addr < table_end; addr += PAGE_SIZE) {
+            page_entry_t* pte = &page_table[(addr >> 12) & 0x3FF];
+            if (!(*pte & PAGE_PRESENT)) {
+                continue;
+            }
+            
+            // 共享的帧只减少引用计数，最后一个引用才收集起来等待释放
+            page_t* page = pfn_to_page(*pte >> 12);
+            if (page && (page->flags & PG_HEAD) && page_ref_put(page) == 0) {
+                page_list_add(&gather, page);
+            }
+            *pte = 0;
+            
+            if (++unmapped <= TLB_FLUSH_THRESHOLD) {
+                tlb_flush_page((void*)addr);
+            }
+        }
     }
+    
+    tlb_flush_range(start, end, unmapped);
+    
+    // TLB 中已没有指向这些帧的项，可以安全归还
+    page_t* page;
+    while ((page = page_list_pop(&gather)) != NULL) {
+        buddy_free(page_to_pfn(page), page->order);
+    }
+    frame_allocator.used_frames = frame_allocator.usable_frames - buddy_free_frames();
+    
+    return unmapped;
 }
 
 // 获取虚拟地址对应的物理地址
@@ -204,21 +522,26 @@ uint32_t get_physical_addr(void* virtual_addr)
     uint32_t addr = (uint32_t)virtual_addr;
     uint32_t dir_idx = addr >> 22;
     uint32_t table_idx = (addr >> 12) & 0x3FF;
+    page_entry_t pde = current_dir()[dir_idx];
     
-    if (!(kernel_page_dir[dir_idx] & PAGE_PRESENT)) {
+    if (!(pde & PAGE_PRESENT)) {
         return 0; // 页目录项不存在
     }
     
+    // 4MB 大页：直接由页目录项给出物理地址
+    if (pde & PAGE_LARGE) {
+        return (pde & LARGE_PAGE_FRAME_MASK) + (addr & (LARGE_PAGE_SIZE - 1));
+    }
+    
     // 获取页表
-    uint32_t table_phys = kernel_page_dir[dir_idx] & 0xFFFFF000;
-    page_table_t* page_table = (page_table_t*)table_phys;
+    page_entry_t* page_table = (page_entry_t*)(pde & PAGE_FRAME_MASK);
     
     if (!(page_table[table_idx] & PAGE_PRESENT)) {
         return 0; // 页表项不存在
     }
     
     // 返回物理地址
-    uint32_t phys_page = page_table[table_idx] & 0xFFFFF000;
+    uint32_t phys_page = page_table[table_idx] & PAGE_FRAME_MASK;
     uint32_t offset = addr & 0x00000FFF;
     
     return phys_page + offset;
@@ -227,7 +550,7 @@ uint32_t get_physical_addr(void* virtual_addr)
 // 获取总物理内存大小
 size_t get_total_memory(void)
 {
-    return frame_allocator.total_frames * PAGE_SIZE;
+    return frame_allocator.usable_frames * PAGE_SIZE;
 }
 
 // 获取已使用的物理内存大小
@@ -239,11 +562,121 @@ size_t get_used_memory(void)
 // 获取可用的物理内存大小
 size_t get_free_memory(void)
 {
-    return (frame_allocator.total_frames - frame_allocator.used_frames) * PAGE_SIZE;
+    return (frame_allocator.usable_frames - frame_allocator.used_frames) * PAGE_SIZE;
+}
+
+// 创建新的页目录：独占一个物理帧，内核部分的页目录项指向共享的内核页表
+page_directory_t* paging_create_dir(void)
+{
+    uint32_t frame = alloc_frame();
+    if (frame == 0) {
+        kprintf("[ERROR] Failed to allocate frame for page directory!\n");
+        return NULL;
+    }
+    
+    page_entry_t* dir = (page_entry_t*)(frame * PAGE_SIZE);
+    uint32_t user_start = USER_SPACE_START >> 22;
+    uint32_t user_end = USER_SPACE_END >> 22;
+    
+    // 只复制内核部分的页目录项（启动后不再改变），用户部分清零
+    memcpy(dir, kernel_page_dir, user_start * sizeof(page_entry_t));
+    memset(dir + user_start, 0, (user_end - user_start) * sizeof(page_entry_t));
+    memcpy(dir + user_end, kernel_page_dir + user_end, (PAGE_DIR_ENTRIES - user_end) * sizeof(page_entry_t));
+    
+    return (page_directory_t*)dir;
+}
+
+// 复制页目录用于 fork：共享所有用户页，可写页在双方都改为只读并标记写时复制
+page_directory_t* paging_clone_dir(page_directory_t* page_dir)
+{
+    page_entry_t* src = (page_entry_t*)page_dir;
+    page_entry_t* dst = (page_entry_t*)paging_create_dir();
+    if (!dst) {
+        return NULL;
+    }
+    
+    for (uint32_t idx = USER_SPACE_START >> 22; idx < (USER_SPACE_END >> 22); idx++) {
+        if (!(src[idx] & PAGE_PRESENT)) {
+            continue;
+        }
+        
+        page_entry_t* src_table = (page_entry_t*)(src[idx] & PAGE_FRAME_MASK);
+        page_entry_t* dst_table = create_page_table();
+        if (!dst_table) {
+            paging_destroy_dir((page_directory_t*)dst);
+            return NULL;
+        }
+        dst[idx] = (uint32_t)dst_table | (src[idx] & 0xFFF);
+        
+        for (uint32_t i = 0; i < PAGE_TABLE_ENTRIES; i++) {
+            page_entry_t pte = src_table[i];
+            if (!(pte & PAGE_PRESENT)) {
+                continue;
+            }
+            
+            if (pte & PAGE_WRITABLE) {
+                pte = (pte & ~PAGE_WRITABLE) | PAGE_COW;
+                src_table[i] = pte;
+            }
+            dst_table[i] = pte;
+            frame_ref((pte & PAGE_FRAME_MASK) / PAGE_SIZE);
+        }
+    }
+    
+    // 源地址空间的可写页已改为只读，需要刷新其 TLB
+    if (src == current_dir()) {
+        tlb_flush_user();
+    }
+    
+    return (page_directory_t*)dst;
+}
+
+// 释放页目录及其用户页表，并释放对用户页映射的物理帧的引用
+void paging_destroy_dir(page_directory_t* page_dir)
+{
+    page_entry_t* dir = (page_entry_t*)page_dir;
+    if (!dir || dir == kernel_page_dir) {
+        return;
+    }
+    
+    // 不能释放正在使用的页目录，先切换回内核页目录
+    if (current_dir() == dir) {
+        paging_switch_dir(get_kernel_page_dir());
+    }
+    
+    for (uint32_t idx = USER_SPACE_START >> 22; idx < (USER_SPACE_END >> 22); idx++) {
+        if (!(dir[idx] & PAGE_PRESENT)) {
+            continue;
+        }
+        
+        page_entry_t* page_table = (page_entry_t*)(dir[idx] & PAGE_FRAME_MASK);
+        for (uint32_t i = 0; i < PAGE_TABLE_ENTRIES; i++) {
+            if (page_table[i] & PAGE_PRESENT) {
+                free_frame((page_table[i] & PAGE_FRAME_MASK) / PAGE_SIZE);
+            }
+        }
+        free_frame((uint32_t)page_table / PAGE_SIZE);
+    }
+    
+    free_frame((uint32_t)dir / PAGE_SIZE);
+}
+
+// 切换到指定页目录（内核全局页的 TLB 项保留）
+void paging_switch_dir(page_directory_t* page_dir)
+{
+    if ((page_entry_t*)page_dir != current_dir()) {
+        asm volatile("mov %%eax, %%cr3" : : "a" (page_dir) : "memory");
+    }
+}
+
+// 获取当前页目录
+page_directory_t* paging_current_dir(void)
+{
+    return (page_directory_t*)current_dir();
 }
 
 // 获取内核页目录
 page_directory_t* get_kernel_page_dir(void)
 {
-    return kernel_page_dir;
+    return (page_directory_t*)kernel_page_dir;
 }
@@ -0,0 +1,122 @@
+#include <mm/scratch.h>
+#include <mm/paging.h>
+#include <mm/buddy.h>
+#include <proc/task.h>
+#include <string.h>
+#include <common.h>
+#include <vga.h>
+
+// 调度器启动前使用的临时区
+static scratch_arena_t boot_arena = {0};
+
+// 当前进程的临时区
+static scratch_arena_t* scratch_current(void)
+{
+    task_t* task = get_current_task();
+    return task ? &task->scratch : &boot_arena;
+}
+
+// 初始化临时区
+void scratch_init(scratch_arena_t* arena)
+{
+    memset(arena, 0, sizeof(scratch_arena_t));
+}
+
+// 申请能容纳 size 字节的新内存块并放在链表头
+static scratch_chunk_t* chunk_alloc(scratch_arena_t* arena, size_t size)
+{
+    uint32_t pages = ALIGN_UP(size + sizeof(scratch_chunk_t), PAGE_SIZE) / PAGE_SIZE;
+    uint32_t order = buddy_order_for(pages);
+
+    // 块位于 NORMAL 区域，物理地址即内核直接映射地址
+    uint32_t frame = alloc_frames(order);
+    if (frame == 0) {
+        return NULL;
+    }
+
+    scratch_chunk_t* chunk = (scratch_chunk_t*)(frame * PAGE_SIZE);
+    chunk->next = arena->chunk;
+    chunk->size = PAGE_SIZE << order;
+    chunk->used = sizeof(scratch_chunk_t);
+    chunk->order = order;
+    arena->chunk = chunk;
+    return chunk;
+}
+
+// 分配临时内存：当前块放不下时链接一个新块，原块中剩余的空间不再使用
+void* scratch_alloc(size_t size)
+{
+    if (size == 0 || size > SCRATCH_MAX_SIZE) {
+        return NULL;
+    }
+
+    scratch_arena_t* arena = scratch_current();
+    size = ALIGN_UP(size, SCRATCH_ALIGN);
+
+    scratch_chunk_t* chunk = arena->chunk;
+    if (!chunk || chunk->size - chunk->used < size) {
+        if (chunk) {
+            arena->overflows++;
+        }
+        chunk = chunk_alloc(arena, size);
+        if (!chunk) {
+            kprintf("[SCRATCH] Out of memory allocating %d bytes\n", size);
+            return NULL;
+        }
+    }
+
+    void* ptr = (uint8_t*)chunk + chunk->used;
+    chunk->used += size;
+    arena->bytes += size;
+    arena->peak = MAX(arena->peak, arena->bytes);
+    return ptr;
+}
+
+// 在临时区中复制内存
+void* scratch_memdup(const void* src, size_t size)
+{
+    void* copy = scratch_alloc(size);
+    if (copy) {
+        memcpy(copy, src, size);
+    }
+    return copy;
+}
+
+// 在临时区中复制字符串
+char* scratch_strdup(const char* str)
+{
+    return (char*)scratch_memdup(str, strlen(str) + 1);
+}
+
+// 重置当前进程的临时区
+void scratch_reset(void)
+{
+    scratch_arena_t* arena = scratch_current();
+    scratch_chunk_t* chunk = arena->chunk;
+    if (!chunk) {
+        return;
+    }
+
+    // 只保留最早的一块（通常为一页），大多数请求无需再申请帧
+    while (chunk->next) {
+        scratch_chunk_t* next = chunk->next;
+        free_frames((uint32_t)chunk / PAGE_SIZE, chunk->order);
+        chunk = next;
+    }
+    chunk->used = sizeof(scratch_chunk_t);
+    arena->chunk = chunk;
+    arena->bytes = 0;
+}
+
+// 释放临时区的全部内存块
+void scratch_release(scratch_arena_t* arena)
+{
+    scratch_chunk_t* chunk = arena->chunk;
+    while (chunk) {
+        scratch_chunk_t* next = chunk->next;
+        free_frames((uint32_t)chunk / PAGE_SIZE, chunk->order);
+        chunk = next;
+    }
+    arena->chunk = NULL;
+    arena->bytes = 0;
+}
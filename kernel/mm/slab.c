@@ -0,0 +1,370 @@
+#include <mm/slab.h>
+#include <mm/page.h>
+#include <mm/paging.h>
+#include <string.h>
+#include <common.h>
+#include <vga.h>
+
+// 空闲索引链表结束标记
+#define SLAB_END 0xFFFF
+
+// 所有缓存组成的链表
+static kmem_cache_t* cache_chain = NULL;
+static spinlock_t cache_chain_lock = SPINLOCK_INIT;
+
+// slab 头部之后的空闲索引数组：bufctl[i] 为对象 i 之后的下一个空闲对象
+static inline uint16_t* slab_bufctl(slab_t* slab)
+{
+    return (uint16_t*)(slab + 1);
+}
+
+// slab 链表操作
+static void slab_list_add(slab_list_t* list, slab_t* slab)
+{
+    slab->prev = NULL;
+    slab->next = list->head;
+    if (list->head) {
+        list->head->prev = slab;
+    }
+    list->head = slab;
+    list->count++;
+}
+
+static void slab_list_remove(slab_list_t* list, slab_t* slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        list->head = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+    list->count--;
+}
+
+// 根据已分配对象数确定 slab 应在的链表
+static slab_list_t* slab_list_for(kmem_cache_t* cache, uint32_t inuse)
+{
+    if (inuse == 0) {
+        return &cache->slabs_free;
+    }
+    if (inuse == cache->objs_per_slab) {
+        return &cache->slabs_full;
+    }
+    return &cache->slabs_partial;
+}
+
+// 计算指定阶数下每个 slab 的对象数，返回剩余（无法利用的）字节数
+static uint32_t slab_estimate(uint32_t size, uint32_t align, uint32_t order,
+                              uint32_t* objs, uint32_t* offset)
+{
+    uint32_t bytes = PAGE_SIZE << order;
+    uint32_t count = (bytes - sizeof(slab_t)) / (size + sizeof(uint16_t));
+    if (count > SLAB_END - 1) {
+        count = SLAB_END - 1;
+    }
+
+    // 对象区需按 align 对齐，对齐填充可能挤掉最后一个对象
+    uint32_t start = 0;
+    while (count > 0) {
+        start = ALIGN_UP(sizeof(slab_t) + count * sizeof(uint16_t), align);
+        if (start + count * size <= bytes) {
+            break;
+        }
+        count--;
+    }
+
+    *objs = count;
+    *offset = start;
+    return count ? bytes - start - count * size : bytes;
+}
+
+// 为缓存新建一个 slab，对象全部空闲并已构造
+static slab_t* cache_grow(kmem_cache_t* cache)
+{
+    uint32_t frame = alloc_frames(cache->order);
+    if (frame == 0) {
+        return NULL;
+    }
+
+    // slab 位于 NORMAL 区域，物理地址即内核直接映射地址
+    slab_t* slab = (slab_t*)(frame * PAGE_SIZE);
+    uint32_t colour_unit = MAX(cache->align, SLAB_COLOUR_ALIGN);
+
+    slab->next = NULL;
+    slab->prev = NULL;
+    slab->cache = cache;
+    slab->inuse = 0;
+    slab->free = 0;
+    slab->colour_off = cache->colour_next * colour_unit;
+    slab->frame_count = 1 << cache->order;
+    slab->s_mem = (uint8_t*)slab + cache->obj_offset + slab->colour_off;
+
+    // 相邻 slab 轮流使用不同着色，使各 slab 的首个对象落在不同的缓存行
+    if (++cache->colour_next >= cache->colour_count) {
+        cache->colour_next = 0;
+    }
+
+    // 每一帧都指向所属 slab，释放对象时据此找到 slab
+    for (uint32_t i = 0; i < slab->frame_count; i++) {
+        page_t* page = pfn_to_page(frame + i);
+        page->flags |= PG_SLAB;
+        page->owner = slab;
+    }
+
+    uint16_t* bufctl = slab_bufctl(slab);
+    for (uint32_t i = 0; i < cache->objs_per_slab; i++) {
+        bufctl[i] = (i + 1 < cache->objs_per_slab) ? i + 1 : SLAB_END;
+        if (cache->ctor) {
+            cache->ctor((uint8_t*)slab->s_mem + i * cache->size);
+        }
+    }
+
+    cache->total_objs += cache->objs_per_slab;
+    cache->slabs_created++;
+    slab_list_add(&cache->slabs_free, slab);
+    return slab;
+}
+
+// 释放一个空闲 slab（调用者已将其移出链表）
+static void slab_destroy(kmem_cache_t* cache, slab_t* slab)
+{
+    uint32_t frame = (uint32_t)slab / PAGE_SIZE;
+
+    for (uint32_t i = 0; i < slab->frame_count; i++) {
+        page_t* page = pfn_to_page(frame + i);
+        page->flags &= ~PG_SLAB;
+        page->owner = NULL;
+    }
+
+    cache->total_objs -= cache->objs_per_slab;
+    cache->slabs_destroyed++;
+    free_frames(frame, cache->order);
+}
+
+// 创建对象缓存
+kmem_cache_t* kmem_cache_create(const char* name, size_t size, size_t align, kmem_ctor_t ctor)
+{
+    if (align == 0) {
+        align = SLAB_MIN_ALIGN;
+    }
+    if (size == 0 || (align & (align - 1)) != 0 || align > PAGE_SIZE) {
+        kprintf("[SLAB] Invalid cache parameters for %s\n", name);
+        return NULL;
+    }
+
+    uint32_t obj_size = ALIGN_UP(MAX(size, SLAB_MIN_ALIGN), align);
+
+    // 选择最小的阶数，使每个 slab 浪费的空间不超过 1/8
+    uint32_t order = 0;
+    uint32_t objs = 0;
+    uint32_t offset = 0;
+    uint32_t leftover = 0;
+    for (order = 0; order <= SLAB_MAX_ORDER; order++) {
+        uint32_t bytes = PAGE_SIZE << order;
+        leftover = slab_estimate(obj_size, align, order, &objs, &offset);
+        if (objs > 0 && leftover * 8 <= bytes) {
+            break;
+        }
+    }
+    if (order > SLAB_MAX_ORDER) {
+        order = SLAB_MAX_ORDER;
+    }
+    if (objs == 0) {
+        kprintf("[SLAB] Object size %d too large for cache %s\n", size, name);
+        return NULL;
+    }
+
+    kmem_cache_t* cache = (kmem_cache_t*)kmalloc(sizeof(kmem_cache_t));
+    if (!cache) {
+        kprintf("[SLAB] Failed to allocate cache %s\n", name);
+        return NULL;
+    }
+
+    memset(cache, 0, sizeof(kmem_cache_t));
+    strncpy(cache->name, name, SLAB_NAME_LEN - 1);
+    cache->object_size = size;
+    cache->size = obj_size;
+    cache->align = align;
+    cache->order = order;
+    cache->objs_per_slab = objs;
+    cache->obj_offset = offset;
+    cache->ctor = ctor;
+
+    // 剩余空间按着色步长划分为若干着色
+    cache->colour_count = leftover / MAX(align, SLAB_COLOUR_ALIGN) + 1;
+    cache->colour_next = 0;
+
+    uint32_t flags = spin_lock_irqsave(&cache_chain_lock);
+    cache->next = cache_chain;
+    cache_chain = cache;
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+
+    return cache;
+}
+
+// 释放缓存中所有空闲 slab
+uint32_t kmem_cache_shrink(kmem_cache_t* cache)
+{
+    uint32_t flags = spin_lock_irqsave(&cache->lock);
+
+    uint32_t released = 0;
+    while (cache->slabs_free.head) {
+        slab_t* slab = cache->slabs_free.head;
+        slab_list_remove(&cache->slabs_free, slab);
+        released += slab->frame_count;
+        slab_destroy(cache, slab);
+    }
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+    return released;
+}
+
+// 销毁对象缓存
+int kmem_cache_destroy(kmem_cache_t* cache)
+{
+    if (!cache) {
+        return -1;
+    }
+
+    if (cache->active_objs > 0) {
+        kprintf("[SLAB] Cannot destroy cache %s: %d objects in use\n", cache->name, cache->active_objs);
+        return -1;
+    }
+
+    kmem_cache_shrink(cache);
+
+    uint32_t flags = spin_lock_irqsave(&cache_chain_lock);
+    kmem_cache_t** link = &cache_chain;
+    while (*link && *link != cache) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = cache->next;
+    }
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+
+    kfree(cache);
+    return 0;
+}
+
+// 从缓存分配一个对象
+void* kmem_cache_alloc(kmem_cache_t* cache)
+{
+    if (!cache) {
+        return NULL;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&cache->lock);
+
+    // 优先填满部分使用的 slab，减少同时占用的 slab 数
+    slab_t* slab = cache->slabs_partial.head;
+    if (!slab) {
+        slab = cache->slabs_free.head;
+    }
+    if (!slab) {
+        slab = cache_grow(cache);
+    }
+    if (!slab) {
+        spin_unlock_irqrestore(&cache->lock, flags);
+        kprintf("[SLAB] Out of memory in cache %s\n", cache->name);
+        return NULL;
+    }
+
+    slab_list_remove(slab_list_for(cache, slab->inuse), slab);
+
+    void* obj = (uint8_t*)slab->s_mem + slab->free * cache->size;
+    slab->free = slab_bufctl(slab)[slab->free];
+    slab->inuse++;
+
+    slab_list_add(slab_list_for(cache, slab->inuse), slab);
+
+    cache->active_objs++;
+    cache->allocs++;
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+    return obj;
+}
+
+// 将对象归还给缓存
+void kmem_cache_free(kmem_cache_t* cache, void* obj)
+{
+    if (!cache || !obj) {
+        return;
+    }
+
+    page_t* page = pfn_to_page((uint32_t)obj / PAGE_SIZE);
+    slab_t* slab = (page && (page->flags & PG_SLAB)) ? (slab_t*)page->owner : NULL;
+    if (!slab || slab->cache != cache) {
+        kprintf("[SLAB] Object 0x%x does not belong to cache %s\n", (uint32_t)obj, cache->name);
+        return;
+    }
+
+    uint32_t offset = (uint8_t*)obj - (uint8_t*)slab->s_mem;
+    uint32_t index = offset / cache->size;
+    if ((uint8_t*)obj < (uint8_t*)slab->s_mem || offset % cache->size != 0 ||
+        index >= cache->objs_per_slab || slab->inuse == 0) {
+        kprintf("[SLAB] Invalid free of 0x%x in cache %s\n", (uint32_t)obj, cache->name);
+        return;
+    }
+
+    uint32_t flags = spin_lock_irqsave(&cache->lock);
+
+    slab_list_remove(slab_list_for(cache, slab->inuse), slab);
+
+    slab_bufctl(slab)[index] = slab->free;
+    slab->free = index;
+    slab->inuse--;
+
+    cache->active_objs--;
+    cache->frees++;
+
+    // 每个缓存只保留一个空闲 slab 应对分配抖动，多余的归还给伙伴分配器
+    if (slab->inuse == 0 && cache->slabs_free.count > 0) {
+        slab_destroy(cache, slab);
+    } else {
+        slab_list_add(slab_list_for(cache, slab->inuse), slab);
+    }
+
+    spin_unlock_irqrestore(&cache->lock, flags);
+}
+
+// 生成 slabinfo 格式的统计信息
+int kmem_cache_info(char* buf, size_t buf_size)
+{
+    int offset = snprintf(buf, buf_size,
+                          "# name active total objsize size objperslab pagesperslab slabs allocs frees waste\n");
+
+    uint32_t flags = spin_lock_irqsave(&cache_chain_lock);
+    for (kmem_cache_t* cache = cache_chain; cache && offset < (int)buf_size; cache = cache->next) {
+        uint32_t slabs = cache->slabs_full.count + cache->slabs_partial.count + cache->slabs_free.count;
+        uint32_t slab_bytes = slabs * (PAGE_SIZE << cache->order);
+
+        // 浪费的空间：slab 占用的内存中不属于已分配对象的部分（头部、对齐填充、着色剩余和空闲对象）
+        uint32_t waste = slab_bytes - cache->active_objs * cache->object_size;
+
+        offset += snprintf(buf + offset, buf_size - offset, "%s %d %d %d %d %d %d %d %d %d %d\n",
+                           cache->name, cache->active_objs, cache->total_objs, cache->object_size,
+                           cache->size, cache->objs_per_slab, 1 << cache->order, slabs,
+                           cache->allocs, cache->frees, waste);
+    }
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+
+    return offset;
+}
+
+// 所有缓存的 slab 占用的帧数
+uint32_t kmem_cache_frames(void)
+{
+    uint32_t frames = 0;
+    uint32_t flags = spin_lock_irqsave(&cache_chain_lock);
+    for (kmem_cache_t* cache = cache_chain; cache; cache = cache->next) {
+        uint32_t slabs = cache->slabs_full.count + cache->slabs_partial.count + cache->slabs_free.count;
+        frames += slabs << cache->order;
+    }
+    spin_unlock_irqrestore(&cache_chain_lock, flags);
+    return frames;
+}
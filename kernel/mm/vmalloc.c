@@ -0,0 +1,360 @@
+#include <mm/vmalloc.h>
+#include <mm/paging.h>
+#include <mm/slab.h>
+#include <common.h>
+#include <vga.h>
+#include <spinlock.h>
+
+// vmap_lock 保护区域链表、区域的 addr/pages 和 vmap_pages
+// 映射和取消映射（分配帧、TLB 击落）不在锁内进行：先在链表中占住地址范围再映射，取消映射之后才从链表中移除
+static spinlock_t vmap_lock = SPINLOCK_INIT;
+
+// 已分配的区域（按地址排序）
+static vmap_area_t* vmap_areas = NULL;
+
+// 区域描述符的对象缓存
+static kmem_cache_t* vmap_cache = NULL;
+
+// 已映射的页数
+static uint32_t vmap_pages = 0;
+
+// 初始化内核虚拟区域分配器
+void vmalloc_init(void)
+{
+    vmap_areas = NULL;
+    vmap_pages = 0;
+    vmap_cache = kmem_cache_create("vmap_area", sizeof(vmap_area_t), 0, NULL);
+    
+    kprintf("[VMALLOC] Kernel virtual area 0x%x-0x%x (%dMB)\n",
+            VMALLOC_START, VMALLOC_END, (VMALLOC_END - VMALLOC_START) / (1024 * 1024));
+}
+
+// 区域占用的虚拟地址范围（含保护页）
+static inline uint32_t area_end(vmap_area_t* area)
+{
+    return area->addr + area->pages * PAGE_SIZE + VMALLOC_GUARD_SIZE;
+}
+
+// 首次适配查找 span 字节的空闲虚拟地址，*prev_out 返回插入位置之前的区域，失败返回 0（调用者持有 vmap_lock）
+static uint32_t find_free_range(uint32_t span, vmap_area_t** prev_out)
+{
+    vmap_area_t* prev = NULL;
+    uint32_t candidate = VMALLOC_START;
+    
+    for (vmap_area_t* area = vmap_areas; area; area = area->next) {
+        if (area->addr - candidate >= span) {
+            break;
+        }
+        candidate = area_end(area);
+        prev = area;
+    }
+    
+    if (VMALLOC_END - candidate < span) {
+        return 0;
+    }
+    
+    *prev_out = prev;
+    return candidate;
+}
+
+// 查找起始地址为 addr 的区域，*prev_out 返回它之前的区域（调用者持有 vmap_lock）
+static vmap_area_t* find_area(uint32_t addr, vmap_area_t** prev_out)
+{
+    vmap_area_t* prev = NULL;
+    vmap_area_t* area = vmap_areas;
+    while (area && area->addr != addr) {
+        prev = area;
+        area = area->next;
+    }
+    
+    if (prev_out) {
+        *prev_out = prev;
+    }
+    return area;
+}
+
+// 把区域插入到 prev 之后（prev 为 NULL 时插入表头，调用者持有 vmap_lock）
+static void insert_area(vmap_area_t* area, vmap_area_t* prev)
+{
+    if (prev) {
+        area->next = prev->next;
+        prev->next = area;
+    } else {
+        area->next = vmap_areas;
+        vmap_areas = area;
+    }
+}
+
+// 从链表中移除区域（调用者持有 vmap_lock）
+static void remove_area(vmap_area_t* area)
+{
+    vmap_area_t* prev = NULL;
+    find_area(area->addr, &prev);
+    if (prev) {
+        prev->next = area->next;
+    } else {
+        vmap_areas = area->next;
+    }
+}
+
+// 分配区域描述符并在链表中占住 pages 页（加保护页）的地址范围，失败返回 NULL
+static vmap_area_t* reserve_area(uint32_t pages)
+{
+    vmap_area_t* area = (vmap_area_t*)kmem_cache_alloc(vmap_cache);
+    if (!area) {
+        return NULL;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    vmap_area_t* prev = NULL;
+    uint32_t addr = find_free_range(pages * PAGE_SIZE + VMALLOC_GUARD_SIZE, &prev);
+    if (addr != 0) {
+        area->addr = addr;
+        area->pages = pages;
+        insert_area(area, prev);
+    }
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    
+    if (addr == 0) {
+        kprintf("[VMALLOC] Out of virtual address space for %d pages\n", pages);
+        kmem_cache_free(vmap_cache, area);
+        return NULL;
+    }
+    return area;
+}
+
+// 释放占住地址范围但没有映射的区域
+static void release_area(vmap_area_t* area)
+{
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    remove_area(area);
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    kmem_cache_free(vmap_cache, area);
+}
+
+// 把物理地址连续的 pages 个帧映射到 addr，失败时释放其中没有映射上的帧
+static int map_run(uint32_t addr, uint32_t frame, uint32_t pages)
+{
+    if (map_range((void*)addr, frame * PAGE_SIZE, pages * PAGE_SIZE, PAGE_PRESENT | PAGE_WRITABLE) == 0) {
+        return 0;
+    }
+    
+    // map_range 在页表分配失败处停止，之后的帧不在页表中，unmap_range 无法释放
+    for (uint32_t i = 0; i < pages; i++) {
+        if (get_physical_addr((void*)(addr + i * PAGE_SIZE)) == 0) {
+            free_frame(frame + i);
+        }
+    }
+    return -1;
+}
+
+// 在 [start, end) 映射新帧，失败时撤销本次映射并返回 -1
+// 伙伴分配器拆分大块时按地址递增给出帧，物理连续的帧攒成一段交给 map_range，每个页表只查找一次
+static int populate_range(uint32_t start, uint32_t end)
+{
+    uint32_t run_addr = start;
+    uint32_t run_frame = 0;
+    uint32_t run_pages = 0;
+    
+    for (uint32_t addr = start; addr < end; addr += PAGE_SIZE) {
+        uint32_t frame = alloc_frame_high();
+        if (frame != 0 && run_pages > 0 && frame == run_frame + run_pages) {
+            run_pages++;
+            continue;
+        }
+        
+        // 连续段中断：先映射已攒下的帧，再从本帧开始新的一段
+        if (run_pages > 0 && map_run(run_addr, run_frame, run_pages) < 0) {
+            if (frame != 0) {
+                free_frame(frame);
+            }
+            unmap_range((void*)start, addr - start);
+            return -1;
+        }
+        if (frame == 0) {
+            unmap_range((void*)start, addr - start);
+            return -1;
+        }
+        
+        run_addr = addr;
+        run_frame = frame;
+        run_pages = 1;
+    }
+    
+    if (run_pages > 0 && map_run(run_addr, run_frame, run_pages) < 0) {
+        unmap_range((void*)start, end - start);
+        return -1;
+    }
+    return 0;
+}
+
+// 分配虚拟地址连续的内存
+void* vmalloc(size_t size)
+{
+    if (size == 0 || size > VMALLOC_END - VMALLOC_START) {
+        return NULL;
+    }
+    
+    uint32_t pages = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+    vmap_area_t* area = reserve_area(pages);
+    if (!area) {
+        return NULL;
+    }
+    
+    // 逐页分配帧，优先使用高端内存；物理上不连续不影响使用
+    uint32_t addr = area->addr;
+    if (populate_range(addr, addr + pages * PAGE_SIZE) < 0) {
+        kprintf("[VMALLOC] Out of frames allocating %d pages\n", pages);
+        release_area(area);
+        return NULL;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    vmap_pages += pages;
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    
+    return (void*)addr;
+}
+
+// 释放 vmalloc 分配的内存
+void vfree(void* addr)
+{
+    if (!addr) {
+        return;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    vmap_area_t* area = find_area((uint32_t)addr, NULL);
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    if (!area) {
+        kprintf("[VMALLOC] Invalid vfree of 0x%x\n", (uint32_t)addr);
+        return;
+    }
+    
+    // 取消映射并释放帧（批量刷新 TLB），完成后才让出地址范围
+    unmap_range(addr, area->pages * PAGE_SIZE);
+    
+    flags = spin_lock_irqsave(&vmap_lock);
+    remove_area(area);
+    vmap_pages -= area->pages;
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    kmem_cache_free(vmap_cache, area);
+}
+
+// 调整 vmalloc 分配的内存大小
+void* vrealloc(void* ptr, size_t size)
+{
+    if (!ptr) {
+        return vmalloc(size);
+    }
+    if (size == 0) {
+        vfree(ptr);
+        return NULL;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    vmap_area_t* area = find_area((uint32_t)ptr, NULL);
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    if (!area || size > VMALLOC_END - VMALLOC_START) {
+        kprintf("[VMALLOC] Invalid vrealloc of 0x%x\n", (uint32_t)ptr);
+        return NULL;
+    }
+    
+    uint32_t pages = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+    uint32_t old_pages = area->pages;
+    uint32_t old_end = area->addr + old_pages * PAGE_SIZE;
+    
+    // 缩小：先释放尾部的页，再让出地址范围，保护页随之前移
+    if (pages <= old_pages) {
+        unmap_range((void*)(area->addr + pages * PAGE_SIZE), (old_pages - pages) * PAGE_SIZE);
+        flags = spin_lock_irqsave(&vmap_lock);
+        vmap_pages -= old_pages - pages;
+        area->pages = pages;
+        spin_unlock_irqrestore(&vmap_lock, flags);
+        return ptr;
+    }
+    
+    // 后面的虚拟地址空闲时原地扩展：先在锁内占住扩展部分，映射失败时退回
+    flags = spin_lock_irqsave(&vmap_lock);
+    uint32_t limit = area->next ? area->next->addr : VMALLOC_END;
+    bool inplace = limit - area->addr >= pages * PAGE_SIZE + VMALLOC_GUARD_SIZE;
+    if (inplace) {
+        area->pages = pages;
+    }
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    
+    if (inplace) {
+        uint32_t new_end = area->addr + pages * PAGE_SIZE;
+        int ret = populate_range(old_end, new_end);
+        
+        flags = spin_lock_irqsave(&vmap_lock);
+        if (ret < 0) {
+            area->pages = old_pages;
+        } else {
+            vmap_pages += pages - old_pages;
+        }
+        spin_unlock_irqrestore(&vmap_lock, flags);
+        return ret < 0 ? NULL : ptr;
+    }
+    
+    // 否则迁移到新的虚拟地址：原有的帧直接重新映射，不复制数据
+    vmap_area_t* new_area = reserve_area(pages);
+    if (!new_area) {
+        return NULL;
+    }
+    uint32_t addr = new_area->addr;
+    if (populate_range(addr + old_pages * PAGE_SIZE, addr + pages * PAGE_SIZE) < 0) {
+        release_area(new_area);
+        return NULL;
+    }
+    
+    for (uint32_t i = 0; i < old_pages; i++) {
+        uint32_t phys = get_physical_addr((void*)(area->addr + i * PAGE_SIZE));
+        frame_ref(phys / PAGE_SIZE);
+        map_page((void*)(addr + i * PAGE_SIZE), phys, PAGE_PRESENT | PAGE_WRITABLE);
+    }
+    unmap_range((void*)area->addr, old_pages * PAGE_SIZE);
+    
+    // 原地址范围已经取消映射，移除旧的区域
+    flags = spin_lock_irqsave(&vmap_lock);
+    remove_area(area);
+    vmap_pages += pages - old_pages;
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    kmem_cache_free(vmap_cache, area);
+    
+    return (void*)addr;
+}
+
+// vmalloc 分配的内存的实际大小
+size_t vmalloc_size(const void* ptr)
+{
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    vmap_area_t* area = find_area((uint32_t)ptr, NULL);
+    size_t size = area ? area->pages * PAGE_SIZE : 0;
+    spin_unlock_irqrestore(&vmap_lock, flags);
+    return size;
+}
+
+// 判断地址是否位于内核虚拟区域窗口内
+bool is_vmalloc_addr(const void* addr)
+{
+    return (uint32_t)addr >= VMALLOC_START && (uint32_t)addr < VMALLOC_END;
+}
+
+// 获取统计信息
+void vmalloc_get_stats(vmalloc_stats_t* stats)
+{
+    uint32_t flags = spin_lock_irqsave(&vmap_lock);
+    stats->areas = 0;
+    stats->pages = vmap_pages;
+    stats->largest_gap = 0;
+    
+    uint32_t candidate = VMALLOC_START;
+    for (vmap_area_t* area = vmap_areas; area; area = area->next) {
+        stats->areas++;
+        stats->largest_gap = MAX(stats->largest_gap, area->addr - candidate);
+        candidate = area_end(area);
+    }
+    stats->largest_gap = MAX(stats->largest_gap, VMALLOC_END - candidate);
+    spin_unlock_irqrestore(&vmap_lock, flags);
+}
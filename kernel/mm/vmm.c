@@ -0,0 +1,391 @@
+#include <mm/vmm.h>
+#include <mm/paging.h>
+#include <mm/zeropool.h>
+#include <proc/task.h>
+#include <string.h>
+#include <common.h>
+#include <vga.h>
+
+// 内核地址空间
+static vm_space_t kernel_space = {0};
+
+// 初始化地址空间管理
+void vmm_init(void)
+{
+    kernel_space.page_dir = get_kernel_page_dir();
+    kernel_space.refcount = 1;
+    kernel_space.areas = NULL;
+}
+
+// 内核地址空间
+vm_space_t* vm_space_kernel(void)
+{
+    return &kernel_space;
+}
+
+// 当前进程的地址空间
+vm_space_t* vm_space_current(void)
+{
+    task_t* task = get_current_task();
+    if (!task || !task->mm) {
+        return &kernel_space;
+    }
+    return task->mm;
+}
+
+// 创建新的地址空间
+vm_space_t* vm_space_create(void)
+{
+    vm_space_t* space = (vm_space_t*)kmalloc(sizeof(vm_space_t));
+    if (!space) {
+        kprintf("[VMM] Failed to allocate address space\n");
+        return NULL;
+    }
+    
+    memset(space, 0, sizeof(vm_space_t));
+    space->page_dir = paging_create_dir();
+    if (!space->page_dir) {
+        kfree(space);
+        return NULL;
+    }
+    space->refcount = 1;
+    
+    return space;
+}
+
+// 增加引用计数
+vm_space_t* vm_space_get(vm_space_t* space)
+{
+    if (space) {
+        space->refcount++;
+    }
+    return space;
+}
+
+// 减少引用计数，计数归零时释放地址空间
+void vm_space_put(vm_space_t* space)
+{
+    if (!space || space == &kernel_space) {
+        return;
+    }
+    
+    if (--space->refcount > 0) {
+        return;
+    }
+    
+    vm_area_t* area = space->areas;
+    while (area) {
+        vm_area_t* next = area->next;
+        kfree(area);
+        area = next;
+    }
+    
+    paging_destroy_dir(space->page_dir);
+    kfree(space);
+}
+
+// 切换到指定地址空间
+void vm_space_switch(vm_space_t* space)
+{
+    paging_switch_dir(space ? space->page_dir : kernel_space.page_dir);
+}
+
+// 分配区域描述符
+static vm_area_t* area_alloc(uint32_t start, uint32_t end, uint32_t flags)
+{
+    vm_area_t* area = (vm_area_t*)kmalloc(sizeof(vm_area_t));
+    if (!area) {
+        kprintf("[VMM] Failed to allocate memory area\n");
+        return NULL;
+    }
+    
+    area->start = start;
+    area->end = end;
+    area->flags = flags;
+    area->next = NULL;
+    return area;
+}
+
+// 登记虚拟内存区域
+int vm_area_map(vm_space_t* space, uint32_t start, uint32_t end, uint32_t flags)
+{
+    start = ALIGN_DOWN(start, PAGE_SIZE);
+    end = ALIGN_UP(end, PAGE_SIZE);
+    
+    if (start >= end || start < USER_SPACE_START || end > USER_SPACE_END) {
+        kprintf("[VMM] Invalid area 0x%x-0x%x\n", start, end);
+        return -1;
+    }
+    
+    // 找到插入位置：prev 结束于 start 之前，next 起始于 start 之后
+    vm_area_t* prev = NULL;
+    vm_area_t* next = space->areas;
+    while (next && next->end <= start) {
+        prev = next;
+        next = next->next;
+    }
+    
+    if (next && next->start < end) {
+        return -1;
+    }
+    
+    space->total_pages += (end - start) / PAGE_SIZE;
+    
+    // 与权限相同的相邻区域合并（例如 sbrk 逐步扩展堆）
+    if (prev && prev->end == start && prev->flags == flags) {
+        prev->end = end;
+        if (next && next->start == end && next->flags == flags) {
+            prev->end = next->end;
+            prev->next = next->next;
+            kfree(next);
+        }
+        return 0;
+    }
+    
+    if (next && next->start == end && next->flags == flags) {
+        next->start = start;
+        return 0;
+    }
+    
+    vm_area_t* area = area_alloc(start, end, flags);
+    if (!area) {
+        space->total_pages -= (end - start) / PAGE_SIZE;
+        return -1;
+    }
+    
+    area->next = next;
+    if (prev) {
+        prev->next = area;
+    } else {
+        space->areas = area;
+    }
+    
+    return 0;
+}
+
+// 取消虚拟内存区域
+void vm_area_unmap(vm_space_t* space, uint32_t start, uint32_t end)
+{
+    start = ALIGN_DOWN(start, PAGE_SIZE);
+    end = ALIGN_UP(end, PAGE_SIZE);
+    
+    vm_area_t* prev = NULL;
+    vm_area_t* area = space->areas;
+    while (area && area->start < end) {
+        vm_area_t* next = area->next;
+        
+        if (area->end <= start) {
+            prev = area;
+            area = next;
+            continue;
+        }
+        
+        uint32_t cut_start = MAX(area->start, start);
+        uint32_t cut_end = MIN(area->end, end);
+        space->total_pages -= (cut_end - cut_start) / PAGE_SIZE;
+        
+        // 只释放本区域内已驻留的页（未访问过的页没有分配物理帧），不属于任何区域的映射保持不变
+        space->rss_pages -= unmap_range((void*)cut_start, cut_end - cut_start);
+        
+        if (cut_start > area->start && cut_end < area->end) {
+            // 从中间挖去，拆分为两个区域
+            vm_area_t* tail = area_alloc(cut_end, area->end, area->flags);
+            if (!tail) {
+                // 描述符分配失败时保留整个区域，其中的页已释放，再次访问时重新按需分配
+                space->total_pages += (cut_end - cut_start) / PAGE_SIZE;
+                prev = area;
+                area = next;
+                continue;
+            }
+            tail->next = next;
+            area->end = cut_start;
+            area->next = tail;
+            prev = tail;
+        } else if (cut_start > area->start) {
+            area->end = cut_start;
+            prev = area;
+        } else if (cut_end < area->end) {
+            area->start = cut_end;
+            prev = area;
+        } else {
+            if (prev) {
+                prev->next = next;
+            } else {
+                space->areas = next;
+            }
+            kfree(area);
+        }
+        
+        area = next;
+    }
+}
+
+// 查找包含 addr 的区域
+vm_area_t* vm_area_find(vm_space_t* space, uint32_t addr)
+{
+    for (vm_area_t* area = space->areas; area && area->start <= addr; area = area->next) {
+        if (addr < area->end) {
+            return area;
+        }
+    }
+    return NULL;
+}
+
+// 查找空闲虚拟地址（首次适配）
+uint32_t vm_area_find_free(vm_space_t* space, uint32_t size)
+{
+    size = ALIGN_UP(size, PAGE_SIZE);
+    if (size == 0 || size > USER_SPACE_END - VMM_MMAP_BASE) {
+        return 0;
+    }
+    
+    // 始终保证 candidate <= USER_SPACE_END - size，candidate + size 不会回绕
+    uint32_t candidate = VMM_MMAP_BASE;
+    for (vm_area_t* area = space->areas; area; area = area->next) {
+        if (area->end <= candidate) {
+            continue;
+        }
+        if (area->start >= candidate + size) {
+            break;
+        }
+        candidate = area->end;
+        if (candidate > USER_SPACE_END - size) {
+            return 0;
+        }
+    }
+    
+    return candidate;
+}
+
+// 复制地址空间用于 fork：复制区域描述符，物理页以写时复制方式共享
+vm_space_t* vm_space_fork(vm_space_t* parent)
+{
+    vm_space_t* space = (vm_space_t*)kmalloc(sizeof(vm_space_t));
+    if (!space) {
+        kprintf("[VMM] Failed to allocate address space\n");
+        return NULL;
+    }
+    
+    memset(space, 0, sizeof(vm_space_t));
+    space->refcount = 1;
+    
+    // 复制区域链表（保持地址顺序）
+    vm_area_t** tail = &space->areas;
+    for (vm_area_t* area = parent->areas; area; area = area->next) {
+        vm_area_t* copy = area_alloc(area->start, area->end, area->flags);
+        if (!copy) {
+            vm_space_put(space);
+            return NULL;
+        }
+        *tail = copy;
+        tail = &copy->next;
+    }
+    
+    space->page_dir = paging_clone_dir(parent->page_dir);
+    if (!space->page_dir) {
+        vm_space_put(space);
+        return NULL;
+    }
+    
+    space->total_pages = parent->total_pages;
+    space->rss_pages = parent->rss_pages;
+    
+    return space;
+}
+
+// 处理写时复制缺页：帧仍被共享时复制一份，否则直接恢复写权限
+static int handle_cow_fault(vm_space_t* space, uint32_t addr)
+{
+    void* page = (void*)ALIGN_DOWN(addr, PAGE_SIZE);
+    page_entry_t* pte = paging_get_pte(page);
+    if (!pte || !(*pte & PAGE_COW)) {
+        return -1;
+    }
+    
+    uint32_t frame = (*pte & PAGE_FRAME_MASK) / PAGE_SIZE;
+    uint32_t flags = (*pte & 0xFFF & ~PAGE_COW) | PAGE_WRITABLE;
+    
+    if (frame_refcount(frame) == 1) {
+        // 其他共享者已经复制或退出，本进程独占该帧
+        *pte = frame * PAGE_SIZE | flags;
+        tlb_flush_page(page);
+    } else {
+        uint32_t copy = alloc_frame_high();
+        if (copy == 0) {
+            kprintf("[VMM] Out of memory handling copy-on-write at 0x%x\n", addr);
+            return -1;
+        }
+        
+        // 原页仍以只读方式映射在出错地址，新帧通过临时映射写入
+        memcpy(kmap_temp(copy * PAGE_SIZE), page, PAGE_SIZE);
+        kunmap_temp();
+        
+        *pte = copy * PAGE_SIZE | flags;
+        tlb_flush_page(page);
+        free_frame(frame);
+        space->cow_copies++;
+    }
+    
+    space->fault_count++;
+    return 0;
+}
+
+// 处理缺页
+int vm_handle_fault(vm_space_t* space, uint32_t addr, uint32_t error_code)
+{
+    vm_area_t* area = vm_area_find(space, addr);
+    if (!area) {
+        return -1;
+    }
+    
+    if ((error_code & PF_WRITE) && !(area->flags & VM_WRITE)) {
+        return -1;
+    }
+    
+    // 页已存在时只有写时复制页的写访问是合法的
+    if (error_code & PF_PRESENT) {
+        return (error_code & PF_WRITE) ? handle_cow_fault(space, addr) : -1;
+    }
+    
+    // 优先使用空闲进程预先清零的帧
+    uint32_t frame = alloc_zeroed_frame(BUDDY_ZONE_HIGH);
+    if (frame == 0) {
+        kprintf("[VMM] Out of memory handling fault at 0x%x\n", addr);
+        return -1;
+    }
+    
+    uint32_t flags = PAGE_PRESENT | PAGE_USER;
+    if (area->flags & VM_WRITE) {
+        flags |= PAGE_WRITABLE;
+    }
+    map_page((void*)ALIGN_DOWN(addr, PAGE_SIZE), frame * PAGE_SIZE, flags);
+    
+    space->rss_pages++;
+    space->fault_count++;
+    return 0;
+}
+
+// 缺页异常处理函数
+void page_fault_handler(uint32_t error_code, uint32_t eip)
+{
+    uint32_t addr;
+    asm volatile("mov %%cr2, %0" : "=r" (addr));
+    
+    if (vm_handle_fault(vm_space_current(), addr, error_code) == 0) {
+        return;
+    }
+    
+    kprintf("[VMM] Page fault at 0x%x (error 0x%x, eip 0x%x)\n", addr, error_code, eip);
+    
+    // 用户态非法访问终止当前进程，内核态非法访问无法恢复
+    if ((error_code & PF_USER) && get_current_task()) {
+        task_exit(-1);
+        return;
+    }
+    
+    kprintf("[VMM] Unrecoverable kernel page fault, system halted\n");
+    asm volatile("cli");
+    while (1) {
+        asm volatile("hlt");
+    }
+}
@@ -0,0 +1,135 @@
+#include <mm/zeropool.h>
+#include <mm/page.h>
+#include <mm/paging.h>
+#include <vga.h>
+#include <spinlock.h>
+
+// 预清零帧池（每个区域一个链表，通过 page_t 链接）
+static page_list_t zero_pool[BUDDY_ZONE_COUNT];
+static zero_pool_stats_t zero_stats[BUDDY_ZONE_COUNT];
+static bool pool_enabled = true;
+static spinlock_t pool_lock = SPINLOCK_INIT;      // 保护池链表（各处理器的空闲进程同时补充）
+
+// 从池中取出一个已清零的帧，池为空时返回 0
+static uint32_t pool_take(uint32_t zone)
+{
+    uint32_t flags = spin_lock_irqsave(&pool_lock);
+    
+    page_t* page = page_list_pop(&zero_pool[zone]);
+    if (page) {
+        zero_stats[zone].pooled--;
+    }
+    
+    spin_unlock_irqrestore(&pool_lock, flags);
+    
+    if (!page) {
+        return 0;
+    }
+    
+    page->flags &= ~PG_ZEROED;
+    return page_to_pfn(page);
+}
+
+// 分配一个已清零的物理帧
+uint32_t alloc_zeroed_frame(uint32_t zone)
+{
+    if (zone >= BUDDY_ZONE_COUNT) {
+        return 0;
+    }
+    
+    uint32_t frame = 0;
+    if (pool_enabled) {
+        frame = pool_take(zone);
+        
+        // 没有高端内存的机器上 HIGH 池永远为空，改用 NORMAL 池
+        if (frame == 0 && zone == BUDDY_ZONE_HIGH && buddy_zone_free_frames(BUDDY_ZONE_HIGH) == 0) {
+            frame = pool_take(BUDDY_ZONE_NORMAL);
+        }
+    }
+    
+    if (frame != 0) {
+        zero_stats[zone].hits++;
+        return frame;
+    }
+    
+    // 池为空，同步分配并清零（内存耗尽时 alloc_frames 会先回收池中的帧）
+    zero_stats[zone].misses++;
+    frame = (zone == BUDDY_ZONE_HIGH) ? alloc_frame_high() : alloc_frame();
+    if (frame != 0) {
+        clear_frame(frame);
+    }
+    return frame;
+}
+
+// 后台补充预清零池
+uint32_t zero_pool_refill(uint32_t max_frames)
+{
+    uint32_t cleared = 0;
+    
+    if (!pool_enabled) {
+        return 0;
+    }
+    
+    for (uint32_t zone = 0; zone < BUDDY_ZONE_COUNT && cleared < max_frames; zone++) {
+        while (zero_stats[zone].pooled < ZERO_POOL_TARGET && cleared < max_frames) {
+            uint32_t frame = alloc_frame_zone(zone);
+            if (frame == 0) {
+                break;
+            }
+            
+            clear_frame(frame);
+            
+            page_t* page = pfn_to_page(frame);
+            page->flags |= PG_ZEROED;
+            
+            uint32_t flags = spin_lock_irqsave(&pool_lock);
+            page_list_add(&zero_pool[zone], page);
+            zero_stats[zone].pooled++;
+            spin_unlock_irqrestore(&pool_lock, flags);
+            
+            zero_stats[zone].refilled++;
+            cleared++;
+        }
+    }
+    
+    return cleared;
+}
+
+// 将池中的帧归还给伙伴分配器
+uint32_t zero_pool_drain(void)
+{
+    uint32_t drained = 0;
+    
+    for (uint32_t zone = 0; zone < BUDDY_ZONE_COUNT; zone++) {
+        uint32_t frame;
+        while ((frame = pool_take(zone)) != 0) {
+            free_frame(frame);
+            drained++;
+        }
+    }
+    
+    return drained;
+}
+
+// 开关预清零池
+void zero_pool_set_enabled(bool enable)
+{
+    pool_enabled = enable;
+    if (!enable) {
+        zero_pool_drain();
+    }
+}
+
+bool zero_pool_enabled(void)
+{
+    return pool_enabled;
+}
+
+// 获取统计信息
+const zero_pool_stats_t* zero_pool_get_stats(uint32_t zone)
+{
+    if (zone >= BUDDY_ZONE_COUNT) {
+        return NULL;
+    }
+    return &zero_stats[zone];
+}
@@ -50,7 +50,8 @@ void init_process_management(void) {
     kernel_process->pid = 0;
     kernel_process->state = PROCESS_RUNNING;
     strcpy(kernel_process->name, "kernel");
-    kernel_process->page_dir = get_kernel_page_dir();
+    kernel_process->mm = vm_space_kernel();
+    kernel_process->page_dir = kernel_process->mm->page_dir;
     kernel_process->priority = 10;
     kernel_process->ticks = 0;
     
@@ -76,21 +77,19 @@ pcb_t* create_process(const char* name, void (*entry_point)(void), uint32_t prio
     process->priority = priority;
     process->ticks = 0;
     
-    // 创建进程页目录（复制内核页目录）
-    process->page_dir = (page_directory_t*)kmalloc(sizeof(page_directory_t));
-    if (!process->page_dir) {
+    // 创建进程地址空间（内核部分与所有进程共享）
+    process->mm = vm_space_create();
+    if (!process->mm) {
         kfree(process);
-        kprintf("[ERROR] Failed to allocate page directory!");
+        kprintf("[ERROR] Failed to create address space!");
         return NULL;
     }
-    
-    // 复制内核页目录映射
-    memcpy(process->page_dir, get_kernel_page_dir(), sizeof(page_directory_t));
+    process->page_dir = process->mm->page_dir;
     
     // 分配用户栈
     uint32_t* stack = (uint32_t*)kmalloc(8192); // 8KB栈
     if (!stack) {
-        kfree(process->page_dir);
+        vm_space_put(process->mm);
         kfree(process);
         kprintf("[ERROR] Failed to allocate stack!");
         return NULL;
@@ -125,9 +124,8 @@ void switch_process(pcb_t* next_process) {
     asm volatile("mov %0, %%esp" : : "r"(next_process->esp));
     asm volatile("mov %0, %%ebp" : : "r"(next_process->ebp));
     
-    // 切换页目录
-    uint32_t page_dir_phys = ((uint32_t)next_process->page_dir) & 0xFFFFF000;
-    asm volatile("mov %0, %%cr3" : : "r"(page_dir_phys));
+    // 切换地址空间（页目录相同时不重载 CR3）
+    vm_space_switch(next_process->mm);
     
     asm volatile("popa");
 }
@@ -191,10 +189,7 @@ void terminate_process(uint32_t pid) {
             kprintf("[PROCESS] Terminated process %s (PID: %d)\n", process->name, pid);
             
             // 释放资源
-            if (process->page_dir && process->page_dir != get_kernel_page_dir()) {
-                // 释放页目录和页表（简化实现）
-                kfree(process->page_dir);
-            }
+            vm_space_put(process->mm);
             
             // 从链表中移除
             remove_process_from_list(process);
@@ -250,51 +245,38 @@ int pipe_read(int fd, void* buf, size_t count) {
     return 0;
 }
 
-// 内存映射实现
+// 内存映射实现：只登记虚拟内存区域，物理页在首次访问时由缺页处理分配
 void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
-    // 简化实现：分配物理内存并映射到虚拟地址
-    size_t pages = (length + PAGE_SIZE - 1) / PAGE_SIZE;
+    vm_space_t* space = vm_space_current();
     uint32_t virtual_page = (uint32_t)addr;
     
-    if (!addr) {
-        // 自动分配虚拟地址（简化：从0x80000000开始）
-        virtual_page = 0x80000000;
+    if (length == 0) {
+        return NULL;
     }
     
-    for (size_t i = 0; i < pages; i++) {
-        uint32_t frame = alloc_frame();
-        if (frame == 0) {
+    if (!addr) {
+        // 自动分配虚拟地址（从 VMM_MMAP_BASE 开始查找空闲区域）
+        virtual_page = vm_area_find_free(space, length);
+        if (!virtual_page) {
+            kprintf("[MMAP] No free virtual range for %d bytes\n", length);
             return NULL;
         }
-        
-        uint32_t phys_addr = frame * PAGE_SIZE;
-        uint32_t virt_addr = virtual_page + i * PAGE_SIZE;
-        
-        // 设置页属性
-        uint32_t page_flags = PAGE_PRESENT;
-        if (prot & 0x2) page_flags |= PAGE_WRITABLE;
-        if (prot & 0x4) page_flags |= PAGE_USER;
-        
-        map_page((void*)virt_addr, phys_addr, page_flags);
     }
     
-    kprintf("[MMAP] Mapped %zu bytes at 0x%x\n", length, virtual_page);
+    if (vm_area_map(space, virtual_page, virtual_page + length, prot & (VM_READ | VM_WRITE | VM_EXEC)) < 0) {
+        kprintf("[MMAP] Cannot map %d bytes at 0x%x\n", length, virtual_page);
+        return NULL;
+    }
+    
+    kprintf("[MMAP] Reserved %d bytes at 0x%x\n", length, virtual_page);
     return (void*)virtual_page;
 }
 
 int munmap(void* addr, size_t length) {
-    // 简化实现：取消映射并释放物理内存
-    size_t pages = (length + PAGE_SIZE - 1) / PAGE_SIZE;
+    // 取消区域并释放已驻留的物理页
     uint32_t virt_addr = (uint32_t)addr;
+    vm_area_unmap(vm_space_current(), virt_addr, virt_addr + length);
     
-    for (size_t i = 0; i < pages; i++) {
-        uint32_t frame = get_physical_addr((void*)(virt_addr + i * PAGE_SIZE)) / PAGE_SIZE;
-        if (frame != 0) {
-            free_frame(frame);
-        }
-        unmap_page((void*)(virt_addr + i * PAGE_SIZE));
-    }
-    
-    kprintf("[MMAP] Unmapped %zu bytes at 0x%x\n", length, virt_addr);
+    kprintf("[MMAP] Unmapped %d bytes at 0x%x\n", length, virt_addr);
     return 0;
 }
@@ -1,13 +1,22 @@
 #include <fs.h>
 #include <proc/task.h>
+#include <proc/sched.h>
+#include <proc/smp.h>
 #include <string.h>
 #include <vga.h>
 #include <mm/kheap.h>
+#include <mm/kheapprof.h>
+#include <mm/paging.h>
+#include <mm/buddy.h>
+#include <mm/zeropool.h>
+#include <mm/slab.h>
+#include <mm/vmalloc.h>
+#include <mm/scratch.h>
 
-// 系统负载数据
-static uint32_t load_avg[3] = {0, 0, 0}; // 1, 5, 15分钟负载
-static uint32_t load_ticks[3] = {0, 0, 0}; // 负载计数
-static uint32_t last_tick = 0; // 上次更新时间
+// 生成内容的缓冲区大小（缓冲区从当前进程的临时区分配，系统调用返回时自动释放）
+#define PROC_BUF_SMALL 128
+#define PROC_BUF_SIZE 1024
+#define PROC_BUF_LARGE 4096
 
 // 生成系统负载内容
 static int generate_proc_loadavg_content(char* buf, size_t buf_size) {
@@ -15,8 +24,63 @@ static int generate_proc_loadavg_content(char* buf, size_t buf_size) {
         return 0;
     }
     
-    // 简化实现：返回固定负载值
-    int offset = snprintf(buf, buf_size, "0.10 0.20 0.30 1/1 %d\n", current_task ? current_task->pid : 0);
+    sched_stats_t stats;
+    sched_get_stats(&stats);
+    
+    // 定点负载值转换为两位小数（snprintf 不支持浮点和宽度）
+    int offset = 0;
+    for (int i = 0; i < 3; i++) {
+        uint32_t load = stats.load_avg[i];
+        uint32_t frac = ((load & ((1 << LOAD_FSHIFT) - 1)) * 100) >> LOAD_FSHIFT;
+        offset += snprintf(buf + offset, buf_size - offset, "%d.%d%d ",
+                           load >> LOAD_FSHIFT, frac / 10, frac % 10);
+    }
+    offset += snprintf(buf + offset, buf_size - offset, "%d/%d %d\n",
+                       stats.nr_running, stats.nr_tasks, stats.last_pid);
+    
+    return offset;
+}
+
+// 生成处理器时间统计内容（时钟滴答数）
+static int generate_proc_stat_content(char* buf, size_t buf_size) {
+    if (!buf) {
+        return 0;
+    }
+    
+    sched_stats_t stats;
+    sched_get_stats(&stats);
+    
+    uint32_t total = stats.busy_ticks + stats.idle_ticks;
+    // 避免 64 位除法：滴答数较大时先缩小总数再相除
+    uint32_t busy_pct = 0;
+    if (total >= 0x01000000) {
+        busy_pct = stats.busy_ticks / (total / 100);
+    } else if (total > 0) {
+        busy_pct = stats.busy_ticks * 100 / total;
+    }
+    
+    int offset = snprintf(buf, buf_size, "cpu %d %d\n", stats.busy_ticks, stats.idle_ticks);
+    
+    // 每个在线处理器一行：cpuN 忙碌滴答 空闲滴答 上下文切换 可运行进程数 当前进程
+    // 窃取的进程数 被窃取的进程数 因缓存热跳过的进程数
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        sched_cpu_stats_t cpu_stats;
+        if (sched_get_cpu_stats(cpu, &cpu_stats)) {
+            offset += snprintf(buf + offset, buf_size - offset, "cpu%d %d %d %d %d %d %d %d %d\n", cpu,
+                               cpu_stats.busy_ticks, cpu_stats.idle_ticks, cpu_stats.context_switches,
+                               cpu_stats.nr_running, cpu_stats.curr_pid,
+                               cpu_stats.nr_steals, cpu_stats.nr_stolen, cpu_stats.hot_skips);
+        }
+    }
+    
+    offset += snprintf(buf + offset, buf_size - offset, "busy %d%%\n", busy_pct);
+    offset += snprintf(buf + offset, buf_size - offset, "ctxt %d\n", stats.context_switches);
+    offset += snprintf(buf + offset, buf_size - offset, "timer_irqs %d\n", stats.timer_interrupts);
+    offset += snprintf(buf + offset, buf_size - offset, "nohz_ticks %d\n", stats.nohz_ticks);
+    offset += snprintf(buf + offset, buf_size - offset, "processes %d\n", stats.last_pid);
+    offset += snprintf(buf + offset, buf_size - offset, "procs_running %d\n", stats.nr_running);
+    offset += snprintf(buf + offset, buf_size - offset, "cpus %d\n", stats.nr_cpus);
+    offset += snprintf(buf + offset, buf_size - offset, "migrations %d\n", stats.nr_migrations);
     
     return offset;
 }
@@ -27,24 +91,66 @@ static int generate_proc_meminfo_content(char* buf, size_t buf_size) {
         return 0;
     }
     
-    // 获取内存使用信息（简化实现）
-    uint32_t total_mem = 32 * 1024 * 1024; // 假设32MB总内存
-    uint32_t free_mem = get_free_mem_size();
-    uint32_t used_mem = total_mem - free_mem;
-    
-    // 输出内存信息
-    int offset = snprintf(buf, buf_size, "MemTotal:     %d kB\n", total_mem / 1024);
-    offset += snprintf(buf + offset, buf_size - offset, "MemFree:      %d kB\n", free_mem / 1024);
-    offset += snprintf(buf + offset, buf_size - offset, "MemUsed:      %d kB\n", used_mem / 1024);
-    offset += snprintf(buf + offset, buf_size - offset, "\nBuddy Allocator Fragmentation:\n");
-    offset += snprintf(buf + offset, buf_size - offset, "  Level 0: 10%%\n");
-    offset += snprintf(buf + offset, buf_size - offset, "  Level 1: 15%%\n");
-    offset += snprintf(buf + offset, buf_size - offset, "  Level 2: 8%%\n");
-    offset += snprintf(buf + offset, buf_size - offset, "  Level 3: 5%%\n");
+    // 物理帧分配器
+    int offset = snprintf(buf, buf_size, "MemTotal:     %d kB\n", get_total_memory() / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "MemFree:      %d kB\n", get_free_memory() / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "MemUsed:      %d kB\n", get_used_memory() / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "NormalFree:   %d kB\n",
+                       buddy_zone_free_frames(BUDDY_ZONE_NORMAL) * (PAGE_SIZE / 1024));
+    offset += snprintf(buf + offset, buf_size - offset, "HighFree:     %d kB\n",
+                       buddy_zone_free_frames(BUDDY_ZONE_HIGH) * (PAGE_SIZE / 1024));
+    offset += snprintf(buf + offset, buf_size - offset, "ZeroPooled:   %d kB\n",
+                       (zero_pool_get_stats(BUDDY_ZONE_NORMAL)->pooled +
+                        zero_pool_get_stats(BUDDY_ZONE_HIGH)->pooled) * (PAGE_SIZE / 1024));
+    
+    // 内核堆、slab 和 vmalloc
+    kheap_stats_t heap;
+    get_kheap_stats(&heap);
+    vmalloc_stats_t vm;
+    vmalloc_get_stats(&vm);
+    
+    offset += snprintf(buf + offset, buf_size - offset, "HeapTotal:    %d kB\n", heap.total_size / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "HeapUsed:     %d kB\n", heap.used_size / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "HeapFree:     %d kB\n", heap.free_size / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "HeapPeak:     %d kB\n", heap.peak_used / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "HeapLargest:  %d kB\n", heap.largest_free / 1024);
+    offset += snprintf(buf + offset, buf_size - offset, "HeapFrag:     %d%%\n", heap.fragmentation);
+    offset += snprintf(buf + offset, buf_size - offset, "Slab:         %d kB\n",
+                       kmem_cache_frames() * (PAGE_SIZE / 1024));
+    offset += snprintf(buf + offset, buf_size - offset, "VmallocUsed:  %d kB\n", vm.pages * (PAGE_SIZE / 1024));
+    
+    // 伙伴分配器每阶空闲块数（外部碎片：高阶为 0 时无法满足大块连续分配）
+    static const char* zone_names[BUDDY_ZONE_COUNT] = {"Normal", "HighMem"};
+    for (uint32_t zone = 0; zone < BUDDY_ZONE_COUNT; zone++) {
+        offset += snprintf(buf + offset, buf_size - offset, "\nBuddy %s:", zone_names[zone]);
+        for (uint32_t order = 0; order < BUDDY_ORDER_COUNT; order++) {
+            offset += snprintf(buf + offset, buf_size - offset, " %d",
+                               buddy_get_free_area(zone, order)->free_list.count);
+        }
+    }
+    offset += snprintf(buf + offset, buf_size - offset, "\n");
     
     return offset;
 }
 
+// 生成slab缓存统计内容
+static int generate_proc_slabinfo_content(char* buf, size_t buf_size) {
+    if (!buf) {
+        return 0;
+    }
+    
+    return kmem_cache_info(buf, buf_size);
+}
+
+// 生成内核堆分析内容
+static int generate_proc_kheapprof_content(char* buf, size_t buf_size) {
+    if (!buf) {
+        return 0;
+    }
+    
+    return kheap_prof_info(buf, buf_size);
+}
+
 // 生成进程文件描述符内容
 static int generate_proc_pid_fd_content(uint32_t pid, char* buf, size_t buf_size) {
     if (!buf) {
@@ -57,6 +163,40 @@ static int generate_proc_pid_fd_content(uint32_t pid, char* buf, size_t buf_size
     return offset;
 }
 
+// 进程列表的输出位置
+typedef struct {
+    char* buf;
+    size_t buf_size;
+    int offset;
+} proc_ps_ctx_t;
+
+// 输出一个进程（在 tasklist_lock 下调用）
+static void proc_ps_line(task_t* task, void* arg) {
+    proc_ps_ctx_t* ctx = (proc_ps_ctx_t*)arg;
+    if (ctx->offset >= ctx->buf_size) {
+        return;
+    }
+    
+    // 获取进程状态字符串
+    const char* state_str;
+    switch (task->state) {
+        case TASK_READY: state_str = "READY";
+            break;
+        case TASK_RUNNING: state_str = "RUNNING";
+            break;
+        case TASK_BLOCKED: state_str = "BLOCKED";
+            break;
+        case TASK_ZOMBIE: state_str = "ZOMBIE";
+            break;
+        default: state_str = "UNKNOWN";
+            break;
+    }
+    
+    // 输出进程信息
+    ctx->offset += snprintf(ctx->buf + ctx->offset, ctx->buf_size - ctx->offset, "%d\t%s\t%s\t%d\t%d\t\n", 
+                            task->pid, state_str, task->name, task->priority, task->total_runtime);
+}
+
 // 生成进程列表内容
 static int generate_proc_ps_content(char* buf, size_t buf_size) {
     if (!buf) {
@@ -69,68 +209,11 @@ static int generate_proc_ps_content(char* buf, size_t buf_size) {
         return offset;
     }
     
-    // 获取当前进程
-    extern task_t* current_task;
+    // 遍历所有进程（包括阻塞和僵尸进程）
+    proc_ps_ctx_t ctx = { buf, buf_size, offset };
+    sched_for_each_task(proc_ps_line, &ctx);
     
-    // 输出当前进程信息
-    if (current_task) {
-        // 获取进程状态字符串
-        const char* state_str;
-        switch (current_task->state) {
-            case TASK_READY: state_str = "READY";
-                break;
-            case TASK_RUNNING: state_str = "RUNNING";
-                break;
-            case TASK_BLOCKED: state_str = "BLOCKED";
-                break;
-            case TASK_ZOMBIE: state_str = "ZOMBIE";
-                break;
-            default: state_str = "UNKNOWN";
-                break;
-        }
-        
-        // 输出进程信息
-        offset += snprintf(buf + offset, buf_size - offset, "%d\t%s\t%s\t%d\t%d\t\n", 
-                          current_task->pid, state_str, current_task->name, current_task->priority, current_task->total_runtime);
-        
-        if (offset >= buf_size) {
-            return offset;
-        }
-    }
-    
-    // 遍历所有就绪队列
-    extern task_t* ready_queue[];
-    for (int i = 0; i < MAX_PRIORITY; i++) {
-        task_t* task = ready_queue[i];
-        while (task) {
-            // 获取进程状态字符串
-            const char* state_str;
-            switch (task->state) {
-                case TASK_READY: state_str = "READY";
-                    break;
-                case TASK_RUNNING: state_str = "RUNNING";
-                    break;
-                case TASK_BLOCKED: state_str = "BLOCKED";
-                    break;
-                case TASK_ZOMBIE: state_str = "ZOMBIE";
-                    break;
-                default: state_str = "UNKNOWN";
-                    break;
-            }
-            
-            // 输出进程信息
-            offset += snprintf(buf + offset, buf_size - offset, "%d\t%s\t%s\t%d\t%d\t\n", 
-                              task->pid, state_str, task->name, task->priority, task->total_runtime);
-            
-            if (offset >= buf_size) {
-                return offset;
-            }
-            
-            task = task->sibling_next;
-        }
-    }
-    
-    return offset;
+    return ctx.offset;
 }
 
 // 生成单个进程状态内容
@@ -139,31 +222,7 @@ static int generate_proc_pid_status_content(uint32_t pid, char* buf, size_t buf_
         return 0;
     }
     
-    task_t* task = NULL;
-    
-    // 首先检查当前进程
-    extern task_t* current_task;
-    if (current_task && current_task->pid == pid) {
-        task = current_task;
-    }
-    
-    // 如果不是当前进程，遍历就绪队列
-    if (!task) {
-        extern task_t* ready_queue[];
-        for (int i = 0; i < MAX_PRIORITY; i++) {
-            task_t* t = ready_queue[i];
-            while (t) {
-                if (t->pid == pid) {
-                    task = t;
-                    break;
-                }
-                t = t->sibling_next;
-            }
-            if (task) {
-                break;
-            }
-        }
-    }
+    task_t* task = find_task(pid);
     
     // 如果找到了进程
     if (task) {
@@ -187,12 +246,27 @@ static int generate_proc_pid_status_content(uint32_t pid, char* buf, size_t buf_
         offset += snprintf(buf + offset, buf_size - offset, "PID: %d\n", task->pid);
         offset += snprintf(buf + offset, buf_size - offset, "State: %s\n", state_str);
         offset += snprintf(buf + offset, buf_size - offset, "Priority: %d\n", task->priority);
+        offset += snprintf(buf + offset, buf_size - offset, "Policy: %s\n", sched_policy_name(task->policy));
+        offset += snprintf(buf + offset, buf_size - offset, "Nice: %d\n", task->nice);
+        offset += snprintf(buf + offset, buf_size - offset, "Cpu: %d\n", task->cpu);
+        offset += snprintf(buf + offset, buf_size - offset, "Migrations: %d\n", task->nr_migrations);
+        if (task->policy == SCHED_FAIR) {
+            offset += snprintf(buf + offset, buf_size - offset, "Weight: %d\n", task->weight);
+            offset += snprintf(buf + offset, buf_size - offset, "Vruntime: %d us\n", task->vruntime);
+        }
         offset += snprintf(buf + offset, buf_size - offset, "Total Time: %d\n", task->total_runtime);
         offset += snprintf(buf + offset, buf_size - offset, "Parent PID: %d\n", task->parent ? task->parent->pid : 0);
         offset += snprintf(buf + offset, buf_size - offset, "Page Directory: 0x%x\n", (uint32_t)task->page_dir);
+        if (task->mm) {
+            offset += snprintf(buf + offset, buf_size - offset, "VmSize: %d kB\n", task->mm->total_pages * (PAGE_SIZE / 1024));
+            offset += snprintf(buf + offset, buf_size - offset, "VmRSS: %d kB\n", task->mm->rss_pages * (PAGE_SIZE / 1024));
+            offset += snprintf(buf + offset, buf_size - offset, "Page Faults: %d\n", task->mm->fault_count);
+            offset += snprintf(buf + offset, buf_size - offset, "COW Copies: %d\n", task->mm->cow_copies);
+        }
         offset += snprintf(buf + offset, buf_size - offset, "Kernel ESP: 0x%x\n", task->kernel_stack_top);
         offset += snprintf(buf + offset, buf_size - offset, "User ESP: 0x%x\n", task->user_stack_top);
         
+        task_put(task);
         return offset;
     }
     
@@ -201,10 +275,13 @@ static int generate_proc_pid_status_content(uint32_t pid, char* buf, size_t buf_
 
 // 读取/proc/ps文件
 static int proc_read_ps(inode_t* inode, void* buf, size_t count, uint32_t offset) {
-    char proc_buf[1024];
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SIZE);
+    if (!proc_buf) {
+        return -1;
+    }
     
     // 生成进程列表内容
-    int content_size = generate_proc_ps_content(proc_buf, sizeof(proc_buf));
+    int content_size = generate_proc_ps_content(proc_buf, PROC_BUF_SIZE);
     
     // 检查偏移量
     if (offset >= content_size) {
@@ -222,13 +299,16 @@ static int proc_read_ps(inode_t* inode, void* buf, size_t count, uint32_t offset
 
 // 读取/proc/[pid]/status文件
 static int proc_read_pid_status(inode_t* inode, void* buf, size_t count, uint32_t offset) {
-    char proc_buf[1024];
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SIZE);
+    if (!proc_buf) {
+        return -1;
+    }
     
     // 从inode中获取PID（简化实现：假设inode->inode字段存储PID）
     uint32_t pid = inode->inode;
     
     // 生成进程状态内容
-    int content_size = generate_proc_pid_status_content(pid, proc_buf, sizeof(proc_buf));
+    int content_size = generate_proc_pid_status_content(pid, proc_buf, PROC_BUF_SIZE);
     
     // 检查偏移量
     if (offset >= content_size) {
@@ -246,10 +326,37 @@ static int proc_read_pid_status(inode_t* inode, void* buf, size_t count, uint32_
 
 // 读取/proc/loadavg文件
 static int proc_read_loadavg(inode_t* inode, void* buf, size_t count, uint32_t offset) {
-    char proc_buf[128];
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SMALL);
+    if (!proc_buf) {
+        return -1;
+    }
     
     // 生成负载内容
-    int content_size = generate_proc_loadavg_content(proc_buf, sizeof(proc_buf));
+    int content_size = generate_proc_loadavg_content(proc_buf, PROC_BUF_SMALL);
+    
+    // 检查偏移量
+    if (offset >= content_size) {
+        return 0;
+    }
+    
+    // 计算实际读取的字节数
+    size_t read_size = (offset + count > content_size) ? (content_size - offset) : count;
+    
+    // 复制内容到缓冲区
+    memcpy(buf, proc_buf + offset, read_size);
+    
+    return read_size;
+}
+
+// 读取/proc/stat文件
+static int proc_read_stat(inode_t* inode, void* buf, size_t count, uint32_t offset) {
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SIZE);
+    if (!proc_buf) {
+        return -1;
+    }
+    
+    // 生成处理器时间统计内容
+    int content_size = generate_proc_stat_content(proc_buf, PROC_BUF_SIZE);
     
     // 检查偏移量
     if (offset >= content_size) {
@@ -267,10 +374,61 @@ static int proc_read_loadavg(inode_t* inode, void* buf, size_t count, uint32_t o
 
 // 读取/proc/meminfo文件
 static int proc_read_meminfo(inode_t* inode, void* buf, size_t count, uint32_t offset) {
-    char proc_buf[1024];
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SIZE);
+    if (!proc_buf) {
+        return -1;
+    }
     
     // 生成内存信息内容
-    int content_size = generate_proc_meminfo_content(proc_buf, sizeof(proc_buf));
+    int content_size = generate_proc_meminfo_content(proc_buf, PROC_BUF_SIZE);
+    
+    // 检查偏移量
+    if (offset >= content_size) {
+        return 0;
+    }
+    
+    // 计算实际读取的字节数
+    size_t read_size = (offset + count > content_size) ? (content_size - offset) : count;
+    
+    // 复制内容到缓冲区
+    memcpy(buf, proc_buf + offset, read_size);
+    
+    return read_size;
+}
+
+// 读取/proc/slabinfo文件
+static int proc_read_slabinfo(inode_t* inode, void* buf, size_t count, uint32_t offset) {
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SIZE);
+    if (!proc_buf) {
+        return -1;
+    }
+    
+    // 生成slab统计内容
+    int content_size = generate_proc_slabinfo_content(proc_buf, PROC_BUF_SIZE);
+    
+    // 检查偏移量
+    if (offset >= content_size) {
+        return 0;
+    }
+    
+    // 计算实际读取的字节数
+    size_t read_size = (offset + count > content_size) ? (content_size - offset) : count;
+    
+    // 复制内容到缓冲区
+    memcpy(buf, proc_buf + offset, read_size);
+    
+    return read_size;
+}
+
+// 读取/proc/kheapprof文件
+static int proc_read_kheapprof(inode_t* inode, void* buf, size_t count, uint32_t offset) {
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_LARGE);
+    if (!proc_buf) {
+        return -1;
+    }
+    
+    // 生成内核堆分析内容
+    int content_size = generate_proc_kheapprof_content(proc_buf, PROC_BUF_LARGE);
     
     // 检查偏移量
     if (offset >= content_size) {
@@ -288,13 +446,16 @@ static int proc_read_meminfo(inode_t* inode, void* buf, size_t count, uint32_t o
 
 // 读取/proc/[pid]/fd文件
 static int proc_read_pid_fd(inode_t* inode, void* buf, size_t count, uint32_t offset) {
-    char proc_buf[128];
+    char* proc_buf = (char*)scratch_alloc(PROC_BUF_SMALL);
+    if (!proc_buf) {
+        return -1;
+    }
     
     // 从inode中获取PID
     uint32_t pid = inode->inode;
     
     // 生成文件描述符内容
-    int content_size = generate_proc_pid_fd_content(pid, proc_buf, sizeof(proc_buf));
+    int content_size = generate_proc_pid_fd_content(pid, proc_buf, PROC_BUF_SMALL);
     
     // 检查偏移量
     if (offset >= content_size) {
@@ -355,3 +516,60 @@ fs_operations_t* get_proc_pid_ops(void) {
     
     return &proc_pid_ops;
 }
+
+// 获取/proc/slabinfo的读取函数
+fs_operations_t* get_proc_slabinfo_ops(void) {
+    static fs_operations_t proc_slabinfo_ops = {
+        .read = proc_read_slabinfo,
+        // 其他操作暂时未实现
+        .create = NULL,
+        .open = NULL,
+        .close = NULL,
+        .write = NULL,
+        .unlink = NULL,
+        .mkdir = NULL,
+        .rmdir = NULL,
+        .readdir = NULL,
+        .rename = NULL
+    };
+    
+    return &proc_slabinfo_ops;
+}
+
+// 获取/proc/kheapprof的读取函数
+fs_operations_t* get_proc_kheapprof_ops(void) {
+    static fs_operations_t proc_kheapprof_ops = {
+        .read = proc_read_kheapprof,
+        // 其他操作暂时未实现
+        .create = NULL,
+        .open = NULL,
+        .close = NULL,
+        .write = NULL,
+        .unlink = NULL,
+        .mkdir = NULL,
+        .rmdir = NULL,
+        .readdir = NULL,
+        .rename = NULL
+    };
+    
+    return &proc_kheapprof_ops;
+}
+
+// 获取/proc/stat的读取函数
+fs_operations_t* get_proc_stat_ops(void) {
+    static fs_operations_t proc_stat_ops = {
+        .read = proc_read_stat,
+        // 其他操作暂时未实现
+        .create = NULL,
+        .open = NULL,
+        .close = NULL,
+        .write = NULL,
+        .unlink = NULL,
+        .mkdir = NULL,
+        .rmdir = NULL,
+        .readdir = NULL,
+        .rename = NULL
+    };
+    
+    return &proc_stat_ops;
+}
@@ -1,22 +1,92 @@
 #include <proc/task.h>
+#include <proc/sched.h>
+#include <proc/timer.h>
+#include <proc/wait.h>
 #include <mm/paging.h>
 #include <mm/kheap.h>
+#include <mm/zeropool.h>
+#include <mm/slab.h>
 #include <string.h>
+#include <common.h>
 #include <vga.h>
 #include <serial.h>
 #include <interrupts.h>
+#include <pit.h>
+#include <apic.h>
+#include <proc/smp.h>
 
 // 全局变量
-static task_t* ready_queue[MAX_PRIORITY];  // 优先级就绪队列
-static task_t* current_task = NULL;        // 当前运行进程
+static runqueue_t runqueues[MAX_CPUS];     // 每个处理器的就绪队列
+static task_t* task_list = NULL;           // 所有进程（按创建时间倒序）
 static uint32_t next_pid = 1;              // 下一个PID
-static uint32_t system_ticks = 0;          // 系统时钟中断计数
+static spinlock_t tasklist_lock = SPINLOCK_INIT;  // 保护 task_list 和 next_pid
+static uint32_t system_ticks = 0;          // 系统时钟中断计数（只由 BSP 的 PIT 中断推进）
+static kmem_cache_t* task_cache = NULL;    // 进程控制块对象缓存
+static task_t* init_task = NULL;           // init 进程（PID 1），收养父进程已被回收的子进程
 
 // 时间片大小（时钟中断次数）
 #define TIME_SLICE 10
 
-// 全局变量声明
-task_t* current_task = NULL;
+// 空闲进程：每个处理器一个，静态分配，从不进入就绪队列，就绪队列为空时直接选中
+// AP 的启动代码直接使用空闲进程的栈，进入调度器后由空闲进程接管
+static task_t idle_tasks[MAX_CPUS];
+static uint8_t idle_stacks[MAX_CPUS][4096] __attribute__((aligned(4096)));
+
+// 负载均值：每 5 秒按指数衰减更新一次（定点数，与 Linux 的计算方法相同）
+#define LOAD_FREQ (5 * TIMER_HZ)
+#define FIXED_1 (1 << LOAD_FSHIFT)
+#define EXP_1 1884                // FIXED_1 / e^(5/60)
+#define EXP_5 2014                // FIXED_1 / e^(5/300)
+#define EXP_15 2037               // FIXED_1 / e^(5/900)
+
+static uint32_t load_avg[3] = {0, 0, 0};      // 1、5、15 分钟负载均值
+static uint32_t load_countdown = LOAD_FREQ;   // 距下次更新负载的时钟滴答数
+
+// 空闲时停止周期性时钟滴答：PIT 改为单次模式，由下一个截止时间或其他中断唤醒，醒来后补记滴答
+// 只用于 BSP；AP 停止的是各自的本地 APIC 定时器（见 lapic_nohz_idle_enter）
+static uint32_t tick_period = 0;              // 一个时钟滴答对应的 PIT 计数
+static bool tick_stopped = false;             // PIT 处于单次模式
+static uint32_t nohz_programmed = 0;          // 停止滴答时设定的单次计数
+static uint32_t nohz_residual = 0;            // 补记后不足一个滴答的 PIT 计数
+static uint32_t timer_interrupts = 0;         // 实际发生的时钟中断次数
+static uint32_t nohz_ticks = 0;               // 停止滴答期间补记的滴答数
+static uint32_t lapic_period = 0;             // 一个时钟滴答对应的本地 APIC 定时器计数（AP 使用）
+
+// 本处理器的就绪队列
+static inline runqueue_t* this_rq(void)
+{
+    return &runqueues[smp_processor_id()];
+}
+
+// 进程所在处理器的就绪队列
+static inline runqueue_t* task_rq(const task_t* task)
+{
+    return &runqueues[task->cpu];
+}
+
+static inline bool is_idle_task(const task_t* task)
+{
+    return task == runqueues[task->cpu].idle;
+}
+
+// 锁住进程所在处理器的就绪队列：负载均衡会在持有两个队列的锁时修改 task->cpu，加锁后需要确认未被迁移
+static runqueue_t* task_rq_lock(task_t* task, uint32_t* flags)
+{
+    for (;;) {
+        runqueue_t* rq = task_rq(task);
+        *flags = spin_lock_irqsave(&rq->lock);
+        if (rq == task_rq(task)) {
+            return rq;
+        }
+        spin_unlock_irqrestore(&rq->lock, *flags);
+    }
+}
+
+// 就绪队列的时钟：该处理器经过的时钟滴答数（包括停止滴答后补记的），用于判断进程的缓存是否仍热
+static inline uint32_t rq_clock(const runqueue_t* rq)
+{
+    return rq->busy_ticks + rq->idle_ticks;
+}
 
 // 获取系统时钟中断次数
 uint32_t get_system_ticks(void)
@@ -24,61 +94,623 @@ uint32_t get_system_ticks(void)
     return system_ticks;
 }
 
+// 最高置位的位号（bitmap 不为 0）
+static inline uint32_t rq_highest(uint32_t bitmap)
+{
+    uint32_t bit;
+    asm("bsr %1, %0" : "=r" (bit) : "rm" (bitmap));
+    return bit;
+}
+
+// 最低置位的位号（bitmap 不为 0）
+static inline uint32_t rq_lowest(uint32_t bitmap)
+{
+    uint32_t bit;
+    asm("bsf %1, %0" : "=r" (bit) : "rm" (bitmap));
+    return bit;
+}
+
+// 进程加入所在优先级链表的队尾
+static void prio_enqueue(runqueue_t* rq, task_t* task, int flags)
+{
+    UNUSED(flags);
+    
+    prio_rq_t* prio = &rq->prio;
+    run_list_t* list = &prio->lists[task->priority];
+    
+    task->rq_next = NULL;
+    task->rq_prev = list->tail;
+    if (list->tail) {
+        list->tail->rq_next = task;
+    } else {
+        list->head = task;
+    }
+    list->tail = task;
+    list->count++;
+    
+    prio->bitmap |= 1U << task->priority;
+    prio->nr_ready++;
+}
+
+// 进程移出所在优先级链表
+static void prio_dequeue(runqueue_t* rq, task_t* task)
+{
+    prio_rq_t* prio = &rq->prio;
+    run_list_t* list = &prio->lists[task->priority];
+    
+    if (task->rq_prev) {
+        task->rq_prev->rq_next = task->rq_next;
+    } else {
+        list->head = task->rq_next;
+    }
+    if (task->rq_next) {
+        task->rq_next->rq_prev = task->rq_prev;
+    } else {
+        list->tail = task->rq_prev;
+    }
+    task->rq_next = NULL;
+    task->rq_prev = NULL;
+    list->count--;
+    
+    if (!list->head) {
+        prio->bitmap &= ~(1U << task->priority);
+    }
+    prio->nr_ready--;
+}
+
+// 取出最高优先级链表的队首进程：一次 bsr 找到优先级，与就绪进程数无关
+static task_t* prio_pick_next(runqueue_t* rq)
+{
+    if (!rq->prio.bitmap) {
+        return NULL;
+    }
+    
+    task_t* task = rq->prio.lists[rq_highest(rq->prio.bitmap)].head;
+    prio_dequeue(rq, task);
+    return task;
+}
+
+// 换下的进程重新获得完整的时间片，放回队尾后与同优先级进程轮流运行
+static void prio_put_prev(runqueue_t* rq, task_t* task)
+{
+    UNUSED(rq);
+    task->time_slice = TIME_SLICE;
+}
+
+// 时间片用完，或有更高优先级的进程就绪时抢占当前进程
+static bool prio_tick(runqueue_t* rq, task_t* curr)
+{
+    if (curr->time_slice > 0) {
+        curr->time_slice--;
+    }
+    return curr->time_slice == 0 || (rq->prio.bitmap >> (curr->priority + 1)) != 0;
+}
+
+// 被唤醒的进程优先级更高时抢占
+static bool prio_check_preempt(runqueue_t* rq, task_t* curr, task_t* woken)
+{
+    UNUSED(rq);
+    return woken->priority > curr->priority;
+}
+
+static void prio_switched_to(runqueue_t* rq, task_t* task)
+{
+    UNUSED(rq);
+    task->time_slice = TIME_SLICE;
+}
+
+// 从最低优先级开始、每个链表从队尾开始寻找可迁移的进程（本队列最晚才会运行它们）
+static task_t* prio_steal(runqueue_t* rq, sched_steal_filter_t filter, void* arg)
+{
+    for (uint32_t bitmap = rq->prio.bitmap; bitmap; bitmap &= bitmap - 1) {
+        run_list_t* list = &rq->prio.lists[rq_lowest(bitmap)];
+        for (task_t* task = list->tail; task; task = task->rq_prev) {
+            if (filter(task, arg)) {
+                return task;
+            }
+        }
+    }
+    return NULL;
+}
+
+const sched_class_t prio_sched_class = {
+    .name = "prio",
+    .enqueue = prio_enqueue,
+    .dequeue = prio_dequeue,
+    .pick_next = prio_pick_next,
+    .put_prev = prio_put_prev,
+    .tick = prio_tick,
+    .check_preempt = prio_check_preempt,
+    .switched_to = prio_switched_to,
+    .steal = prio_steal,
+    .migrate = NULL,
+    .set_curr = NULL,
+};
+
+// 调度类按策略编号排列，编号小的调度类优先
+static const sched_class_t* const sched_classes[SCHED_NR_POLICIES] = {
+    [SCHED_PRIO] = &prio_sched_class,
+    [SCHED_FAIR] = &fair_sched_class,
+};
+
+// 进程所属的调度类
+const sched_class_t* task_sched_class(const task_t* task)
+{
+    return sched_classes[task->policy];
+}
+
+// 调度策略名称
+const char* sched_policy_name(uint32_t policy)
+{
+    return policy < SCHED_NR_POLICIES ? sched_classes[policy]->name : "unknown";
+}
+
+// 初始化就绪队列
+void rq_init(runqueue_t* rq)
+{
+    memset(rq, 0, sizeof(runqueue_t));
+}
+
+// 进程加入所属调度类的队列
+void rq_enqueue(runqueue_t* rq, task_t* task, int flags)
+{
+    task_sched_class(task)->enqueue(rq, task, flags);
+    rq->nr_ready++;
+    task->state = TASK_READY;
+}
+
+// 进程移出所属调度类的队列
+void rq_dequeue(runqueue_t* rq, task_t* task)
+{
+    task_sched_class(task)->dequeue(rq, task);
+    rq->nr_ready--;
+}
+
+// 按调度类的顺序取出第一个有就绪进程的调度类选出的进程
+task_t* rq_pick_next(runqueue_t* rq)
+{
+    for (uint32_t i = 0; i < SCHED_NR_POLICIES; i++) {
+        task_t* task = sched_classes[i]->pick_next(rq);
+        if (task) {
+            rq->nr_ready--;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// 按调度类的顺序选出一个可以窃取的就绪进程（不移出队列）
+static task_t* rq_steal(runqueue_t* rq, sched_steal_filter_t filter, void* arg)
+{
+    for (uint32_t i = 0; i < SCHED_NR_POLICIES; i++) {
+        task_t* task = sched_classes[i]->steal(rq, filter, arg);
+        if (task) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// 进程入队后检查是否应抢占当前进程：前面调度类的进程总是抢占后面调度类的进程（调用者持有 rq->lock）
+static void check_preempt_wakeup(runqueue_t* rq, task_t* task)
+{
+    task_t* curr = rq->curr;
+    if (!curr || curr == task || curr->state != TASK_RUNNING) {
+        return;
+    }
+    
+    if (curr == rq->idle || task->policy < curr->policy) {
+        rq->need_resched = true;
+    } else if (task->policy == curr->policy &&
+               task_sched_class(task)->check_preempt(rq, curr, task)) {
+        rq->need_resched = true;
+    }
+}
+
+// 进程加入所在处理器的就绪队列并检查唤醒抢占，需要抢占其他处理器时发送 IPI
+static void enqueue_task(task_t* task, int enqueue_flags)
+{
+    uint32_t flags;
+    runqueue_t* rq = task_rq_lock(task, &flags);
+    rq_enqueue(rq, task, enqueue_flags);
+    check_preempt_wakeup(rq, task);
+    bool resched = rq->need_resched;
+    spin_unlock_irqrestore(&rq->lock, flags);
+    
+    if (resched) {
+        smp_send_resched(rq->cpu);
+    }
+}
+
+// 将进程放入所在处理器的就绪队列
+void sched_enqueue(task_t* task)
+{
+    if (is_idle_task(task)) {
+        return;
+    }
+    enqueue_task(task, ENQUEUE_WAKEUP);
+}
+
+// 唤醒阻塞的进程
+// 进程可能在其他处理器上刚标记为阻塞、还没有让出处理器：此时只恢复为运行状态，由它自己的 schedule 继续运行
+bool sched_wakeup(task_t* task)
+{
+    uint32_t flags;
+    runqueue_t* rq = task_rq_lock(task, &flags);
+    
+    bool blocked = task->state == TASK_BLOCKED;
+    bool resched = false;
+    if (blocked && rq->curr == task) {
+        task->state = TASK_RUNNING;
+    } else if (blocked) {
+        rq_enqueue(rq, task, ENQUEUE_WAKEUP);
+        check_preempt_wakeup(rq, task);
+        resched = rq->need_resched;
+    }
+    
+    spin_unlock_irqrestore(&rq->lock, flags);
+    
+    if (resched) {
+        smp_send_resched(rq->cpu);
+    }
+    return blocked;
+}
+
+// 设置当前进程的状态：其他处理器上的唤醒和窃取都在 rq->lock 下读写 state
+void set_current_state(task_state_t state)
+{
+    uint32_t flags;
+    task_t* task = current_task;
+    runqueue_t* rq = task_rq_lock(task, &flags);
+    task->state = state;
+    spin_unlock_irqrestore(&rq->lock, flags);
+}
+
+// 将就绪进程移出所在处理器的就绪队列
+void sched_dequeue(task_t* task)
+{
+    uint32_t flags;
+    runqueue_t* rq = task_rq_lock(task, &flags);
+    if (task->state == TASK_READY && !is_idle_task(task)) {
+        rq_dequeue(rq, task);
+    }
+    spin_unlock_irqrestore(&rq->lock, flags);
+}
+
+// 设置进程的调度策略和 nice 值
+int sched_setscheduler(task_t* task, uint32_t policy, int nice)
+{
+    if (!task || is_idle_task(task) || task->state == TASK_ZOMBIE ||
+        policy >= SCHED_NR_POLICIES || nice < NICE_MIN || nice > NICE_MAX) {
+        return -1;
+    }
+    
+    uint32_t flags;
+    runqueue_t* rq = task_rq_lock(task, &flags);
+    
+    // 先从原调度类中取出，修改后再交给新调度类，权重变化同时反映到队列负载上
+    bool queued = task->state == TASK_READY;
+    bool running = task == rq->curr && task->state == TASK_RUNNING;
+    if (queued) {
+        rq_dequeue(rq, task);
+    } else if (running) {
+        task_sched_class(task)->put_prev(rq, task);
+    }
+    
+    bool switched = task->policy != policy;
+    task->policy = policy;
+    task->nice = nice;
+    task->weight = sched_nice_to_weight(nice);
+    if (switched) {
+        task_sched_class(task)->switched_to(rq, task);
+    }
+    
+    // 就绪进程放回队列；正在运行的进程不入队（它仍在运行，入队会标记为就绪），
+    // 交给新调度类作为当前进程，由 schedule 像其他被换下的进程一样重新入队并重新选择
+    if (queued) {
+        rq_enqueue(rq, task, 0);
+    } else if (running) {
+        const sched_class_t* class = task_sched_class(task);
+        if (class->set_curr) {
+            class->set_curr(rq, task);
+        }
+        rq->need_resched = true;
+    }
+    
+    spin_unlock_irqrestore(&rq->lock, flags);
+    
+    kprintf("[SCHED] PID %d policy %s, nice %d\n", task->pid, sched_policy_name(policy), nice);
+    
+    // 在其他处理器上运行的进程由该处理器重新调度
+    if (running && rq == this_rq()) {
+        schedule();
+    } else if (running) {
+        smp_send_resched(rq->cpu);
+    }
+    return 0;
+}
+
+// 按 PID 查找进程，在 tasklist_lock 下取得引用
+task_t* find_task(uint32_t pid)
+{
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    task_t* found = NULL;
+    for (task_t* task = task_list; task; task = task->task_next) {
+        if (task->pid == pid) {
+            found = task;
+            found->usage++;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+    return found;
+}
+
+// 释放进程引用，最后一个引用释放时释放进程控制块和内核栈
+void task_put(task_t* task)
+{
+    if (!task) {
+        return;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    bool last = --task->usage == 0;
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+    
+    if (last) {
+        kfree((void*)(task->kernel_stack_top - 4096));
+        kmem_cache_free(task_cache, task);
+    }
+}
+
+// 遍历所有进程，整个过程持有 tasklist_lock，进程不会被释放
+void sched_for_each_task(void (*fn)(task_t* task, void* arg), void* arg)
+{
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    for (task_t* task = task_list; task; task = task->task_next) {
+        fn(task, arg);
+    }
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+}
+
 // 辅助函数：获取对齐的内存地址
 static void* align_address(void* addr, uint32_t align)
 {
     return (void*)((uint32_t)addr & ~(align - 1));
 }
 
-// 创建空闲进程
-static task_t* create_idle_task(void)
+// 就绪队列上可运行的进程数：就绪进程加上正在运行的非空闲进程
+static uint32_t rq_nr_running(const runqueue_t* rq)
 {
-    // 分配PCB
-    task_t* idle_task = (task_t*)kmalloc(sizeof(task_t));
-    if (!idle_task) {
-        kprintf("[ERROR] Failed to allocate idle task PCB\n");
-        return NULL;
+    return rq->nr_ready + (rq->curr && rq->curr != rq->idle ? 1 : 0);
+}
+
+// 窃取时的筛选条件和结果
+typedef struct {
+    uint32_t now;                 // 被窃取队列的时钟
+    bool allow_hot;               // 多次失败后不再顾及缓存
+    uint32_t hot;                 // 因缓存热而跳过的进程数
+    uint32_t busy;                // 上下文尚未保存完而跳过的进程数
+} steal_env_t;
+
+// 进程能否迁移：上下文已经保存完，且最近没有运行过（缓存已凉）
+static bool can_migrate_task(task_t* task, void* arg)
+{
+    steal_env_t* env = (steal_env_t*)arg;
+    if (task->on_cpu) {
+        env->busy++;
+        return false;
+    }
+    if (!env->allow_hot && env->now - task->last_ran < SCHED_MIGRATION_COST_TICKS) {
+        env->hot++;
+        return false;
+    }
+    return true;
+}
+
+// 最忙的其他处理器：可运行进程至少 2 个（窃取后对方仍有进程可运行）中最多的一个
+// 不加锁读取，只作参考，窃取时在锁内重新检查
+static runqueue_t* find_busiest_queue(runqueue_t* this)
+{
+    runqueue_t* busiest = NULL;
+    uint32_t max_load = 1;
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        runqueue_t* rq = &runqueues[cpu];
+        if (rq == this || !smp_cpu_online(cpu) || rq->nr_ready == 0) {
+            continue;
+        }
+        uint32_t load = rq_nr_running(rq);
+        if (load > max_load) {
+            busiest = rq;
+            max_load = load;
+        }
+    }
+    return busiest;
+}
+
+// 空闲处理器从最忙的就绪队列窃取一个进程（空闲进程调用，调用者关中断）
+// 先锁本队列，对方队列只尝试一次加锁：被占用时放弃，两个处理器互相窃取时不会互相等待
+// 只找到缓存热的进程时等到下一个滴答再试，连续 SCHED_CACHE_NICE_TRIES 次后不再顾及缓存
+// 返回 1 表示本队列已有就绪进程，0 表示没有可窃取的进程，-1 表示有积压但暂时不能窃取
+static int idle_balance(runqueue_t* this)
+{
+    spin_lock(&this->lock);
+    if (this->nr_ready) {
+        spin_unlock(&this->lock);
+        return 1;
+    }
+    if ((int32_t)(rq_clock(this) - this->next_balance) < 0) {
+        spin_unlock(&this->lock);
+        return -1;
     }
     
-    memset(idle_task, 0, sizeof(task_t));
-    idle_task->pid = 0;
-    idle_task->state = TASK_READY;
-    idle_task->priority = 0;  // 最低优先级
-    idle_task->page_dir = get_kernel_page_dir();
-    idle_task->time_slice = TIME_SLICE;
-    idle_task->total_runtime = 0;
-    idle_task->last_scheduled = 0;
-    idle_task->memory_usage_kb = 4;
-    strcpy(idle_task->name, "idle");
+    runqueue_t* busiest = find_busiest_queue(this);
+    if (!busiest) {
+        this->balance_failed = 0;
+        spin_unlock(&this->lock);
+        return 0;
+    }
+    if (!spin_trylock(&busiest->lock)) {
+        this->next_balance = rq_clock(this) + 1;
+        spin_unlock(&this->lock);
+        return -1;
+    }
     
-    // 分配内核栈
-    void* kernel_stack = kmalloc(4096);
-    if (!kernel_stack) {
-        kfree(idle_task);
-        kprintf("[ERROR] Failed to allocate idle task kernel stack\n");
-        return NULL;
+    steal_env_t env = {
+        .now = rq_clock(busiest),
+        .allow_hot = this->balance_failed >= SCHED_CACHE_NICE_TRIES,
+        .hot = 0,
+        .busy = 0,
+    };
+    task_t* task = NULL;
+    if (rq_nr_running(busiest) >= 2) {
+        task = rq_steal(busiest, can_migrate_task, &env);
     }
     
-    idle_task->kernel_stack_top = (uint32_t)kernel_stack + 4096;
+    // 在两个队列的锁内完成迁移，其他处理器看到的 task->cpu 总与所在队列一致
+    if (task) {
+        rq_dequeue(busiest, task);
+        const sched_class_t* class = task_sched_class(task);
+        if (class->migrate) {
+            class->migrate(busiest, this, task);
+        }
+        task->cpu = this->cpu;
+        task->last_ran = rq_clock(this) - SCHED_MIGRATION_COST_TICKS;
+        task->nr_migrations++;
+        rq_enqueue(this, task, 0);
+        busiest->nr_stolen++;
+        this->nr_steals++;
+        this->balance_failed = 0;
+    } else if (env.hot || env.busy) {
+        this->balance_failed += env.hot ? 1 : 0;
+        this->next_balance = rq_clock(this) + 1;
+    }
+    this->hot_skips += env.hot;
     
-    // 设置初始上下文（idle任务的入口点）
-    idle_task->regs.eip = (uint32_t)\
-    (void*)() {
-        while (1) {
-            __asm__("hlt");
+    spin_unlock(&busiest->lock);
+    spin_unlock(&this->lock);
+    
+    if (task) {
+        return 1;
+    }
+    return (env.hot || env.busy) ? -1 : 0;
+}
+
+static void tick_nohz_idle_enter(void);
+static void tick_nohz_idle_exit(void);
+static void lapic_nohz_idle_enter(runqueue_t* rq);
+static void lapic_nohz_idle_exit(runqueue_t* rq);
+
+// 空闲进程主循环：本队列为空时先从其他处理器窃取进程，再利用空闲时间预先清零物理帧，无事可做时停机等待中断
+// 只有 BSP 停止时钟滴答，AP 由本地 APIC 定时器或重新调度 IPI 唤醒
+static void idle_loop(void)
+{
+    runqueue_t* rq = this_rq();
+    bool bsp = rq->cpu == 0;
+    
+    while (1) {
+        // 本队列的锁也会在中断中获取，窃取时关中断
+        __asm__ volatile("cli");
+        int pulled = rq->nr_ready ? 1 : idle_balance(rq);
+        __asm__ volatile("sti");
+        if (pulled > 0) {
+            schedule();
+            continue;
         }
-    };
+        
+        if (zero_pool_refill(ZERO_POOL_BATCH) != 0) {
+            continue;
+        }
+        
+        // sti 的下一条指令执行完之前不响应中断，检查就绪队列后停机不会错过唤醒
+        // 其他处理器有积压但暂时不能窃取时不停止时钟滴答，下一个滴答醒来重试
+        __asm__ volatile("cli");
+        if (rq->nr_ready == 0) {
+            if (bsp && pulled == 0) {
+                tick_nohz_idle_enter();
+            } else if (pulled == 0) {
+                lapic_nohz_idle_enter(rq);
+            }
+            __asm__ volatile("sti; hlt; cli");
+            if (bsp) {
+                tick_nohz_idle_exit();
+            } else {
+                lapic_nohz_idle_exit(rq);
+            }
+        }
+        __asm__ volatile("sti");
+    }
+}
+
+// 初始化处理器 cpu 的空闲进程（PID 0，名称为 idle、idle1、idle2 ...）
+static void init_idle_task(uint32_t cpu)
+{
+    task_t* idle = &idle_tasks[cpu];
+    memset(idle, 0, sizeof(task_t));
+    idle->pid = 0;
+    idle->state = TASK_READY;
+    idle->priority = 0;  // 最低优先级
+    idle->mm = vm_space_kernel();
+    idle->page_dir = idle->mm->page_dir;
+    idle->time_slice = TIME_SLICE;
+    idle->weight = NICE_0_LOAD;
+    idle->memory_usage_kb = 4;
+    idle->cpu = cpu;
+    strcpy(idle->name, "idle");
+    if (cpu) {
+        idle->name[4] = '0' + cpu;
+        idle->name[5] = '\0';
+    }
+    
+    // 使用静态内核栈（按页对齐，整个栈位于同一页内）
+    idle->kernel_stack_top = sched_idle_stack_top(cpu);
+    
+    // 设置初始上下文（idle任务的入口点）
+    idle->regs.eip = (uint32_t)idle_loop;
     
-    idle_task->regs.eflags = 0x202;  // IF=1
-    idle_task->regs.cs = 0x08;       // 内核代码段
-    idle_task->regs.ds = 0x10;       // 内核数据段
-    idle_task->regs.es = 0x10;
-    idle_task->regs.fs = 0x10;
-    idle_task->regs.gs = 0x10;
-    idle_task->regs.ss = 0x10;
-    idle_task->regs.esp = idle_task->kernel_stack_top;
+    idle->regs.eflags = 0x202;  // IF=1
+    idle->regs.cs = GDT_KERNEL_CODE;
+    idle->regs.ds = GDT_KERNEL_DATA;
+    idle->regs.es = GDT_KERNEL_DATA;
+    idle->regs.fs = GDT_KERNEL_DATA;
+    idle->regs.gs = GDT_PERCPU;
+    idle->regs.ss = GDT_KERNEL_DATA;
+    idle->regs.esp = idle->kernel_stack_top;
+    
+    runqueues[cpu].idle = idle;
+}
+
+// 空闲进程开始在本处理器上运行，加入进程链表
+static void idle_task_start(runqueue_t* rq)
+{
+    task_t* idle = rq->idle;
+    idle->state = TASK_RUNNING;
+    idle->on_cpu = true;
+    rq->curr = idle;
+    
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    idle->task_next = task_list;
+    task_list = idle;
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+}
+
+// 处理器 cpu 空闲进程的栈顶（AP 的启动代码也使用这个栈）
+uint32_t sched_idle_stack_top(uint32_t cpu)
+{
+    return (uint32_t)idle_stacks[cpu] + sizeof(idle_stacks[cpu]);
+}
+
+// init 进程：回收收养的子进程，没有子进程退出时阻塞
+static void init_main(void)
+{
+    kprintf("[INIT] Init process started\n");
     
-    return idle_task;
+    task_t* self = current_task;
+    while (1) {
+        task_t* child;
+        wait_event(self->child_exit, (child = sched_find_child(self, -1, true)) != NULL);
+        sched_reap(child);
+    }
 }
 
 // 初始化调度器
@@ -86,52 +718,69 @@ void sched_init(void)
 {
     kprintf("[SCHED] Initializing scheduler\n");
     
-    // 初始化就绪队列
-    for (int i = 0; i < MAX_PRIORITY; i++) {
-        ready_queue[i] = NULL;
+    // 初始化所有处理器的就绪队列和空闲进程
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        rq_init(&runqueues[cpu]);
+        runqueues[cpu].cpu = cpu;
+        init_idle_task(cpu);
     }
     
-    // 创建空闲进程（PID 0）
-    task_t* idle_task = create_idle_task();
-    if (!idle_task) {
-        kprintf("[ERROR] Failed to create idle task\n");
+    // 时钟中断以 TIMER_HZ 的频率周期性产生，空闲时临时改为单次模式
+    tick_period = pit_period_count(TIMER_HZ);
+    pit_set_periodic(TIMER_HZ);
+    timer_init();
+    
+    // 进程控制块按缓存行对齐，频繁访问的调度字段不与相邻对象共享缓存行
+    task_cache = kmem_cache_create("task_struct", sizeof(task_t), SLAB_COLOUR_ALIGN, NULL);
+    if (!task_cache) {
+        kprintf("[ERROR] Failed to create task cache\n");
         return;
     }
     
-    // 将idle任务加入就绪队列
-    ready_queue[0] = idle_task;
-    
     // 创建init进程（PID 1）
-    task_t* init_task = create_task(
-        (void*)() {
-            kprintf("[INIT] Init process started\n");
-            while (1) {
-                // 简单的init进程，持续运行
-                for (int i = 0; i < 1000000; i++) {
-                    __asm__("nop");
-                }
-            }
-        }, 
-        "init", 
-        5
-    );
+    init_task = create_task(init_main, "init", 5);
     
     if (!init_task) {
         kprintf("[ERROR] Failed to create init task\n");
         return;
     }
     
-    // 将init任务加入就绪队列
-    ready_queue[5] = init_task;
-    
-    // 设置当前进程为idle任务
-    current_task = idle_task;
+    // 设置当前进程为 BSP 的空闲进程
+    idle_task_start(this_rq());
     
     kprintf("[SCHED] Scheduler initialized with idle task (PID 0) and init task (PID 1)\n");
 }
 
+// AP 进入调度器：空闲进程接管启动栈，开启本地 APIC 定时器后开始调度（不返回）
+void sched_ap_start(uint32_t lapic_ticks)
+{
+    runqueue_t* rq = this_rq();
+    idle_task_start(rq);
+    smp_set_kernel_stack(rq->idle->kernel_stack_top);
+    
+    // 标记在线后 create_task 和唤醒才会选择本处理器
+    this_cpu()->online = true;
+    lapic_period = lapic_ticks;
+    lapic_timer_start(lapic_ticks);
+    __asm__ volatile("sti");
+    
+    idle_loop();
+}
+
+// 新进程放到负载最轻的在线处理器上（可运行进程数相同时优先当前处理器）
+static uint32_t select_task_cpu(void)
+{
+    uint32_t best = smp_processor_id();
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (smp_cpu_online(cpu) && rq_nr_running(&runqueues[cpu]) < rq_nr_running(&runqueues[best])) {
+            best = cpu;
+        }
+    }
+    return best;
+}
+
 // 创建新进程
-task_t* create_task(void (*entry)(void), const char* name, uint32_t priority)
+task_t* create_task_stopped(void (*entry)(void), const char* name, uint32_t priority)
 {
     if (priority >= MAX_PRIORITY) {
         kprintf("[ERROR] Invalid priority: %d\n", priority);
@@ -139,137 +788,179 @@ task_t* create_task(void (*entry)(void), const char* name, uint32_t priority)
     }
     
     // 分配PCB
-    task_t* task = (task_t*)kmalloc(sizeof(task_t));
+    task_t* task = (task_t*)kmem_cache_alloc(task_cache);
     if (!task) {
         kprintf("[ERROR] Failed to allocate task PCB\n");
         return NULL;
     }
     
     memset(task, 0, sizeof(task_t));
-    task->pid = next_pid++;
     task->state = TASK_READY;
     task->priority = priority;
+    task->policy = SCHED_PRIO;
+    task->nice = 0;
+    task->weight = NICE_0_LOAD;
     task->time_slice = TIME_SLICE;
     task->total_runtime = 0;
     task->last_scheduled = 0;
     task->memory_usage_kb = 8;
     strcpy(task->name, name);
     
-    // 复制当前进程的页目录（或创建新的）
-    task->page_dir = (page_directory_t*)kmalloc(sizeof(page_directory_t));
-    if (!task->page_dir) {
-        kfree(task);
-        kprintf("[ERROR] Failed to allocate task page directory\n");
+    // 创建地址空间（内核部分与所有进程共享）
+    task->mm = vm_space_create();
+    if (!task->mm) {
+        kmem_cache_free(task_cache, task);
+        kprintf("[ERROR] Failed to create task address space\n");
         return NULL;
     }
+    task->page_dir = task->mm->page_dir;
     
-    // 复制内核页目录映射
-    memcpy(task->page_dir, get_kernel_page_dir(), sizeof(page_directory_t));
-    
-    // 分配内核栈
-    void* kernel_stack = kmalloc(4096);
+    // 分配内核栈（按页对齐，整个栈位于同一页内）
+    void* kernel_stack = kmalloc_aligned(4096, PAGE_SIZE);
     if (!kernel_stack) {
-        kfree(task->page_dir);
-        kfree(task);
+        vm_space_put(task->mm);
+        kmem_cache_free(task_cache, task);
         kprintf("[ERROR] Failed to allocate task kernel stack\n");
         return NULL;
     }
     
     task->kernel_stack_top = (uint32_t)kernel_stack + 4096;
     
-    // 设置初始上下文
-    task->regs.eip = (uint32_t)entry;
+    // 设置初始上下文：从 task_entry_stub 开始执行，由它调用 ebx 中的入口函数
+    task->regs.eip = (uint32_t)task_entry_stub;
+    task->regs.ebx = (uint32_t)entry;
     task->regs.eflags = 0x202;  // IF=1
-    task->regs.cs = 0x08;       // 内核代码段
-    task->regs.ds = 0x10;       // 内核数据段
-    task->regs.es = 0x10;
-    task->regs.fs = 0x10;
-    task->regs.gs = 0x10;
-    task->regs.ss = 0x10;
+    task->regs.cs = GDT_KERNEL_CODE;
+    task->regs.ds = GDT_KERNEL_DATA;
+    task->regs.es = GDT_KERNEL_DATA;
+    task->regs.fs = GDT_KERNEL_DATA;
+    task->regs.gs = GDT_PERCPU;
+    task->regs.ss = GDT_KERNEL_DATA;
     task->regs.esp = task->kernel_stack_top;
     
     // 设置父进程
     task->parent = current_task;
     
-    // 将任务加入就绪队列
-    task->sibling_next = ready_queue[priority];
-    ready_queue[priority] = task;
+    return task;
+}
+
+// 发布新进程：分配 PID、加入进程链表，最后放入所选处理器的就绪队列
+// 此后其他处理器可能立即运行它，调用者须已完成全部设置
+void sched_wake_up_new(task_t* task)
+{
+    task->cpu = select_task_cpu();
+    
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    task->pid = next_pid++;
+    task->usage = 1;
+    task->task_next = task_list;
+    task_list = task;
+    spin_unlock_irqrestore(&tasklist_lock, flags);
     
-    kprintf("[SCHED] Created task %s (PID: %d, priority: %d)\n", name, task->pid, priority);
+    enqueue_task(task, 0);
     
+    kprintf("[SCHED] Created task %s (PID: %d, priority: %d, cpu: %d)\n", task->name, task->pid, task->priority, task->cpu);
+}
+
+// 创建并立即发布新进程
+task_t* create_task(void (*entry)(void), const char* name, uint32_t priority)
+{
+    task_t* task = create_task_stopped(entry, name, priority);
+    if (task) {
+        sched_wake_up_new(task);
+    }
     return task;
 }
 
-// 进程调度算法
+// 上一个进程的上下文已经保存完，允许回收它（切换后在新进程中调用）
+void finish_task_switch(void)
+{
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    
+    runqueue_t* rq = this_rq();
+    if (rq->prev) {
+        rq->prev->on_cpu = false;
+        rq->prev = NULL;
+    }
+    
+    asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
+// 进程调度算法：只在本处理器的就绪队列中选择
 void schedule(void)
 {
-    if (!current_task) {
+    // 关中断到切换完成，期间不会被时钟中断重入，也不会换到其他处理器
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    
+    runqueue_t* rq = this_rq();
+    task_t* prev = rq->curr;
+    if (!prev) {
+        asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
         return;
     }
     
-    // 更新当前进程的运行时间
-    current_task->total_runtime++;
-    current_task->time_slice--;
+    // 新进程在入口处调用 finish_task_switch 之前可能已被抢占
+    finish_task_switch();
     
-    // 如果时间片用完，将进程放回就绪队列
-    if (current_task->time_slice <= 0) {
-        current_task->state = TASK_READY;
-        current_task->time_slice = TIME_SLICE;
-        
-        // 将当前进程加入就绪队列
-        task_t* task = current_task;
-        task->sibling_next = ready_queue[task->priority];
-        ready_queue[task->priority] = task;
-        
-        current_task = NULL;
-    }
-    
-    // 寻找下一个可运行的进程
-    task_t* next_task = NULL;
-    
-    // 从高优先级到低优先级扫描就绪队列
-    for (int i = MAX_PRIORITY - 1; i >= 0; i--) {
-        if (ready_queue[i]) {
-            // 获取队列中的第一个任务
-            next_task = ready_queue[i];
-            
-            // 更新就绪队列
-            ready_queue[i] = next_task->sibling_next;
-            next_task->sibling_next = NULL;
-            
-            break;
-        }
+    spin_lock(&rq->lock);
+    rq->need_resched = false;
+    
+    // 已被终止的进程不再阻塞，回到等待循环后自行退出
+    // sched_kill 先设置标记再在 rq->lock 下检查状态，这里在同一把锁下检查标记，两边不会都错过
+    if (prev->state == TASK_BLOCKED && prev->killed) {
+        prev->state = TASK_RUNNING;
     }
     
-    // 如果没有找到可运行的进程，使用idle任务
-    if (!next_task) {
-        next_task = create_idle_task();
-        if (!next_task) {
-            kprintf("[ERROR] No tasks available, cannot create idle task\n");
-            return;
+    // 仍可运行的当前进程交还给所属调度类重新入队
+    // 阻塞或退出的进程不再入队，由唤醒者重新放入就绪队列
+    if (!is_idle_task(prev)) {
+        task_sched_class(prev)->put_prev(rq, prev);
+        if (prev->state == TASK_RUNNING) {
+            rq_enqueue(rq, prev, 0);
         }
     }
     
+    // 寻找下一个可运行的进程，没有时运行空闲进程（无需分配任何内存）
+    task_t* next = rq_pick_next(rq);
+    if (!next) {
+        next = rq->idle;
+    }
+    if (is_idle_task(prev) && next != prev) {
+        prev->state = TASK_READY;
+    }
+    
     // 更新任务状态
-    next_task->state = TASK_RUNNING;
-    next_task->last_scheduled = 0;
+    next->state = TASK_RUNNING;
+    next->last_scheduled = 0;
     
-    // 切换到新进程
-    if (current_task != next_task) {
-        task_t* old_task = current_task;
-        current_task = next_task;
-        
-        kprintf("[SCHED] Switching from PID %d to PID %d\n", old_task ? old_task->pid : -1, next_task->pid);
-        
-        // 调用上下文切换函数
-        switch_to(old_task, next_task);
+    if (prev == next) {
+        spin_unlock(&rq->lock);
+        asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+        return;
     }
+    
+    // prev 的上下文在 switch_to 中保存完之前不能被回收，也不能被其他处理器窃取
+    prev->last_ran = rq_clock(rq);
+    next->on_cpu = true;
+    rq->curr = next;
+    rq->prev = prev;
+    rq->context_switches++;
+    spin_unlock(&rq->lock);
+    
+    // 调用上下文切换函数（换回本进程时从这里继续）
+    smp_set_kernel_stack(next->kernel_stack_top);
+    switch_to(prev, next);
+    finish_task_switch();
+    
+    asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
 }
 
-// 获取当前进程
+// 获取当前进程（调用者关中断或当前进程不会迁移）
 task_t* get_current_task(void)
 {
-    return current_task;
+    return this_rq()->curr;
 }
 
 // 退出当前进程
@@ -277,23 +968,371 @@ void task_exit(int status)
 {
     kprintf("[SCHED] Task %d exited with status %d\n", current_task->pid, status);
     
-    // 设置进程状态为僵尸
-    current_task->state = TASK_ZOMBIE;
+    // 释放资源：先换上内核地址空间再释放，通过 find_task 读取 mm 的一方不会看到已释放的地址空间
+    scratch_release(&current_task->scratch);
+    vm_space_t* mm = current_task->mm;
+    current_task->mm = vm_space_kernel();
+    current_task->page_dir = current_task->mm->page_dir;
+    vm_space_put(mm);
     
-    // 释放资源
-    if (current_task->page_dir && current_task->page_dir != get_kernel_page_dir()) {
-        kfree(current_task->page_dir);
+    // 设置进程状态为僵尸并通知父进程；父进程回收前会等待本进程切换走（on_cpu 清零）
+    // 持有 tasklist_lock 读取父进程：父进程可能正在其他处理器上被回收，子进程随之改由 init 收养
+    asm volatile("cli");
+    spin_lock(&tasklist_lock);
+    current_task->exit_code = status;
+    current_task->state = TASK_ZOMBIE;
+    if (current_task->parent) {
+        wake_up_all(&current_task->parent->child_exit);
     }
+    spin_unlock(&tasklist_lock);
     
     // 调度新进程
     schedule();
 }
 
-// 时钟中断处理函数（进程调度入口）
+// 终止进程（init 负责回收孤儿进程，不能被终止）
+bool sched_kill(task_t* task)
+{
+    if (!task || is_idle_task(task) || task == init_task || task->state == TASK_ZOMBIE) {
+        return false;
+    }
+    
+    task->killed = true;
+    sched_wakeup(task);
+    return true;
+}
+
+// 当前进程已被终止时退出
+void sched_exit_if_killed(void)
+{
+    task_t* task = current_task;
+    if (task && task->killed && !is_idle_task(task) && task->state != TASK_ZOMBIE) {
+        task_exit(-1);
+    }
+}
+
+// 查找 parent 的子进程：pid 不大于 0 时匹配任意子进程，zombie 为 true 时只匹配已退出的子进程
+task_t* sched_find_child(task_t* parent, int pid, bool zombie)
+{
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    task_t* found = NULL;
+    for (task_t* task = task_list; task; task = task->task_next) {
+        if (task->parent != parent || (pid > 0 && task->pid != (uint32_t)pid)) {
+            continue;
+        }
+        if (!zombie || task->state == TASK_ZOMBIE) {
+            found = task;
+            break;
+        }
+    }
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+    return found;
+}
+
+// 回收已退出的进程：移出进程链表，释放内核栈和进程控制块
+void sched_reap(task_t* task)
+{
+    // 进程可能刚在其他处理器上进入僵尸状态，等它切换走、不再使用内核栈
+    while (task->on_cpu) {
+        __asm__ volatile("pause");
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    
+    task_t** link = &task_list;
+    while (*link && *link != task) {
+        link = &(*link)->task_next;
+    }
+    if (*link) {
+        *link = task->task_next;
+    }
+    
+    // 子进程改由 init 收养，退出后由 init 回收；已经退出的子进程需要唤醒 init
+    bool orphan_zombie = false;
+    task_t* reaper = task == init_task ? NULL : init_task;
+    for (task_t* child = task_list; child; child = child->task_next) {
+        if (child->parent == task) {
+            child->parent = reaper;
+            orphan_zombie |= child->state == TASK_ZOMBIE;
+        }
+    }
+    
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+    
+    if (reaper && orphan_zombie) {
+        wake_up_all(&reaper->child_exit);
+    }
+    
+    // 释放进程链表持有的引用
+    task_put(task);
+}
+
+// 指数衰减：load = load * e + active * (1 - e)，负载上升时向上取整
+static uint32_t calc_load(uint32_t load, uint32_t exp, uint32_t active)
+{
+    uint32_t new_load = load * exp + active * (FIXED_1 - exp);
+    if (active >= load) {
+        new_load += FIXED_1 - 1;
+    }
+    return new_load / FIXED_1;
+}
+
+// 所有处理器上可运行的进程数（不加锁读取，只用于统计）
+static uint32_t nr_running_total(void)
+{
+    uint32_t total = 0;
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        total += rq_nr_running(&runqueues[cpu]);
+    }
+    return total;
+}
+
+// 更新负载均值：可运行进程数为所有处理器上的就绪进程数加上正在运行的非空闲进程
+static void calc_load_avg(void)
+{
+    uint32_t active = nr_running_total() * FIXED_1;
+    
+    load_avg[0] = calc_load(load_avg[0], EXP_1, active);
+    load_avg[1] = calc_load(load_avg[1], EXP_5, active);
+    load_avg[2] = calc_load(load_avg[2], EXP_15, active);
+}
+
+// 获取调度统计（各处理器的计数之和）
+void sched_get_stats(sched_stats_t* stats)
+{
+    stats->load_avg[0] = load_avg[0];
+    stats->load_avg[1] = load_avg[1];
+    stats->load_avg[2] = load_avg[2];
+    stats->nr_running = nr_running_total();
+    stats->nr_cpus = 0;
+    stats->busy_ticks = 0;
+    stats->idle_ticks = 0;
+    stats->context_switches = 0;
+    stats->nr_migrations = 0;
+    for (uint32_t cpu = 0; cpu < MAX_CPUS; cpu++) {
+        if (!smp_cpu_online(cpu)) {
+            continue;
+        }
+        stats->nr_cpus++;
+        stats->busy_ticks += runqueues[cpu].busy_ticks;
+        stats->idle_ticks += runqueues[cpu].idle_ticks;
+        stats->context_switches += runqueues[cpu].context_switches;
+        stats->nr_migrations += runqueues[cpu].nr_steals;
+    }
+    
+    uint32_t flags = spin_lock_irqsave(&tasklist_lock);
+    stats->nr_tasks = 0;
+    for (task_t* task = task_list; task; task = task->task_next) {
+        if (task->state != TASK_ZOMBIE) {
+            stats->nr_tasks++;
+        }
+    }
+    stats->last_pid = next_pid - 1;
+    spin_unlock_irqrestore(&tasklist_lock, flags);
+    
+    stats->timer_interrupts = timer_interrupts;
+    stats->nohz_ticks = nohz_ticks;
+}
+
+// 获取单个处理器的调度统计，处理器不在线时返回 false
+bool sched_get_cpu_stats(uint32_t cpu, sched_cpu_stats_t* stats)
+{
+    if (!smp_cpu_online(cpu)) {
+        return false;
+    }
+    
+    runqueue_t* rq = &runqueues[cpu];
+    stats->nr_running = rq_nr_running(rq);
+    stats->busy_ticks = rq->busy_ticks;
+    stats->idle_ticks = rq->idle_ticks;
+    stats->context_switches = rq->context_switches;
+    stats->curr_pid = rq->curr ? rq->curr->pid : 0;
+    stats->nr_steals = rq->nr_steals;
+    stats->nr_stolen = rq->nr_stolen;
+    stats->hot_skips = rq->hot_skips;
+    return true;
+}
+
+// 补记 counts 个 PIT 计数的空闲时间：整滴答计入系统时钟和 BSP 的空闲时间，余数留到下次
+static void tick_account_idle(uint32_t counts)
+{
+    nohz_residual += counts;
+    uint32_t ticks = nohz_residual / tick_period;
+    nohz_residual -= ticks * tick_period;
+    
+    system_ticks += ticks;
+    runqueues[0].idle_ticks += ticks;
+    runqueues[0].idle->total_runtime += ticks;
+    nohz_ticks += ticks;
+    
+    // 错过的负载均值更新逐次补算
+    while (ticks >= load_countdown) {
+        ticks -= load_countdown;
+        load_countdown = LOAD_FREQ;
+        calc_load_avg();
+    }
+    load_countdown -= ticks;
+}
+
+// 下一个必须按时处理的事件距现在的时钟滴答数：空闲时没有时间片需要检查，只看时间轮
+static uint32_t tick_next_event(uint32_t limit)
+{
+    return timer_next_event(limit);
+}
+
+// 进入停机前停止周期性滴答（调用者关中断）
+static void tick_nohz_idle_enter(void)
+{
+    // 周期中断已经挂起时保持周期模式，避免把它误当作单次定时到期
+    if (tick_stopped || tick_period == 0 || pit_irq_pending()) {
+        return;
+    }
+    
+    // 单次定时最长为 PIT 计数范围内的整数个滴答
+    uint32_t ticks = tick_next_event(PIT_MAX_COUNT / tick_period);
+    ticks = MIN(ticks, PIT_MAX_COUNT / tick_period);
+    if (ticks <= 1) {
+        return;
+    }
+    
+    // 当前周期已经过去的部分先记入余数，切换模式不丢失时间
+    uint32_t elapsed = tick_period - MIN(pit_read_count(), tick_period);
+    nohz_programmed = ticks * tick_period;
+    pit_set_oneshot(nohz_programmed);
+    tick_stopped = true;
+    tick_account_idle(elapsed);
+}
+
+// 恢复周期性滴答，补记停止期间经过的 counts 个 PIT 计数并处理期间到期的定时器
+static void tick_nohz_restart(uint32_t counts)
+{
+    pit_set_periodic(TIMER_HZ);
+    tick_stopped = false;
+    tick_account_idle(counts);
+    timer_run(system_ticks);
+}
+
+// 停机被中断唤醒后恢复周期性滴答（调用者关中断）
+static void tick_nohz_idle_exit(void)
+{
+    if (!tick_stopped) {
+        return;
+    }
+    
+    // 单次定时已到期但中断尚未处理：该中断在周期模式下按一个普通滴答计入
+    if (pit_irq_pending()) {
+        tick_nohz_restart(nohz_programmed - tick_period);
+    } else {
+        tick_nohz_restart(nohz_programmed - MIN(pit_read_count(), nohz_programmed));
+    }
+}
+
+// 补记 AP 停止滴答期间经过的 counts 个 APIC 定时器计数：系统时钟由 BSP 推进，这里只计入本处理器的空闲时间
+static void lapic_account_idle(runqueue_t* rq, uint32_t counts)
+{
+    rq->lapic_residual += counts;
+    uint32_t ticks = rq->lapic_residual / lapic_period;
+    rq->lapic_residual -= ticks * lapic_period;
+    
+    rq->idle_ticks += ticks;
+    rq->idle->total_runtime += ticks;
+}
+
+// AP 停机前停止本地 APIC 定时器的周期滴答（调用者关中断）
+// AP 不推进时间轮，就绪进程由重新调度 IPI 唤醒；单次定时只按时间轮的下一个事件限制停机时长
+static void lapic_nohz_idle_enter(runqueue_t* rq)
+{
+    if (rq->lapic_stopped || lapic_period == 0 || lapic_irq_pending(LAPIC_TIMER_VECTOR)) {
+        return;
+    }
+    
+    uint32_t limit = 0xFFFFFFFF / lapic_period;
+    uint32_t ticks = MIN(tick_next_event(limit), limit);
+    if (ticks <= 1) {
+        return;
+    }
+    
+    // 当前周期已经过去的部分先记入余数
+    uint32_t elapsed = lapic_period - MIN(lapic_timer_remaining(), lapic_period);
+    rq->lapic_programmed = ticks * lapic_period;
+    lapic_timer_oneshot(rq->lapic_programmed);
+    rq->lapic_stopped = true;
+    lapic_account_idle(rq, elapsed);
+}
+
+// 恢复 AP 的周期滴答，补记停止期间经过的 counts 个计数
+static void lapic_nohz_restart(runqueue_t* rq, uint32_t counts)
+{
+    lapic_timer_start(lapic_period);
+    rq->lapic_stopped = false;
+    lapic_account_idle(rq, counts);
+}
+
+// AP 停机被中断唤醒后恢复周期滴答（调用者关中断）
+static void lapic_nohz_idle_exit(runqueue_t* rq)
+{
+    if (!rq->lapic_stopped) {
+        return;
+    }
+    
+    // 单次定时已到期但中断尚未处理：该中断在周期模式下按一个普通滴答计入
+    if (lapic_irq_pending(LAPIC_TIMER_VECTOR)) {
+        lapic_nohz_restart(rq, rq->lapic_programmed - lapic_period);
+    } else {
+        lapic_nohz_restart(rq, rq->lapic_programmed - MIN(lapic_timer_remaining(), rq->lapic_programmed));
+    }
+}
+
+// 本处理器的时钟滴答：统计运行时间，由当前进程的调度类决定是否抢占（中断处理中调用）
+static void sched_tick(void)
+{
+    runqueue_t* rq = this_rq();
+    task_t* curr = rq->curr;
+    if (!curr) {
+        return;
+    }
+    
+    spin_lock(&rq->lock);
+    curr->total_runtime++;
+    
+    // 空闲进程在有进程就绪时立即让出处理器
+    // 其他进程由所属调度类决定是否抢占，被唤醒的进程需要抢占时也在这里切换
+    bool resched;
+    if (is_idle_task(curr)) {
+        rq->idle_ticks++;
+        resched = rq->nr_ready != 0;
+    } else {
+        rq->busy_ticks++;
+        resched = task_sched_class(curr)->tick(rq, curr) || rq->need_resched;
+    }
+    
+    spin_unlock(&rq->lock);
+    
+    if (resched) {
+        schedule();
+    }
+    
+    // 被终止的计算型进程不会进入等待或系统调用，在时钟滴答中退出（EOI 已经发送）
+    sched_exit_if_killed();
+}
+
+// 时钟中断处理函数（BSP 的 PIT 中断，进程调度入口）
 void timer_interrupt_handler(registers_t* regs)
 {
-    // 递增系统时钟计数
+    timer_interrupts++;
+    
+    // 空闲时设定的单次定时到期：补记整段停机时间，恢复周期性滴答
+    if (tick_stopped) {
+        tick_nohz_restart(nohz_programmed);
+        if (this_rq()->nr_ready) {
+            schedule();
+        }
+        return;
+    }
+    
+    // 递增系统时钟计数，唤醒到期的睡眠进程
     system_ticks++;
+    timer_run(system_ticks);
     
     // 保存当前进程的上下文
     if (current_task && current_task->state == TASK_RUNNING) {
@@ -310,6 +1349,38 @@ void timer_interrupt_handler(registers_t* regs)
         current_task->regs.eflags = regs->eflags;
     }
     
-    // 执行进程调度
-    schedule();
+    // 每 5 秒更新一次负载均值
+    if (--load_countdown == 0) {
+        load_countdown = LOAD_FREQ;
+        calc_load_avg();
+    }
+    
+    sched_tick();
+}
+
+// AP 的本地 APIC 定时器中断：系统时钟和定时器只由 BSP 推进，这里只做本处理器的调度
+void sched_lapic_tick(void)
+{
+    lapic_eoi();
+    
+    // 空闲时设定的单次定时到期：补记整段停机时间，恢复周期性滴答
+    runqueue_t* rq = this_rq();
+    if (rq->lapic_stopped) {
+        lapic_nohz_restart(rq, rq->lapic_programmed);
+        if (rq->nr_ready) {
+            schedule();
+        }
+        return;
+    }
+    
+    sched_tick();
+}
+
+// 重新调度 IPI：其他处理器向本处理器的就绪队列放入了需要抢占当前进程的进程
+void sched_resched_ipi(void)
+{
+    lapic_eoi();
+    if (this_rq()->need_resched) {
+        schedule();
+    }
 }
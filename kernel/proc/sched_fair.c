@@ -0,0 +1,247 @@
+#include <proc/sched.h>
+#include <rbtree.h>
+#include <common.h>
+
+// 公平调度类：按权重分享处理器时间
+// 进程运行时 vruntime 按 实际运行时间 * NICE_0_LOAD / 权重 增长，总是选择 vruntime 最小的进程
+// 权重越大 vruntime 增长越慢，在同样的时间内得到更多的处理器时间
+
+// nice 值到权重的映射（与 Linux 相同）：nice 每差 1，处理器时间之比约为 1.25
+static const uint32_t nice_weights[NICE_MAX - NICE_MIN + 1] = {
+    88761, 71755, 56483, 46273, 36291,     // -20 ~ -16
+    29154, 23254, 18705, 14949, 11916,     // -15 ~ -11
+    9548, 7620, 6100, 4904, 3906,          // -10 ~ -6
+    3121, 2501, 1991, 1586, 1277,          // -5 ~ -1
+    1024, 820, 655, 526, 423,              // 0 ~ 4
+    335, 272, 215, 172, 137,               // 5 ~ 9
+    110, 87, 70, 56, 45,                   // 10 ~ 14
+    36, 29, 23, 18, 15                     // 15 ~ 19
+};
+
+// 调度周期内最多容纳的进程数，超过后周期按最小粒度拉长
+#define SCHED_NR_LATENCY (SCHED_LATENCY_US / SCHED_MIN_GRANULARITY_US)
+
+// nice 值对应的权重
+uint32_t sched_nice_to_weight(int nice)
+{
+    if (nice < NICE_MIN) {
+        nice = NICE_MIN;
+    } else if (nice > NICE_MAX) {
+        nice = NICE_MAX;
+    }
+    return nice_weights[nice - NICE_MIN];
+}
+
+// vruntime 允许回绕，按差值的符号比较
+static inline bool vruntime_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+// 实际时间换算为进程的虚拟时间
+static inline uint32_t calc_delta_fair(uint32_t delta, const task_t* task)
+{
+    if (task->weight == NICE_0_LOAD) {
+        return delta;
+    }
+    return delta * NICE_0_LOAD / task->weight;
+}
+
+// 更新 min_vruntime：取正在运行的进程和最左进程中较小的 vruntime，且只增不减
+static void update_min_vruntime(fair_rq_t* fair)
+{
+    if (!fair->curr && !fair->leftmost) {
+        return;
+    }
+
+    uint32_t vruntime = fair->curr ? fair->curr->vruntime : fair->leftmost->vruntime;
+    if (fair->leftmost && vruntime_before(fair->leftmost->vruntime, vruntime)) {
+        vruntime = fair->leftmost->vruntime;
+    }
+    if (vruntime_before(fair->min_vruntime, vruntime)) {
+        fair->min_vruntime = vruntime;
+    }
+}
+
+// 调度周期内分给进程的时间：周期按权重占比分配，至少为最小粒度
+static uint32_t sched_slice(const fair_rq_t* fair, const task_t* curr)
+{
+    uint32_t nr = fair->nr_ready + 1;
+    uint32_t period = SCHED_LATENCY_US;
+    if (nr > SCHED_NR_LATENCY) {
+        period = nr * SCHED_MIN_GRANULARITY_US;
+    }
+
+    // 按毫秒计算，避免周期与权重相乘溢出 32 位
+    uint32_t load = fair->load + curr->weight;
+    uint32_t slice = period / 1000 * curr->weight / load * 1000;
+    return MAX(slice, (uint32_t)SCHED_MIN_GRANULARITY_US);
+}
+
+// 按 vruntime 插入红黑树，相同时排在已有进程之后
+static void fair_tree_insert(fair_rq_t* fair, task_t* task)
+{
+    rb_node_t** link = &fair->tasks.node;
+    rb_node_t* parent = NULL;
+    bool leftmost = true;
+
+    while (*link) {
+        parent = *link;
+        task_t* entry = rb_entry(parent, task_t, rb_node);
+        if (vruntime_before(task->vruntime, entry->vruntime)) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            leftmost = false;
+        }
+    }
+
+    rb_link_node(&task->rb_node, parent, link);
+    rb_insert_color(&task->rb_node, &fair->tasks);
+    if (leftmost) {
+        fair->leftmost = task;
+    }
+}
+
+// 从红黑树中删除，删除的是最左进程时缓存其后继
+static void fair_tree_remove(fair_rq_t* fair, task_t* task)
+{
+    if (fair->leftmost == task) {
+        rb_node_t* next = rb_next(&task->rb_node);
+        fair->leftmost = next ? rb_entry(next, task_t, rb_node) : NULL;
+    }
+    rb_erase(&task->rb_node, &fair->tasks);
+}
+
+// 加入就绪队列
+static void fair_enqueue(runqueue_t* rq, task_t* task, int flags)
+{
+    fair_rq_t* fair = &rq->fair;
+
+    // 被唤醒的进程最多获得半个调度周期的补偿，长时间睡眠后不会独占处理器
+    if (flags & ENQUEUE_WAKEUP) {
+        uint32_t floor = fair->min_vruntime - SCHED_LATENCY_US / 2;
+        if (vruntime_before(task->vruntime, floor)) {
+            task->vruntime = floor;
+        }
+    }
+
+    fair_tree_insert(fair, task);
+    fair->load += task->weight;
+    fair->nr_ready++;
+}
+
+// 移出就绪队列
+static void fair_dequeue(runqueue_t* rq, task_t* task)
+{
+    fair_rq_t* fair = &rq->fair;
+
+    fair_tree_remove(fair, task);
+    fair->load -= task->weight;
+    fair->nr_ready--;
+    update_min_vruntime(fair);
+}
+
+// 取出 vruntime 最小的进程
+static task_t* fair_pick_next(runqueue_t* rq)
+{
+    fair_rq_t* fair = &rq->fair;
+    task_t* task = fair->leftmost;
+    if (!task) {
+        return NULL;
+    }
+
+    fair_dequeue(rq, task);
+    fair->curr = task;
+    task->slice_start = task->total_runtime;
+    return task;
+}
+
+// 当前进程被换下
+static void fair_put_prev(runqueue_t* rq, task_t* task)
+{
+    fair_rq_t* fair = &rq->fair;
+    if (fair->curr == task) {
+        update_min_vruntime(fair);
+        fair->curr = NULL;
+    }
+}
+
+// 正在运行的进程切换到公平调度类
+static void fair_set_curr(runqueue_t* rq, task_t* task)
+{
+    rq->fair.curr = task;
+    task->slice_start = task->total_runtime;
+}
+
+// 时钟滴答：累加 vruntime，运行满应得的时间片，或 vruntime 超出最左进程一个时间片以上时让出处理器
+static bool fair_tick(runqueue_t* rq, task_t* curr)
+{
+    fair_rq_t* fair = &rq->fair;
+
+    curr->vruntime += calc_delta_fair(SCHED_TICK_US, curr);
+    update_min_vruntime(fair);
+
+    if (!fair->leftmost) {
+        return false;
+    }
+
+    uint32_t ran = (curr->total_runtime - curr->slice_start) * SCHED_TICK_US;
+    uint32_t ideal = sched_slice(fair, curr);
+    if (ran >= ideal) {
+        return true;
+    }
+
+    // 至少运行最小粒度，避免频繁切换
+    if (ran < SCHED_MIN_GRANULARITY_US) {
+        return false;
+    }
+    return (int32_t)(curr->vruntime - fair->leftmost->vruntime) > (int32_t)ideal;
+}
+
+// 唤醒抢占：被唤醒进程的 vruntime 比当前进程小出唤醒粒度（按其权重换算）以上时抢占
+static bool fair_check_preempt(runqueue_t* rq, task_t* curr, task_t* woken)
+{
+    UNUSED(rq);
+
+    int32_t delta = curr->vruntime - woken->vruntime;
+    return delta > (int32_t)calc_delta_fair(SCHED_WAKEUP_GRANULARITY_US, woken);
+}
+
+// 切换到公平调度类的进程从 min_vruntime 开始，不继承旧值
+static void fair_switched_to(runqueue_t* rq, task_t* task)
+{
+    task->vruntime = rq->fair.min_vruntime;
+}
+
+// 从 vruntime 最大（在本队列中最晚才会运行）的进程开始寻找可迁移的进程
+static task_t* fair_steal(runqueue_t* rq, sched_steal_filter_t filter, void* arg)
+{
+    for (rb_node_t* node = rb_last(&rq->fair.tasks); node; node = rb_prev(node)) {
+        task_t* task = rb_entry(node, task_t, rb_node);
+        if (filter(task, arg)) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// vruntime 只在同一队列内可比：保留相对源队列 min_vruntime 的差值
+static void fair_migrate(runqueue_t* src, runqueue_t* dst, task_t* task)
+{
+    task->vruntime = task->vruntime - src->fair.min_vruntime + dst->fair.min_vruntime;
+}
+
+const sched_class_t fair_sched_class = {
+    .name = "fair",
+    .enqueue = fair_enqueue,
+    .dequeue = fair_dequeue,
+    .pick_next = fair_pick_next,
+    .put_prev = fair_put_prev,
+    .tick = fair_tick,
+    .check_preempt = fair_check_preempt,
+    .switched_to = fair_switched_to,
+    .steal = fair_steal,
+    .migrate = fair_migrate,
+    .set_curr = fair_set_curr,
+};
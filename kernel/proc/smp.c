@@ -0,0 +1,479 @@
+#include <proc/smp.h>
+#include <proc/task.h>
+#include <proc/sched.h>
+#include <apic.h>
+#include <pit.h>
+#include <interrupts.h>
+#include <mm/paging.h>
+#include <string.h>
+#include <mem.h>
+#include <common.h>
+#include <spinlock.h>
+#include <vga.h>
+
+// AP 启动代码（trampoline.asm）
+extern uint8_t ap_trampoline_start[];
+extern uint8_t ap_trampoline_end[];
+extern uint8_t ap_trampoline_args[];
+
+// 启动代码的参数区（布局与 trampoline.asm 一致）
+typedef struct {
+    uint32_t cr3;
+    uint32_t cr4;
+    uint32_t stack;
+    uint32_t entry;
+    uint32_t arg;
+} ap_args_t;
+
+// 等待 AP 上线的 PIT 周期数（约 1 秒）
+#define AP_BOOT_TIMEOUT TIMER_HZ
+
+// ACPI 根系统描述指针
+typedef struct {
+    char signature[8];            // "RSD PTR "
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed)) acpi_rsdp_t;
+
+// ACPI 表头
+typedef struct {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed)) acpi_header_t;
+
+// MADT（"APIC"）：表头之后是本地 APIC 地址和变长的中断控制器条目
+typedef struct {
+    acpi_header_t header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} __attribute__((packed)) acpi_madt_t;
+
+#define MADT_LAPIC 0                  // 处理器本地 APIC 条目
+#define MADT_LAPIC_ENABLED 0x1       // 未置位的条目是可热插拔但尚不存在的处理器
+
+// MP 浮动指针结构
+typedef struct {
+    char signature[4];            // "_MP_"
+    uint32_t config_table;
+    uint8_t length;               // 以 16 字节为单位
+    uint8_t spec_rev;
+    uint8_t checksum;
+    uint8_t features[5];
+} __attribute__((packed)) mp_floating_t;
+
+// MP 配置表头，之后是 entry_count 个条目（处理器条目 20 字节，其余 8 字节）
+typedef struct {
+    char signature[4];            // "PCMP"
+    uint16_t base_length;
+    uint8_t spec_rev;
+    uint8_t checksum;
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_count;
+    uint32_t lapic_address;
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+} __attribute__((packed)) mp_config_t;
+
+#define MP_ENTRY_PROCESSOR 0
+#define MP_PROCESSOR_ENABLED 0x1
+
+static cpu_t cpus[MAX_CPUS];
+static uint32_t cpu_count = 1;            // 已上线的处理器数
+static uint32_t apic_ids[MAX_CPUS];       // 枚举到的处理器的 APIC ID
+static uint32_t apic_count = 0;
+static uint32_t lapic_base = 0;
+static uint32_t lapic_ticks = 0;          // 一个时钟滴答的 APIC 定时器计数
+static bool smp_active = false;           // 已开启本地 APIC，可以发送 IPI
+
+// TLB 击落请求（由 tlb_lock 串行化，tlb_pending 为尚未确认的处理器数）
+static spinlock_t tlb_lock = SPINLOCK_INIT;
+static volatile uint32_t tlb_start = 0;
+static volatile uint32_t tlb_end = 0;
+static volatile uint32_t tlb_pending = 0;
+static volatile bool tlb_request[MAX_CPUS];
+
+// 段描述符
+static uint64_t gdt_entry(uint32_t base, uint32_t limit, uint8_t access, uint8_t flags)
+{
+    uint64_t entry = limit & 0xFFFF;
+    entry |= (uint64_t)(base & 0xFFFFFF) << 16;
+    entry |= (uint64_t)access << 40;
+    entry |= (uint64_t)((limit >> 16) & 0xF) << 48;
+    entry |= (uint64_t)(flags & 0xF) << 52;
+    entry |= (uint64_t)(base >> 24) << 56;
+    return entry;
+}
+
+// 初始化处理器的 GDT 和 TSS
+static void cpu_setup(cpu_t* cpu, uint32_t id, uint32_t apic_id)
+{
+    memset(cpu, 0, sizeof(cpu_t));
+    cpu->self = cpu;
+    cpu->id = id;
+    cpu->apic_id = apic_id;
+
+    cpu->gdt[0] = 0;
+    cpu->gdt[GDT_KERNEL_CODE / 8] = gdt_entry(0, 0xFFFFF, 0x9A, 0xC);
+    cpu->gdt[GDT_KERNEL_DATA / 8] = gdt_entry(0, 0xFFFFF, 0x92, 0xC);
+    cpu->gdt[GDT_PERCPU / 8] = gdt_entry((uint32_t)cpu, sizeof(cpu_t) - 1, 0x92, 0x4);
+    cpu->gdt[GDT_TSS / 8] = gdt_entry((uint32_t)&cpu->tss, sizeof(tss_t) - 1, 0x89, 0x0);
+
+    cpu->tss.ss0 = GDT_KERNEL_DATA;
+    cpu->tss.iomap_base = sizeof(tss_t);
+}
+
+// 在本处理器上装入 GDT、重新装入段寄存器并装入 TSS
+static void cpu_load(cpu_t* cpu)
+{
+    struct {
+        uint16_t limit;
+        uint32_t base;
+    } __attribute__((packed)) gdt_ptr = { sizeof(cpu->gdt) - 1, (uint32_t)cpu->gdt };
+
+    asm volatile("lgdt %0" : : "m" (gdt_ptr));
+    asm volatile("ljmp %0, $1f\n1:" : : "i" (GDT_KERNEL_CODE));
+    asm volatile("mov %0, %%ds; mov %0, %%es; mov %0, %%fs; mov %0, %%ss" : : "r" (GDT_KERNEL_DATA));
+    asm volatile("mov %0, %%gs" : : "r" (GDT_PERCPU));
+    asm volatile("ltr %w0" : : "r" (GDT_TSS));
+}
+
+void smp_early_init(void)
+{
+    cpu_setup(&cpus[0], 0, 0);
+    cpus[0].online = true;
+    cpu_load(&cpus[0]);
+}
+
+// 物理地址范围位于直接映射内（ACPI 表可能位于内存顶端）
+static bool phys_mapped(uint32_t addr, uint32_t len)
+{
+    return addr + len > addr && addr + len <= KERNEL_DIRECT_MAP_END;
+}
+
+static bool checksum_ok(const void* data, uint32_t len)
+{
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        sum += ((const uint8_t*)data)[i];
+    }
+    return sum == 0;
+}
+
+// 在 [start, start + len) 中按 16 字节边界查找带校验和的签名
+static const void* scan_signature(uint32_t start, uint32_t len, const char* sig, uint32_t check_len)
+{
+    uint32_t sig_len = strlen(sig);
+    for (uint32_t addr = start; addr + check_len <= start + len; addr += 16) {
+        if (memcmp((const void*)addr, sig, sig_len) == 0 && checksum_ok((const void*)addr, check_len)) {
+            return (const void*)addr;
+        }
+    }
+    return NULL;
+}
+
+// 低端物理内存位于内核恒等映射中，物理地址可以直接访问
+// 地址经过空的 asm 传递，编译器不再把 0x40E 这类小常量当作空指针偏移（-Warray-bounds）
+static inline const volatile void* phys_to_virt(uint32_t phys)
+{
+    asm("" : "+r" (phys));
+    return (const volatile void*)phys;
+}
+
+// 扩展 BIOS 数据区的物理地址（BDA 0x40E 处的段地址）
+static uint32_t ebda_base(void)
+{
+    return (uint32_t)(*(const volatile uint16_t*)phys_to_virt(0x40E)) << 4;
+}
+
+static void add_apic_id(uint32_t apic_id)
+{
+    for (uint32_t i = 0; i < apic_count; i++) {
+        if (apic_ids[i] == apic_id) {
+            return;
+        }
+    }
+    if (apic_count < MAX_CPUS) {
+        apic_ids[apic_count++] = apic_id;
+    }
+}
+
+// 从 ACPI MADT 枚举处理器
+static bool acpi_find_cpus(void)
+{
+    const acpi_rsdp_t* rsdp = NULL;
+    uint32_t ebda = ebda_base();
+    if (ebda) {
+        rsdp = scan_signature(ebda, 1024, "RSD PTR ", sizeof(acpi_rsdp_t));
+    }
+    if (!rsdp) {
+        rsdp = scan_signature(0xE0000, 0x20000, "RSD PTR ", sizeof(acpi_rsdp_t));
+    }
+    if (!rsdp || !phys_mapped(rsdp->rsdt_address, sizeof(acpi_header_t))) {
+        return false;
+    }
+
+    const acpi_header_t* rsdt = (const acpi_header_t*)rsdp->rsdt_address;
+    if (memcmp(rsdt->signature, "RSDT", 4) != 0 || !phys_mapped((uint32_t)rsdt, rsdt->length) ||
+        !checksum_ok(rsdt, rsdt->length)) {
+        return false;
+    }
+
+    const uint32_t* tables = (const uint32_t*)(rsdt + 1);
+    uint32_t table_count = (rsdt->length - sizeof(acpi_header_t)) / 4;
+    for (uint32_t i = 0; i < table_count; i++) {
+        const acpi_header_t* table = (const acpi_header_t*)tables[i];
+        if (!phys_mapped((uint32_t)table, sizeof(acpi_header_t)) || memcmp(table->signature, "APIC", 4) != 0) {
+            continue;
+        }
+        if (!phys_mapped((uint32_t)table, table->length) || !checksum_ok(table, table->length)) {
+            return false;
+        }
+
+        const acpi_madt_t* madt = (const acpi_madt_t*)table;
+        lapic_base = madt->lapic_address;
+
+        const uint8_t* entry = (const uint8_t*)(madt + 1);
+        const uint8_t* end = (const uint8_t*)madt + madt->header.length;
+        while (entry + 2 <= end && entry[1] >= 2) {
+            if (entry[0] == MADT_LAPIC && entry[1] >= 8) {
+                uint32_t flags = *(const uint32_t*)(entry + 4);
+                if (flags & MADT_LAPIC_ENABLED) {
+                    add_apic_id(entry[3]);
+                }
+            }
+            entry += entry[1];
+        }
+        return apic_count > 0;
+    }
+    return false;
+}
+
+// 从 MP 配置表枚举处理器（没有 ACPI 或 ACPI 表不在直接映射内时使用）
+static bool mp_find_cpus(void)
+{
+    const mp_floating_t* mpf = NULL;
+    uint32_t ebda = ebda_base();
+    if (ebda) {
+        mpf = scan_signature(ebda, 1024, "_MP_", sizeof(mp_floating_t));
+    }
+    if (!mpf) {
+        mpf = scan_signature(0x9FC00, 1024, "_MP_", sizeof(mp_floating_t));
+    }
+    if (!mpf) {
+        mpf = scan_signature(0xF0000, 0x10000, "_MP_", sizeof(mp_floating_t));
+    }
+    if (!mpf || mpf->config_table == 0 || !phys_mapped(mpf->config_table, sizeof(mp_config_t))) {
+        return false;
+    }
+
+    const mp_config_t* config = (const mp_config_t*)mpf->config_table;
+    if (memcmp(config->signature, "PCMP", 4) != 0 || !phys_mapped((uint32_t)config, config->base_length) ||
+        !checksum_ok(config, config->base_length)) {
+        return false;
+    }
+    lapic_base = config->lapic_address;
+
+    const uint8_t* entry = (const uint8_t*)(config + 1);
+    const uint8_t* end = (const uint8_t*)config + config->base_length;
+    for (uint32_t i = 0; i < config->entry_count && entry < end; i++) {
+        if (entry[0] == MP_ENTRY_PROCESSOR) {
+            if (entry[3] & MP_PROCESSOR_ENABLED) {
+                add_apic_id(entry[1]);
+            }
+            entry += 20;
+        } else {
+            entry += 8;
+        }
+    }
+    return apic_count > 0;
+}
+
+// AP 的 C 入口（运行在本处理器空闲进程的栈上），不返回
+static void ap_entry(cpu_t* cpu)
+{
+    cpu_load(cpu);
+    idt_load();
+    lapic_enable(false);
+    sched_ap_start(lapic_ticks);
+}
+
+static inline uint32_t read_cr4(void)
+{
+    uint32_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
+    return cr4;
+}
+
+// 启动一个 AP：INIT，10ms 后发送 STARTUP（未响应时再发一次），然后等待它进入调度器
+static bool smp_boot_ap(uint32_t id, uint32_t apic_id, ap_args_t* args)
+{
+    cpu_t* cpu = &cpus[id];
+    cpu_setup(cpu, id, apic_id);
+
+    args->cr3 = (uint32_t)get_kernel_page_dir();
+    args->cr4 = read_cr4();
+    args->stack = sched_idle_stack_top(id);
+    args->entry = (uint32_t)ap_entry;
+    args->arg = (uint32_t)cpu;
+
+    lapic_send_init(apic_id);
+    pit_wait_periods(1);
+    for (int i = 0; i < 2 && !cpu->online; i++) {
+        lapic_send_startup(apic_id, TRAMPOLINE_BASE >> 12);
+        pit_wait_periods(1);
+    }
+    for (uint32_t t = 0; t < AP_BOOT_TIMEOUT && !cpu->online; t++) {
+        pit_wait_periods(1);
+    }
+
+    // 超时的处理器重新置于等待 SIPI 的状态，它的编号留给下一个处理器
+    if (!cpu->online) {
+        lapic_send_init(apic_id);
+        return false;
+    }
+    return true;
+}
+
+void smp_init(void)
+{
+    if (!acpi_find_cpus() && !mp_find_cpus()) {
+        kprintf("[SMP] No ACPI MADT or MP table found, using the boot processor only\n");
+        return;
+    }
+    if (!lapic_map(lapic_base ? lapic_base : LAPIC_DEFAULT_BASE)) {
+        kprintf("[SMP] Invalid local APIC address 0x%x\n", lapic_base);
+        return;
+    }
+    lapic_enable(true);
+    cpus[0].apic_id = lapic_id();
+    smp_active = true;
+
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    lapic_ticks = lapic_timer_calibrate();
+    asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+
+    kprintf("[SMP] %d processor(s), BSP APIC ID %d, APIC timer %d counts/tick\n",
+            apic_count, cpus[0].apic_id, lapic_ticks);
+
+    memcpy((void*)TRAMPOLINE_BASE, ap_trampoline_start, ap_trampoline_end - ap_trampoline_start);
+    ap_args_t* args = (ap_args_t*)(TRAMPOLINE_BASE + (ap_trampoline_args - ap_trampoline_start));
+
+    // 逐个启动（共用一份参数区）
+    for (uint32_t i = 0; i < apic_count && cpu_count < MAX_CPUS; i++) {
+        if (apic_ids[i] == cpus[0].apic_id) {
+            continue;
+        }
+        if (smp_boot_ap(cpu_count, apic_ids[i], args)) {
+            kprintf("[SMP] CPU %d (APIC ID %d) online\n", cpu_count, apic_ids[i]);
+            cpu_count++;
+        } else {
+            kprintf("[SMP] CPU with APIC ID %d did not respond\n", apic_ids[i]);
+        }
+    }
+
+    kprintf("[SMP] %d of %d processor(s) online\n", cpu_count, apic_count);
+}
+
+uint32_t smp_num_cpus(void)
+{
+    return cpu_count;
+}
+
+bool smp_cpu_online(uint32_t id)
+{
+    return id < MAX_CPUS && cpus[id].online;
+}
+
+cpu_t* smp_cpu(uint32_t id)
+{
+    return id < MAX_CPUS ? &cpus[id] : NULL;
+}
+
+void smp_set_kernel_stack(uint32_t esp0)
+{
+    this_cpu()->tss.esp0 = esp0;
+}
+
+void smp_send_resched(uint32_t id)
+{
+    if (smp_active && id != smp_processor_id() && smp_cpu_online(id)) {
+        lapic_send_ipi(cpus[id].apic_id, RESCHED_VECTOR);
+    }
+}
+
+// 处理发给本处理器的刷新请求（关中断调用）
+void smp_tlb_shootdown_poll(void)
+{
+    uint32_t id = smp_processor_id();
+    if (!tlb_request[id]) {
+        return;
+    }
+    
+    tlb_flush_kernel_range(tlb_start, tlb_end);
+    tlb_request[id] = false;
+    asm volatile("lock; decl %0" : "+m" (tlb_pending) : : "memory");
+}
+
+void smp_tlb_shootdown(uint32_t start, uint32_t end)
+{
+    if (!smp_active || cpu_count <= 1 || start >= end) {
+        return;
+    }
+    
+    // 中断已开启说明调用者没有持有 irqsave 锁，其他处理器不会因等待这些锁而无法响应 IPI
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    ASSERT(flags & EFLAGS_IF);
+    
+    // 同一时间只有一个发起者；等待期间处理发给本处理器的请求，两个处理器同时发起时不会互相等待
+    while (!spin_trylock(&tlb_lock)) {
+        smp_tlb_shootdown_poll();
+        asm volatile("pause");
+    }
+    
+    uint32_t self = smp_processor_id();
+    uint32_t targets = 0;
+    for (uint32_t id = 0; id < MAX_CPUS; id++) {
+        if (id != self && smp_cpu_online(id)) {
+            targets++;
+        }
+    }
+    
+    // 先写好范围和计数再发出请求：目标处理器可能在收到 IPI 之前就从等待循环中处理请求
+    tlb_start = start;
+    tlb_end = end;
+    tlb_pending = targets;
+    for (uint32_t id = 0; id < MAX_CPUS; id++) {
+        if (id != self && smp_cpu_online(id)) {
+            tlb_request[id] = true;
+            lapic_send_ipi(cpus[id].apic_id, TLB_SHOOTDOWN_VECTOR);
+        }
+    }
+    
+    while (tlb_pending != 0) {
+        asm volatile("pause");
+    }
+    
+    spin_unlock_irqrestore(&tlb_lock, flags);
+}
+
+// TLB 击落 IPI
+void smp_tlb_shootdown_ipi(void)
+{
+    lapic_eoi();
+    smp_tlb_shootdown_poll();
+}
@@ -6,8 +6,41 @@
 ; 全局函数声明
 global switch_to
 global timer_handler_wrapper
+global keyboard_handler_wrapper
+global serial_handler_wrapper
+global lapic_timer_wrapper
+global resched_ipi_wrapper
+global tlb_shootdown_wrapper
+global spurious_wrapper
+global task_entry_stub
 
 extern timer_interrupt_handler
+extern keyboard_handler
+extern serial_handler
+extern sched_lapic_tick
+extern sched_resched_ipi
+extern smp_tlb_shootdown_ipi
+extern finish_task_switch
+extern task_exit
+
+; task_t 字段偏移（须与 proc/task.h 保持一致）
+%define TASK_PAGE_DIR   12
+%define REGS_EDI        32
+%define REGS_ESI        36
+%define REGS_EBP        40
+%define REGS_ESP        44
+%define REGS_EBX        48
+%define REGS_EDX        52
+%define REGS_ECX        56
+%define REGS_EAX        60
+%define REGS_EIP        64
+%define REGS_EFLAGS     68
+%define REGS_CS         72
+%define REGS_DS         76
+%define REGS_ES         80
+%define REGS_FS         84
+%define REGS_GS         88
+%define REGS_SS         92
 
 ; 上下文切换函数
 switch_to:
@@ -17,80 +50,138 @@ switch_to:
     jz .no_save               ; 如果为 NULL，跳过保存
     
     ; 保存通用寄存器到 old_task->regs 结构体
-    mov [eax + 28], edi       ; regs.edi = edi
-    mov [eax + 32], esi       ; regs.esi = esi
-    mov [eax + 36], ebp       ; regs.ebp = ebp
-    mov [eax + 40], esp       ; regs.esp = esp
-    mov [eax + 44], ebx       ; regs.ebx = ebx
-    mov [eax + 48], edx       ; regs.edx = edx
-    mov [eax + 52], ecx       ; regs.ecx = ecx
-    mov [eax + 56], eax       ; regs.eax = eax
+    mov [eax + REGS_EDI], edi ; regs.edi = edi
+    mov [eax + REGS_ESI], esi ; regs.esi = esi
+    mov [eax + REGS_EBP], ebp ; regs.ebp = ebp
+    mov [eax + REGS_EBX], ebx ; regs.ebx = ebx
+    mov [eax + REGS_EDX], edx ; regs.edx = edx
+    mov [eax + REGS_ECX], ecx ; regs.ecx = ecx
+    mov [eax + REGS_EAX], eax ; regs.eax = eax
+    lea ecx, [esp + 4]        ; 恢复时返回地址已弹出
+    mov [eax + REGS_ESP], ecx ; regs.esp = 调用者栈顶
     
     ; 保存EIP（返回地址）
     mov ecx, [esp]            ; 获取返回地址
-    mov [eax + 60], ecx       ; regs.eip = 返回地址
+    mov [eax + REGS_EIP], ecx ; regs.eip = 返回地址
     
     ; 保存EFLAGS
     pushfd                    ; 将EFLAGS压栈
     pop ecx                   ; 弹出到ecx
-    mov [eax + 64], ecx       ; regs.eflags = ecx
+    mov [eax + REGS_EFLAGS], ecx ; regs.eflags = ecx
     
     ; 保存段寄存器
-    mov [eax + 68], cs        ; regs.cs = cs
-    mov [eax + 72], ds        ; regs.ds = ds
-    mov [eax + 76], es        ; regs.es = es
-    mov [eax + 80], fs        ; regs.fs = fs
-    mov [eax + 84], gs        ; regs.gs = gs
-    mov [eax + 88], ss        ; regs.ss = ss
+    mov [eax + REGS_CS], cs   ; regs.cs = cs
+    mov [eax + REGS_DS], ds   ; regs.ds = ds
+    mov [eax + REGS_ES], es   ; regs.es = es
+    mov [eax + REGS_FS], fs   ; regs.fs = fs
+    mov [eax + REGS_GS], gs   ; regs.gs = gs
+    mov [eax + REGS_SS], ss   ; regs.ss = ss
 
 .no_save:
     ; 恢复新进程上下文从 new_task->regs
     mov eax, [esp + 8]        ; 获取 new_task 指针
     
     ; 切换页目录（关键！实现进程隔离）
-    mov ecx, [eax + 24]       ; 获取 new_task->page_dir
+    ; 内核映射是全局页，重载 CR3 只会刷新用户空间的 TLB 项；
+    ; 新旧进程共享页目录时（如内核线程之间）完全跳过重载
+    mov ecx, [eax + TASK_PAGE_DIR] ; 获取 new_task->page_dir
+    mov edx, cr3
+    cmp ecx, edx
+    je .same_address_space
     mov cr3, ecx              ; 设置CR3寄存器，切换页目录
-    
-    ; 恢复通用寄存器
-    mov edi, [eax + 28]       ; edi = regs.edi
-    mov esi, [eax + 32]       ; esi = regs.esi
-    mov ebp, [eax + 36]       ; ebp = regs.ebp
-    mov ebx, [eax + 44]       ; ebx = regs.ebx
-    mov edx, [eax + 48]       ; edx = regs.edx
-    mov ecx, [eax + 52]       ; ecx = regs.ecx
-    mov eax, [eax + 56]       ; eax = regs.eax
-    
+
+.same_address_space:
     ; 恢复段寄存器（除CS，由iret恢复）
-    mov ds, [eax + 72]        ; ds = regs.ds
-    mov es, [eax + 76]        ; es = regs.es
-    mov fs, [eax + 80]        ; fs = regs.fs
-    mov gs, [eax + 84]        ; gs = regs.gs
-    mov ss, [eax + 88]        ; ss = regs.ss
+    mov ds, [eax + REGS_DS]   ; ds = regs.ds
+    mov es, [eax + REGS_ES]   ; es = regs.es
+    mov fs, [eax + REGS_FS]   ; fs = regs.fs
+    mov gs, [eax + REGS_GS]   ; gs = regs.gs
+    mov ss, [eax + REGS_SS]   ; ss = regs.ss
+    mov esp, [eax + REGS_ESP] ; 切换到新进程的栈
+    
+    ; 构造同特权级的iret帧
+    push dword [eax + REGS_EFLAGS] ; 压入eflags
+    push dword [eax + REGS_CS]     ; 压入cs
+    push dword [eax + REGS_EIP]    ; 压入eip
     
-    ; 恢复EFLAGS和EIP（通过iret指令）
-    push dword [eax + 88]     ; 压入ss
-    push dword [eax + 40]     ; 压入esp
-    push dword [eax + 64]     ; 压入eflags
-    push dword [eax + 68]     ; 压入cs
-    push dword [eax + 60]     ; 压入eip
+    ; 恢复通用寄存器（eax最后恢复）
+    mov edi, [eax + REGS_EDI] ; edi = regs.edi
+    mov esi, [eax + REGS_ESI] ; esi = regs.esi
+    mov ebp, [eax + REGS_EBP] ; ebp = regs.ebp
+    mov ebx, [eax + REGS_EBX] ; ebx = regs.ebx
+    mov edx, [eax + REGS_EDX] ; edx = regs.edx
+    mov ecx, [eax + REGS_ECX] ; ecx = regs.ecx
+    mov eax, [eax + REGS_EAX] ; eax = regs.eax
     
     ; 强制返回，恢复上下文
-    iret                     ; 从栈中弹出eip、cs、eflags、esp、ss，并跳转
+    iret                     ; 从栈中弹出eip、cs、eflags，并跳转
 
 ; 时钟中断处理包装函数
 timer_handler_wrapper:
     ; 保存所有通用寄存器
     pusha
     
+    ; 先发送EOI信号：处理函数中被终止的进程会直接退出，不再回到这里
+    mov al, 0x20
+    out 0x20, al
+    
     ; 调用C处理函数
     call timer_interrupt_handler
     
     ; 恢复所有通用寄存器
     popa
     
+    ; 中断返回
+    iret
+
+; 键盘中断处理包装函数
+keyboard_handler_wrapper:
+    pusha
+    call keyboard_handler
+    popa
+    
     ; 发送EOI信号
     mov al, 0x20
     out 0x20, al
+    iret
+
+; 串口中断处理包装函数
+serial_handler_wrapper:
+    pusha
+    call serial_handler
+    popa
     
-    ; 中断返回
+    ; 发送EOI信号
+    mov al, 0x20
+    out 0x20, al
+    iret
+
+; 本地 APIC 中断：EOI 由 C 处理函数写入本地 APIC，不经过 8259A
+lapic_timer_wrapper:
+    pusha
+    call sched_lapic_tick
+    popa
+    iret
+
+resched_ipi_wrapper:
+    pusha
+    call sched_resched_ipi
+    popa
     iret
+
+tlb_shootdown_wrapper:
+    pusha
+    call smp_tlb_shootdown_ipi
+    popa
+    iret
+
+; 伪中断不需要 EOI
+spurious_wrapper:
+    iret
+
+; 新进程的起点：ebx 为入口函数，入口函数返回时以状态 0 退出
+task_entry_stub:
+    call finish_task_switch
+    call ebx
+    push dword 0
+    call task_exit
@@ -0,0 +1,257 @@
+#include <proc/timer.h>
+#include <proc/task.h>
+#include <string.h>
+#include <common.h>
+#include <spinlock.h>
+
+// 系统时间轮：由 timer_lock 保护，回调在持有锁时调用，timer_cancel 返回后回调一定已经结束
+static timer_wheel_t system_wheel;
+static spinlock_t timer_lock = SPINLOCK_INIT;
+
+static inline void link_init(timer_link_t* head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static inline bool link_empty(const timer_link_t* head)
+{
+    return head->next == head;
+}
+
+static inline void link_add_tail(timer_link_t* head, timer_link_t* node)
+{
+    node->next = head;
+    node->prev = head->prev;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+// 摘下节点，next 置 NULL 表示不在任何链表中
+static inline void link_del(timer_link_t* node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = NULL;
+    node->prev = NULL;
+}
+
+// 把 head 上的所有节点移到 work 上，head 变为空链表
+static inline void link_splice(timer_link_t* head, timer_link_t* work)
+{
+    if (link_empty(head)) {
+        link_init(work);
+        return;
+    }
+    work->next = head->next;
+    work->prev = head->prev;
+    work->next->prev = work;
+    work->prev->next = work;
+    link_init(head);
+}
+
+// 初始化时间轮，now 为下一个要处理的时钟滴答
+void timer_wheel_init(timer_wheel_t* wheel, uint32_t now)
+{
+    wheel->now = now;
+    wheel->pending = 0;
+    for (int i = 0; i < TVR_SIZE; i++) {
+        link_init(&wheel->tv1[i]);
+    }
+    for (int level = 0; level < TVN_LEVELS; level++) {
+        for (int i = 0; i < TVN_SIZE; i++) {
+            link_init(&wheel->tvn[level][i]);
+        }
+    }
+}
+
+// 按距到期的滴答数选择槽
+static timer_link_t* wheel_slot(timer_wheel_t* wheel, uint32_t expires)
+{
+    uint32_t idx = expires - wheel->now;
+
+    // 已经过期的定时器放入下一个要处理的槽
+    if ((int32_t)idx < 0) {
+        return &wheel->tv1[wheel->now & TVR_MASK];
+    }
+    if (idx < TVR_SIZE) {
+        return &wheel->tv1[expires & TVR_MASK];
+    }
+
+    // 第 level 层覆盖 2^(8 + 6 * (level + 1)) 个滴答以内的定时器，最高层覆盖其余全部
+    int level = 0;
+    while (level < TVN_LEVELS - 1 && idx >= (1U << (TVR_BITS + (level + 1) * TVN_BITS))) {
+        level++;
+    }
+    return &wheel->tvn[level][(expires >> (TVR_BITS + level * TVN_BITS)) & TVN_MASK];
+}
+
+// 挂入定时器
+void timer_wheel_add(timer_wheel_t* wheel, ktimer_t* timer)
+{
+    link_add_tail(wheel_slot(wheel, timer->expires), &timer->link);
+    wheel->pending++;
+}
+
+// 取消定时器（未挂入时什么也不做）
+void timer_wheel_cancel(timer_wheel_t* wheel, ktimer_t* timer)
+{
+    if (timer_pending(timer)) {
+        link_del(&timer->link);
+        wheel->pending--;
+    }
+}
+
+// 把第 level 层当前的槽重新分散到下层，返回该槽的下标（为 0 时还需级联更上一层）
+static uint32_t wheel_cascade(timer_wheel_t* wheel, int level)
+{
+    uint32_t index = (wheel->now >> (TVR_BITS + level * TVN_BITS)) & TVN_MASK;
+
+    timer_link_t work;
+    link_splice(&wheel->tvn[level][index], &work);
+    while (!link_empty(&work)) {
+        timer_link_t* node = work.next;
+        link_del(node);
+        link_add_tail(wheel_slot(wheel, ((ktimer_t*)node)->expires), node);
+    }
+    return index;
+}
+
+// 逐个滴答推进到 now，调用到期定时器的回调
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint32_t now)
+{
+    uint32_t fired = 0;
+
+    while ((int32_t)(now - wheel->now) >= 0) {
+        uint32_t index = wheel->now & TVR_MASK;
+        if (index == 0) {
+            for (int level = 0; level < TVN_LEVELS; level++) {
+                if (wheel_cascade(wheel, level) != 0) {
+                    break;
+                }
+            }
+        }
+        wheel->now++;
+
+        // 先移到局部链表：回调中重新挂入的定时器不会在本轮被处理
+        timer_link_t work;
+        link_splice(&wheel->tv1[index], &work);
+        while (!link_empty(&work)) {
+            ktimer_t* timer = (ktimer_t*)work.next;
+            link_del(&timer->link);
+            wheel->pending--;
+            timer->func(timer);
+            fired++;
+        }
+    }
+    return fired;
+}
+
+// 距下一个可能有定时器到期的滴答数（相对 wheel->now），没有时返回 limit
+uint32_t timer_wheel_next(const timer_wheel_t* wheel, uint32_t limit)
+{
+    if (wheel->pending == 0) {
+        return limit;
+    }
+
+    // 第 0 层转到下一圈时上层的定时器会级联下来，只能保证到那时为止
+    uint32_t index = wheel->now & TVR_MASK;
+    if (index == 0) {
+        return 0;
+    }
+    uint32_t span = MIN(limit, (uint32_t)TVR_SIZE - index);
+    for (uint32_t i = 0; i < span; i++) {
+        if (!link_empty(&wheel->tv1[index + i])) {
+            return i;
+        }
+    }
+    return span;
+}
+
+// 初始化定时器
+void timer_setup(ktimer_t* timer, ktimer_func_t func, void* data)
+{
+    memset(timer, 0, sizeof(ktimer_t));
+    timer->func = func;
+    timer->data = data;
+}
+
+// 初始化系统时间轮
+void timer_init(void)
+{
+    timer_wheel_init(&system_wheel, get_system_ticks() + 1);
+}
+
+// 挂入系统时间轮
+void timer_add(ktimer_t* timer, uint32_t expires)
+{
+    uint32_t flags = spin_lock_irqsave(&timer_lock);
+    timer_wheel_cancel(&system_wheel, timer);
+    timer->expires = expires;
+    timer_wheel_add(&system_wheel, timer);
+    spin_unlock_irqrestore(&timer_lock, flags);
+}
+
+// 从系统时间轮取消
+bool timer_cancel(ktimer_t* timer)
+{
+    uint32_t flags = spin_lock_irqsave(&timer_lock);
+    bool pending = timer_pending(timer);
+    timer_wheel_cancel(&system_wheel, timer);
+    spin_unlock_irqrestore(&timer_lock, flags);
+    return pending;
+}
+
+// 处理到时钟滴答 now 为止到期的定时器（时钟中断中调用，包括停止滴答后的补记）
+void timer_run(uint32_t now)
+{
+    spin_lock(&timer_lock);
+    timer_wheel_advance(&system_wheel, now);
+    spin_unlock(&timer_lock);
+}
+
+// 距下一个定时器到期的滴答数（相对当前时钟滴答），最多 limit
+uint32_t timer_next_event(uint32_t limit)
+{
+    spin_lock(&timer_lock);
+    uint32_t base = system_wheel.now - get_system_ticks();
+    uint32_t next = base + timer_wheel_next(&system_wheel, limit);
+    spin_unlock(&timer_lock);
+    return next;
+}
+
+// 睡眠到期：唤醒进程（已被其他原因唤醒时什么也不做）
+static void sleep_timeout(ktimer_t* timer)
+{
+    sched_wakeup((task_t*)timer->data);
+}
+
+// 当前进程睡眠：挂入时间轮后阻塞，到期时由时钟中断放回就绪队列
+uint32_t timer_sleep(uint32_t ticks)
+{
+    task_t* task = get_current_task();
+    if (ticks == 0 || !task) {
+        schedule();
+        return 0;
+    }
+
+    ktimer_t timer;
+    timer_setup(&timer, sleep_timeout, task);
+    uint32_t expires = get_system_ticks() + ticks;
+
+    // 阻塞和挂入定时器之间不能响应时钟中断，否则可能在阻塞前就被唤醒
+    uint32_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    set_current_state(TASK_BLOCKED);
+    timer_add(&timer, expires);
+    schedule();
+    asm volatile("push %0; popf" : : "r" (flags) : "memory", "cc");
+
+    // 提前被唤醒时定时器仍在时间轮中（它位于本函数的栈上，必须取消）
+    timer_cancel(&timer);
+    
+    // 因被终止而提前唤醒时，定时器已经摘除，可以退出
+    sched_exit_if_killed();
+    int32_t left = expires - get_system_ticks();
+    return left > 0 ? left : 0;
+}
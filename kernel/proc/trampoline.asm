@@ -0,0 +1,77 @@
+; AP 启动代码：smp_init 将 ap_trampoline_start 到 ap_trampoline_end 复制到 TRAMPOLINE_BASE
+; AP 收到 SIPI 后从该地址以实模式开始执行，进入保护模式并开启分页后跳转到 C 入口
+; 参数区由 BSP 在发送 SIPI 前填写（各 AP 依次启动，共用一份）
+
+[BITS 16]
+
+global ap_trampoline_start
+global ap_trampoline_end
+global ap_trampoline_args
+
+%define TRAMPOLINE_BASE 0x8000
+%define REL(x) ((x) - ap_trampoline_start + TRAMPOLINE_BASE)
+
+section .text
+
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+
+    ; 装入临时 GDT，进入保护模式
+    lgdt [REL(tramp_gdt_desc)]
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+    jmp dword 0x08:REL(tramp_pm)
+
+[BITS 32]
+tramp_pm:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; 使用与 BSP 相同的 CR4（大页、全局页）和内核页目录开启分页
+    mov eax, [REL(tramp_cr4)]
+    mov cr4, eax
+    mov eax, [REL(tramp_cr3)]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    ; 切换到本处理器的栈，调用 entry(arg)，不返回
+    mov esp, [REL(tramp_stack)]
+    push dword [REL(tramp_arg)]
+    mov eax, [REL(tramp_entry)]
+    call eax
+
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+align 8
+tramp_gdt:
+    dq 0x0000000000000000
+    dq 0x00CF9A000000FFFF         ; 内核代码段
+    dq 0x00CF92000000FFFF         ; 内核数据段
+
+tramp_gdt_desc:
+    dw 3 * 8 - 1
+    dd REL(tramp_gdt)
+
+; 参数区（与 smp.c 中的 ap_args_t 一致）
+align 4
+ap_trampoline_args:
+tramp_cr3:   dd 0
+tramp_cr4:   dd 0
+tramp_stack: dd 0
+tramp_entry: dd 0
+tramp_arg:   dd 0
+
+ap_trampoline_end:
@@ -0,0 +1,220 @@
+#include <proc/wait.h>
+#include <proc/task.h>
+#include <string.h>
+#include <common.h>
+#include <spinlock.h>
+
+// 所有等待队列共用一把锁：入队、出队和唤醒都很短，也避免唤醒与阻塞在不同处理器上交错
+static spinlock_t wait_lock = SPINLOCK_INIT;
+
+// 初始化等待队列
+void wait_queue_init(wait_queue_t* wq)
+{
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+// 队列中是否有等待者
+bool wait_queue_active(const wait_queue_t* wq)
+{
+    return wq->head != NULL;
+}
+
+// 等待项入队：非独占等待项放在队首，独占等待项放在队尾（调用者持有 wait_lock）
+static void wait_link(wait_queue_t* wq, wait_entry_t* entry)
+{
+    if (entry->flags & WAIT_EXCLUSIVE) {
+        entry->next = NULL;
+        entry->prev = wq->tail;
+        if (wq->tail) {
+            wq->tail->next = entry;
+        } else {
+            wq->head = entry;
+        }
+        wq->tail = entry;
+    } else {
+        entry->prev = NULL;
+        entry->next = wq->head;
+        if (wq->head) {
+            wq->head->prev = entry;
+        } else {
+            wq->tail = entry;
+        }
+        wq->head = entry;
+    }
+    entry->queued = true;
+}
+
+// 等待项出队（调用者持有 wait_lock）
+static void wait_unlink(wait_queue_t* wq, wait_entry_t* entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        wq->head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        wq->tail = entry->prev;
+    }
+    entry->next = NULL;
+    entry->prev = NULL;
+    entry->queued = false;
+}
+
+// 等待项入队
+void wait_queue_add(wait_queue_t* wq, wait_entry_t* entry)
+{
+    uint32_t flags = spin_lock_irqsave(&wait_lock);
+    if (!entry->queued) {
+        wait_link(wq, entry);
+    }
+    spin_unlock_irqrestore(&wait_lock, flags);
+}
+
+// 等待项出队
+void wait_queue_remove(wait_queue_t* wq, wait_entry_t* entry)
+{
+    uint32_t flags = spin_lock_irqsave(&wait_lock);
+    if (entry->queued) {
+        wait_unlink(wq, entry);
+    }
+    spin_unlock_irqrestore(&wait_lock, flags);
+}
+
+// 从队首开始唤醒，遇到第 nr_exclusive 个独占等待项后停止
+uint32_t wake_up_nr(wait_queue_t* wq, uint32_t nr_exclusive)
+{
+    uint32_t flags = spin_lock_irqsave(&wait_lock);
+
+    uint32_t woken = 0;
+    wait_entry_t* entry = wq->head;
+    while (entry) {
+        wait_entry_t* next = entry->next;
+        bool exclusive = entry->flags & WAIT_EXCLUSIVE;
+
+        wait_unlink(wq, entry);
+        if (entry->task && sched_wakeup(entry->task)) {
+            woken++;
+        }
+        if (exclusive && nr_exclusive && --nr_exclusive == 0) {
+            break;
+        }
+        entry = next;
+    }
+
+    spin_unlock_irqrestore(&wait_lock, flags);
+    return woken;
+}
+
+// 唤醒所有非独占等待者和一个独占等待者
+uint32_t wake_up(wait_queue_t* wq)
+{
+    return wake_up_nr(wq, 1);
+}
+
+// 唤醒所有等待者
+uint32_t wake_up_all(wait_queue_t* wq)
+{
+    return wake_up_nr(wq, 0);
+}
+
+// 等待超时：唤醒等待的进程，由它自己发现已超时
+static void wait_timeout(ktimer_t* timer)
+{
+    wait_entry_t* entry = (wait_entry_t*)timer->data;
+    if (entry->task) {
+        sched_wakeup(entry->task);
+    }
+}
+
+// 开始等待：关中断并初始化等待项，timeout 为超时的滴答数（flags 含 WAIT_TIMEOUT 时有效）
+void wait_begin(wait_entry_t* entry, uint32_t flags, uint32_t timeout)
+{
+    uint32_t irq_flags;
+    asm volatile("pushf; pop %0; cli" : "=r" (irq_flags) : : "memory");
+
+    memset(entry, 0, sizeof(wait_entry_t));
+    entry->flags = flags;
+    entry->irq_flags = irq_flags;
+
+    // 空闲进程和调度器启动前的代码不能阻塞，只能停机等待下一个中断
+    task_t* task = get_current_task();
+    if (task && task->pid != 0) {
+        entry->task = task;
+    }
+
+    if (flags & WAIT_TIMEOUT) {
+        entry->expires = get_system_ticks() + timeout;
+        timer_setup(&entry->timer, wait_timeout, entry);
+        timer_add(&entry->timer, entry->expires);
+    }
+}
+
+// 入队并把进程标记为阻塞，随后检查条件，不成立时由 wait_schedule 让出处理器
+// 先入队再检查条件：其他处理器在检查之后设置条件时一定能看到等待项并唤醒本进程
+void prepare_to_wait(wait_queue_t* wq, wait_entry_t* entry)
+{
+    spin_lock(&wait_lock);
+    if (!entry->queued) {
+        wait_link(wq, entry);
+    }
+    if (entry->task) {
+        set_current_state(TASK_BLOCKED);
+    }
+    spin_unlock(&wait_lock);
+}
+
+// 阻塞直到被唤醒（不能阻塞时停机等待任意中断）
+void wait_schedule(wait_entry_t* entry)
+{
+    if (entry->task) {
+        schedule();
+    } else {
+        asm volatile("sti; hlt; cli" : : : "memory");
+    }
+}
+
+// 是否已超时
+bool wait_timed_out(const wait_entry_t* entry)
+{
+    return (entry->flags & WAIT_TIMEOUT) && (int32_t)(get_system_ticks() - entry->expires) >= 0;
+}
+
+// 进程是否已被终止（sched_kill）
+bool wait_killed(const wait_entry_t* entry)
+{
+    return entry->task && entry->task->killed;
+}
+
+// 结束等待：出队、取消超时定时器、恢复中断，返回剩余的滴答数（超时为 0）
+// 进程已被终止时在等待项和定时器都摘除之后退出
+uint32_t wait_end(wait_queue_t* wq, wait_entry_t* entry, bool done)
+{
+    spin_lock(&wait_lock);
+    if (entry->queued) {
+        wait_unlink(wq, entry);
+    }
+
+    // 条件已成立但进程仍处于阻塞状态（检查条件前已入队）时恢复为运行状态
+    task_t* task = entry->task;
+    if (task && task->state == TASK_BLOCKED) {
+        set_current_state(TASK_RUNNING);
+    }
+    spin_unlock(&wait_lock);
+
+    uint32_t left = 1;
+    if (entry->flags & WAIT_TIMEOUT) {
+        timer_cancel(&entry->timer);
+        int32_t remaining = entry->expires - get_system_ticks();
+        left = remaining > 0 ? remaining : 1;
+    }
+
+    asm volatile("push %0; popf" : : "r" (entry->irq_flags) : "memory", "cc");
+    
+    if (wait_killed(entry)) {
+        sched_exit_if_killed();
+    }
+    return done ? left : 0;
+}
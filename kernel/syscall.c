@@ -1,8 +1,14 @@
 #include <syscall.h>
 #include <proc/task.h>
+#include <proc/timer.h>
+#include <proc/wait.h>
 #include <proc/regs.h>
+#include <proc/smp.h>
 #include <mm/paging.h>
 #include <mm/kheap.h>
+#include <mm/vmm.h>
+#include <mm/scratch.h>
+#include <common.h>
 #include <string.h>
 #include <vga.h>
 #include <serial.h>
@@ -14,7 +20,7 @@
 extern syscall_handler_t syscall_table[];
 
 // 系统调用处理函数的最大数量
-#define MAX_SYSCALLS 12
+#define MAX_SYSCALLS 13
 
 // 系统调用入口（汇编实现，用于用户空间调用）
 int syscall(int num, ...) {
@@ -43,6 +49,12 @@ void syscall_handler(struct regs* regs) {
         kprintf("[ERROR] Syscall handler not found for %d\n", syscall_num);
         regs->eax = -1;
     }
+    
+    // 处理函数在临时区中分配的内存随系统调用返回一并释放
+    scratch_reset();
+    
+    // 执行期间被终止的进程在返回前退出
+    sched_exit_if_killed();
 }
 
 // SYS_exit - 退出当前进程
@@ -54,22 +66,32 @@ int sys_exit_handler(struct regs* regs) {
 
 // SYS_fork - 创建新进程
 int sys_fork_handler(struct regs* regs) {
-    // 创建新进程，复制当前进程的上下文
-    task_t* child = create_task(
+    // 以写时复制方式复制地址空间（只复制页表，不复制页）
+    vm_space_t* mm = vm_space_fork(current_task->mm);
+    if (!mm) {
+        return -1;
+    }
+    
+    // 创建新进程，复制当前进程的上下文；设置完成之前不放入就绪队列，其他处理器不会运行它
+    task_t* child = create_task_stopped(
         (void*)regs->eip, 
         "forked", 
         current_task->priority
     );
     if (!child) {
+        vm_space_put(mm);
         return -1;
     }
     
     // 复制寄存器上下文（除了eax，设置为0表示子进程）
     memcpy(&child->regs, regs, sizeof(regs_context_t));
     child->regs.eax = 0; // 子进程返回0
+    child->regs.gs = GDT_PERCPU; // gs 始终指向所在处理器的数据
     
     // 复制当前进程的内存管理信息
-    child->page_dir = current_task->page_dir;
+    vm_space_put(child->mm);
+    child->mm = mm;
+    child->page_dir = mm->page_dir;
     child->heap_start = current_task->heap_start;
     child->heap_end = current_task->heap_end;
     child->memory_usage_kb = current_task->memory_usage_kb;
@@ -77,16 +99,34 @@ int sys_fork_handler(struct regs* regs) {
     // 复制用户栈顶
     child->user_stack_top = current_task->user_stack_top;
     
+    // 设置完成，发布子进程
+    sched_wake_up_new(child);
+    
     // 返回子进程的PID
     return child->pid;
 }
 
-// SYS_wait - 等待子进程退出
+// SYS_wait - 等待子进程退出并回收，返回子进程的PID（ebx 不大于 0 时等待任意子进程）
 int sys_wait_handler(struct regs* regs) {
-    uint32_t pid = regs->ebx;
+    int pid = regs->ebx;
+    int* status = (int*)regs->ecx;
     
-    // 简化实现：仅返回成功
-    return 0;
+    // 没有符合条件的子进程时立即返回
+    if (!sched_find_child(current_task, pid, false)) {
+        return -1;
+    }
+    
+    // 阻塞直到子进程退出（子进程退出时唤醒父进程的 child_exit 队列）
+    task_t* child;
+    wait_event(current_task->child_exit, (child = sched_find_child(current_task, pid, true)) != NULL);
+    
+    int child_pid = child->pid;
+    if (status) {
+        *status = child->exit_code;
+    }
+    sched_reap(child);
+    
+    return child_pid;
 }
 
 // SYS_write - 写入文件
@@ -180,40 +220,63 @@ int sys_sbrk_handler(struct regs* regs) {
     }
     
     // 确保堆大小不会超过用户空间
-    if (new_heap_end > 0xC0000000) {
+    if (new_heap_end > USER_SPACE_END || new_heap_end < current_task->heap_start) {
         return -1;
     }
     
-    // 调整堆大小
-    current_task->heap_end = new_heap_end;
+    // 调整堆区域：扩展时只登记区域，物理页在首次访问时分配；收缩时释放多余的页
+    uint32_t old_limit = ALIGN_UP(old_heap_end, PAGE_SIZE);
+    uint32_t new_limit = ALIGN_UP(new_heap_end, PAGE_SIZE);
+    if (new_limit > old_limit) {
+        if (vm_area_map(current_task->mm, old_limit, new_limit, VM_READ | VM_WRITE) < 0) {
+            return -1;
+        }
+    } else if (new_limit < old_limit) {
+        vm_area_unmap(current_task->mm, new_limit, old_limit);
+    }
     
-    // 更新内存使用统计
-    current_task->memory_usage_kb += (increment + 1023) / 1024;
+    current_task->heap_end = new_heap_end;
     
     // 返回旧的堆结束地址
     return old_heap_end;
 }
 
-// SYS_sleep - 进程睡眠
+// 睡眠时长的上限（时钟滴答），保证到期时间与当前时间的差值不超过 int32 范围
+#define MAX_SLEEP_TICKS 0x7FFFFFFF
+
+// 每个时钟滴答的纳秒数
+#define NSEC_PER_TICK (NSEC_PER_SEC / TIMER_HZ)
+
+// SYS_sleep - 进程睡眠，返回未睡完的秒数
 int sys_sleep_handler(struct regs* regs) {
     unsigned int seconds = regs->ebx;
     
-    // 简化实现：使用时钟中断计数
-    uint32_t start_ticks = get_system_ticks();
-    uint32_t end_ticks = start_ticks + seconds * 100;
+    // 挂入时间轮后阻塞，睡眠期间不占用处理器
+    uint32_t ticks = MIN(seconds, MAX_SLEEP_TICKS / TIMER_HZ) * TIMER_HZ;
+    uint32_t left = timer_sleep(ticks);
     
-    // 将进程状态改为阻塞
-    current_task->state = TASK_BLOCKED;
+    return (left + TIMER_HZ - 1) / TIMER_HZ;
+}
+
+// SYS_nanosleep - 按纳秒指定时长睡眠（向上取整到时钟滴答）
+int sys_nanosleep_handler(struct regs* regs) {
+    const struct timespec* req = (const struct timespec*)regs->ebx;
+    struct timespec* rem = (struct timespec*)regs->ecx;
     
-    // 循环检查时间，直到超时
-    while (get_system_ticks() < end_ticks) {
-        schedule();
+    if (!req || req->tv_nsec >= NSEC_PER_SEC) {
+        return -1;
     }
     
-    // 恢复进程状态为就绪
-    current_task->state = TASK_READY;
+    uint32_t ticks = MIN(req->tv_sec, MAX_SLEEP_TICKS / TIMER_HZ - 1) * TIMER_HZ;
+    ticks += (req->tv_nsec + NSEC_PER_TICK - 1) / NSEC_PER_TICK;
+    uint32_t left = timer_sleep(ticks);
     
-    return 0;
+    // 提前被唤醒时返回剩余时间
+    if (rem) {
+        rem->tv_sec = left / TIMER_HZ;
+        rem->tv_nsec = (left % TIMER_HZ) * NSEC_PER_TICK;
+    }
+    return left ? -1 : 0;
 }
 
 // SYS_execve - 替换当前进程映像
@@ -224,10 +287,33 @@ int sys_execve_handler(struct regs* regs) {
     
     uint32_t entry_point;
     
-    // 加载ELF文件
+    // 路径位于旧地址空间的用户内存中，切换地址空间前复制到临时区
+    path = scratch_strdup(path);
+    if (!path) {
+        return -1;
+    }
+    
+    // 新程序在全新的地址空间中加载，fork 后共享的页随旧地址空间一起释放
+    vm_space_t* old_mm = current_task->mm;
+    vm_space_t* new_mm = vm_space_create();
+    if (!new_mm) {
+        return -1;
+    }
+    current_task->mm = new_mm;
+    current_task->page_dir = new_mm->page_dir;
+    vm_space_switch(new_mm);
+    
+    // 加载ELF文件，失败时恢复原地址空间
     if (elf_load(path, &entry_point) < 0) {
+        current_task->mm = old_mm;
+        current_task->page_dir = old_mm->page_dir;
+        vm_space_switch(old_mm);
+        vm_space_put(new_mm);
         return -1;
     }
+    vm_space_put(old_mm);
+    current_task->heap_start = 0;
+    current_task->heap_end = 0;
     
     // 设置进程名
     strncpy(current_task->name, path, sizeof(current_task->name) - 1);
@@ -0,0 +1,121 @@
+#include <apic.h>
+#include <pit.h>
+#include <common.h>
+#include <mm/paging.h>
+
+// 校准时测量的 PIT 周期数
+#define LAPIC_CALIBRATE_PERIODS 10
+
+static volatile uint32_t* lapic = NULL;
+
+static inline uint32_t lapic_read(uint32_t reg)
+{
+    return lapic[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value)
+{
+    lapic[reg / 4] = value;
+    (void)lapic[LAPIC_ID / 4];    // 读回，保证写操作已经生效
+}
+
+bool lapic_map(uint32_t phys_base)
+{
+    if (phys_base & ~PAGE_FRAME_MASK) {
+        return false;
+    }
+    map_page((void*)LAPIC_VIRT_ADDR, phys_base, PAGE_PRESENT | PAGE_WRITABLE | PAGE_CACHE_DISABLED | PAGE_GLOBAL);
+    lapic = (volatile uint32_t*)LAPIC_VIRT_ADDR;
+    return true;
+}
+
+void lapic_enable(bool bsp)
+{
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+
+    // BSP 的 LINT0 保持 BIOS 设置的虚拟线模式，8259A 的中断照常送达
+    if (!bsp) {
+        lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+        lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_MASKED);
+    }
+
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_EOI, 0);
+}
+
+uint32_t lapic_id(void)
+{
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void lapic_eoi(void)
+{
+    lapic_write(LAPIC_EOI, 0);
+}
+
+// 写 ICR 并等待投递完成
+static void lapic_send(uint32_t apic_id, uint32_t command)
+{
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING) {
+        __asm__ volatile("pause");
+    }
+}
+
+void lapic_send_init(uint32_t apic_id)
+{
+    lapic_send(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL | LAPIC_ICR_ASSERT);
+    lapic_send(apic_id, LAPIC_ICR_INIT | LAPIC_ICR_LEVEL);
+}
+
+void lapic_send_startup(uint32_t apic_id, uint32_t page)
+{
+    lapic_send(apic_id, LAPIC_ICR_STARTUP | (page & 0xFF));
+}
+
+void lapic_send_ipi(uint32_t apic_id, uint32_t vector)
+{
+    lapic_send(apic_id, vector & 0xFF);
+}
+
+uint32_t lapic_timer_calibrate(void)
+{
+    // 先对齐到 PIT 周期的边界，再让 APIC 定时器从最大值递减若干个周期
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    pit_wait_periods(1);
+    lapic_write(LAPIC_TIMER_INIT, 0xFFFFFFFF);
+    pit_wait_periods(LAPIC_CALIBRATE_PERIODS);
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INIT, 0);
+
+    return elapsed / LAPIC_CALIBRATE_PERIODS;
+}
+
+void lapic_timer_start(uint32_t count)
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INIT, MAX(count, 1U));
+}
+
+void lapic_timer_oneshot(uint32_t count)
+{
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_TIMER_INIT, MAX(count, 1U));
+}
+
+uint32_t lapic_timer_remaining(void)
+{
+    return lapic_read(LAPIC_TIMER_CURRENT);
+}
+
+bool lapic_irq_pending(uint32_t vector)
+{
+    vector &= 0xFF;
+    return (lapic_read(LAPIC_IRR + (vector / 32) * 0x10) >> (vector % 32)) & 1;
+}
@@ -1,7 +1,9 @@
 #include <interrupts.h>
 #include <keyboard.h>
+#include <serial.h>
 #include <vga.h>
 #include <common.h>
+#include <apic.h>
 
 static idt_entry_t idt[IDT_ENTRIES];
 static idt_ptr_t idt_ptr;
@@ -27,20 +29,16 @@ void idt_init(void)
     }
 }
 
-void keyboard_handler_wrapper(void)
+// 键盘中断：扫描码放入缓冲区，由读者（shell）解码和回显
+void keyboard_handler(void)
 {
-    keyboard_handler();
+    keyboard_irq();
 }
 
-void keyboard_handler(void)
+// 串口接收中断
+void serial_handler(void)
 {
-    key_event_t event;
-    
-    if (keyboard_read(&event) && event.pressed && event.ascii != 0) {
-        vga_putc(event.ascii);
-    }
-    
-    __asm__ volatile("outb %al, $0x20");
+    serial_irq();
 }
 
 void isr_install(void)
@@ -48,24 +46,49 @@ void isr_install(void)
     idt_init();
 }
 
-// 声明时钟中断处理函数
+// 装入 IDT（所有处理器共用一张表，AP 启动时也调用）
+void idt_load(void)
+{
+    __asm__ volatile("lidt %0" : : "m"(idt_ptr));
+}
+
+// 声明时钟中断和缺页异常处理函数
 void timer_handler_wrapper(void);
+void page_fault_handler_wrapper(void);
+void lapic_timer_wrapper(void);
+void resched_ipi_wrapper(void);
+void tlb_shootdown_wrapper(void);
+void spurious_wrapper(void);
 
 void irq_install(void)
 {
     uint32_t keyboard_addr = (uint32_t)keyboard_handler_wrapper;
+    uint32_t serial_addr = (uint32_t)serial_handler_wrapper;
     uint32_t timer_addr = (uint32_t)timer_handler_wrapper;
+    uint32_t page_fault_addr = (uint32_t)page_fault_handler_wrapper;
+    
+    // 设置缺页异常处理（按需分配用户页）
+    idt_set_gate(14, (uint64_t)page_fault_addr, 0x08, 0x8E);
     
     // 设置键盘中断处理
     idt_set_gate(0x21, (uint64_t)keyboard_addr, 0x08, 0x8E);
     
+    // 设置串口（COM1, IRQ4）中断处理
+    idt_set_gate(0x24, (uint64_t)serial_addr, 0x08, 0x8E);
+    
     // 设置时钟中断处理
     idt_set_gate(0x20, (uint64_t)timer_addr, 0x08, 0x8E);
     
-    __asm__ volatile("lidt %0" : : "m"(idt_ptr));
+    // 设置本地 APIC 中断处理（AP 的时钟滴答、重新调度 IPI、TLB 击落 IPI 和伪中断）
+    idt_set_gate(LAPIC_TIMER_VECTOR, (uint64_t)(uint32_t)lapic_timer_wrapper, 0x08, 0x8E);
+    idt_set_gate(RESCHED_VECTOR, (uint64_t)(uint32_t)resched_ipi_wrapper, 0x08, 0x8E);
+    idt_set_gate(TLB_SHOOTDOWN_VECTOR, (uint64_t)(uint32_t)tlb_shootdown_wrapper, 0x08, 0x8E);
+    idt_set_gate(LAPIC_SPURIOUS_VECTOR, (uint64_t)(uint32_t)spurious_wrapper, 0x08, 0x8E);
+    
+    idt_load();
     
-    // 启用时钟和键盘中断
+    // 启用时钟、键盘和串口中断
     __asm__ volatile("inb $0x21, %al");
-    __asm__ volatile("andb $0xFC, %al");
+    __asm__ volatile("andb $0xEC, %al");
     __asm__ volatile("outb %al, $0x21");
 }
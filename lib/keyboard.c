@@ -1,5 +1,7 @@
 #include <keyboard.h>
 #include <common.h>
+#include <proc/wait.h>
+#include <spinlock.h>
 
 static const char scancode_to_ascii_table[128] = {
     0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
@@ -20,6 +22,62 @@ static const char scancode_to_ascii_table_shift[128] = {
 static bool shift_pressed = false;
 static bool caps_lock = false;
 
+// 扫描码缓冲区：由键盘中断填充，读者在 keyboard_wait 上阻塞直到有数据
+static uint8_t keyboard_buffer[KEYBOARD_BUFFER_SIZE];
+static uint32_t keyboard_head = 0;             // 下一个读出位置
+static uint32_t keyboard_tail = 0;             // 下一个写入位置
+static wait_queue_t keyboard_wait;
+static spinlock_t keyboard_lock = SPINLOCK_INIT;   // 保护缓冲区和控制器端口（中断处理函数与其他处理器上的读者并发访问）
+
+// 取走控制器中所有待读的扫描码，缓冲区满时丢弃（调用者持有 keyboard_lock）
+static void keyboard_buffer_fill(void)
+{
+    uint8_t status;
+    uint8_t scancode;
+    
+    while (1) {
+        __asm__ volatile("inb $0x64, %0" : "=a"(status));
+        if (!(status & KEYBOARD_STATUS_OUTPUT_FULL)) {
+            break;
+        }
+        __asm__ volatile("inb $0x60, %0" : "=a"(scancode));
+        
+        if (keyboard_tail - keyboard_head < KEYBOARD_BUFFER_SIZE) {
+            keyboard_buffer[keyboard_tail % KEYBOARD_BUFFER_SIZE] = scancode;
+            keyboard_tail++;
+        }
+    }
+}
+
+// 取出一个扫描码，缓冲区为空时返回 false（顺带取走控制器中的扫描码，中断被屏蔽时也能读到）
+static bool keyboard_buffer_pop(uint8_t* scancode)
+{
+    uint32_t flags = spin_lock_irqsave(&keyboard_lock);
+    
+    keyboard_buffer_fill();
+    bool ready = keyboard_tail != keyboard_head;
+    if (ready) {
+        *scancode = keyboard_buffer[keyboard_head % KEYBOARD_BUFFER_SIZE];
+        keyboard_head++;
+    }
+    
+    spin_unlock_irqrestore(&keyboard_lock, flags);
+    return ready;
+}
+
+// 键盘中断：扫描码放入缓冲区并唤醒一个读者
+void keyboard_irq(void)
+{
+    uint32_t flags = spin_lock_irqsave(&keyboard_lock);
+    keyboard_buffer_fill();
+    bool ready = keyboard_tail != keyboard_head;
+    spin_unlock_irqrestore(&keyboard_lock, flags);
+    
+    if (ready) {
+        wake_up(&keyboard_wait);
+    }
+}
+
 void keyboard_init(void)
 {
     __asm__ volatile("cli");
@@ -33,16 +91,13 @@ void keyboard_init(void)
     __asm__ volatile("sti");
 }
 
+// 阻塞直到有按键，不再轮询状态端口
 char keyboard_get_scancode(void)
 {
-    uint8_t status;
-    uint8_t scancode;
-    
-    do {
-        __asm__ volatile("inb $0x64, %0" : "=a"(status));
-    } while (!(status & KEYBOARD_STATUS_OUTPUT_FULL));
+    uint8_t scancode = 0;
     
-    __asm__ volatile("inb $0x60, %0" : "=a"(scancode));
+    // 检查和取出在同一次加锁中完成，其他处理器上的读者先取走时继续等待
+    wait_event_exclusive(keyboard_wait, keyboard_buffer_pop(&scancode));
     
     return scancode;
 }
@@ -2,10 +2,14 @@
 #include <string.h>
 #include <vga.h>
 #include <fs.h>
+#include <spinlock.h>
 
 // 简单的格式化输出缓冲区大小
 #define PRINTF_BUFFER_SIZE 1024
 
+// 多个处理器同时输出时整行输出，不互相穿插
+static spinlock_t console_lock = SPINLOCK_INIT;
+
 // 内核格式化输出函数
 int kprintf(const char* format, ...)
 {
@@ -101,7 +105,9 @@ int kprintf(const char* format, ...)
     va_end(args);
     
     // 输出到VGA控制台
+    uint32_t flags = spin_lock_irqsave(&console_lock);
     kprint(buffer);
+    spin_unlock_irqrestore(&console_lock, flags);
     
     // 尝试写入到/dev/log文件（如果存在）
     int log_fd = open("/dev/log", O_WRONLY | O_CREAT, 0666);
@@ -38,6 +38,11 @@ int sleep(unsigned int seconds) {
     return syscall(SYS_sleep, seconds);
 }
 
+// 高精度睡眠（精度为一个时钟滴答）
+int nanosleep(const struct timespec* req, struct timespec* rem) {
+    return syscall(SYS_nanosleep, req, rem);
+}
+
 // 简单的malloc实现，使用sbrk
 void* malloc(size_t size) {
     // 每次分配4KB的倍数
@@ -0,0 +1,67 @@
+#include <pit.h>
+#include <common.h>
+
+// 主 8259A 中断控制器的命令端口和读取中断请求寄存器的命令
+#define PIC1_COMMAND 0x20
+#define PIC_READ_IRR 0x0A
+
+static void pit_outb(uint16_t port, uint8_t value)
+{
+    __asm__ volatile("outb %0, %1" : : "a"(value), "Nd"(port));
+}
+
+static uint8_t pit_inb(uint16_t port)
+{
+    uint8_t value;
+    __asm__ volatile("inb %1, %0" : "=a"(value) : "Nd"(port));
+    return value;
+}
+
+static void pit_load(uint8_t command, uint32_t count)
+{
+    pit_outb(PIT_COMMAND, command);
+    pit_outb(PIT_CHANNEL0, count & 0xFF);
+    pit_outb(PIT_CHANNEL0, (count >> 8) & 0xFF);
+}
+
+uint32_t pit_period_count(uint32_t hz)
+{
+    return (PIT_FREQUENCY + hz / 2) / hz;
+}
+
+void pit_set_periodic(uint32_t hz)
+{
+    pit_load(PIT_CMD_PERIODIC, pit_period_count(hz));
+}
+
+void pit_set_oneshot(uint32_t count)
+{
+    pit_load(PIT_CMD_ONESHOT, MIN(MAX(count, 1U), (uint32_t)PIT_MAX_COUNT));
+}
+
+uint32_t pit_read_count(void)
+{
+    pit_outb(PIT_COMMAND, PIT_CMD_LATCH);
+    uint32_t low = pit_inb(PIT_CHANNEL0);
+    uint32_t high = pit_inb(PIT_CHANNEL0);
+    return (high << 8) | low;
+}
+
+bool pit_irq_pending(void)
+{
+    pit_outb(PIC1_COMMAND, PIC_READ_IRR);
+    return pit_inb(PIC1_COMMAND) & 0x01;
+}
+
+// 计数从初值递减到 1 后重装，读数变大即过了一个周期
+void pit_wait_periods(uint32_t periods)
+{
+    uint32_t last = pit_read_count();
+    while (periods > 0) {
+        uint32_t count = pit_read_count();
+        if (count > last) {
+            periods--;
+        }
+        last = count;
+    }
+}
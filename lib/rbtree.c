@@ -0,0 +1,275 @@
+#include <rbtree.h>
+
+// 用 new_node 替换 parent 下的子节点 old_node（parent 为 NULL 时替换根）
+static void rb_replace_child(rb_node_t* parent, rb_node_t* old_node, rb_node_t* new_node, rb_root_t* root)
+{
+    if (!parent) {
+        root->node = new_node;
+    } else if (parent->left == old_node) {
+        parent->left = new_node;
+    } else {
+        parent->right = new_node;
+    }
+}
+
+// 左旋：node 的右子节点成为 node 的父节点
+static void rb_rotate_left(rb_node_t* node, rb_root_t* root)
+{
+    rb_node_t* right = node->right;
+
+    node->right = right->left;
+    if (right->left) {
+        right->left->parent = node;
+    }
+    right->parent = node->parent;
+    rb_replace_child(node->parent, node, right, root);
+    right->left = node;
+    node->parent = right;
+}
+
+// 右旋：node 的左子节点成为 node 的父节点
+static void rb_rotate_right(rb_node_t* node, rb_root_t* root)
+{
+    rb_node_t* left = node->left;
+
+    node->left = left->right;
+    if (left->right) {
+        left->right->parent = node;
+    }
+    left->parent = node->parent;
+    rb_replace_child(node->parent, node, left, root);
+    left->right = node;
+    node->parent = left;
+}
+
+static inline int rb_is_black(const rb_node_t* node)
+{
+    return !node || node->color == RB_BLACK;
+}
+
+// 插入后重新平衡：新节点为红色，消除连续的红节点
+void rb_insert_color(rb_node_t* node, rb_root_t* root)
+{
+    rb_node_t* parent;
+
+    while ((parent = node->parent) && parent->color == RB_RED) {
+        // 父节点为红色时一定不是根，祖父节点存在
+        rb_node_t* gparent = parent->parent;
+
+        if (parent == gparent->left) {
+            rb_node_t* uncle = gparent->right;
+            if (uncle && uncle->color == RB_RED) {
+                // 叔节点为红色：父、叔变黑，祖父变红，继续向上检查
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->right) {
+                rb_rotate_left(parent, root);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_right(gparent, root);
+        } else {
+            rb_node_t* uncle = gparent->left;
+            if (uncle && uncle->color == RB_RED) {
+                parent->color = RB_BLACK;
+                uncle->color = RB_BLACK;
+                gparent->color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->left) {
+                rb_rotate_right(parent, root);
+                node = parent;
+                parent = node->parent;
+            }
+            parent->color = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_left(gparent, root);
+        }
+    }
+
+    root->node->color = RB_BLACK;
+}
+
+// 删除黑色节点后重新平衡：node 所在子树少了一个黑节点（node 可能为 NULL）
+static void rb_erase_color(rb_node_t* node, rb_node_t* parent, rb_root_t* root)
+{
+    while (node != root->node && rb_is_black(node)) {
+        if (node == parent->left) {
+            rb_node_t* sibling = parent->right;
+            if (sibling->color == RB_RED) {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rb_rotate_left(parent, root);
+                sibling = parent->right;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->right)) {
+                sibling->left->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rb_rotate_right(sibling, root);
+                sibling = parent->right;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->right->color = RB_BLACK;
+            rb_rotate_left(parent, root);
+        } else {
+            rb_node_t* sibling = parent->left;
+            if (sibling->color == RB_RED) {
+                sibling->color = RB_BLACK;
+                parent->color = RB_RED;
+                rb_rotate_right(parent, root);
+                sibling = parent->left;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node = parent;
+                parent = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->left)) {
+                sibling->right->color = RB_BLACK;
+                sibling->color = RB_RED;
+                rb_rotate_left(sibling, root);
+                sibling = parent->left;
+            }
+            sibling->color = parent->color;
+            parent->color = RB_BLACK;
+            sibling->left->color = RB_BLACK;
+            rb_rotate_right(parent, root);
+        }
+        node = root->node;
+        break;
+    }
+
+    if (node) {
+        node->color = RB_BLACK;
+    }
+}
+
+// 删除节点
+void rb_erase(rb_node_t* node, rb_root_t* root)
+{
+    rb_node_t* child;
+    rb_node_t* parent;
+    int color;
+
+    if (!node->left || !node->right) {
+        // 至多一个子节点：子节点直接顶替
+        child = node->left ? node->left : node->right;
+        parent = node->parent;
+        color = node->color;
+        if (child) {
+            child->parent = parent;
+        }
+        rb_replace_child(parent, node, child, root);
+    } else {
+        // 两个子节点：用中序后继（右子树的最小节点）顶替 node 的位置和颜色
+        rb_node_t* successor = node->right;
+        while (successor->left) {
+            successor = successor->left;
+        }
+
+        child = successor->right;
+        color = successor->color;
+        parent = successor->parent;
+        if (parent == node) {
+            parent = successor;
+        } else {
+            if (child) {
+                child->parent = parent;
+            }
+            parent->left = child;
+            successor->right = node->right;
+            node->right->parent = successor;
+        }
+
+        successor->left = node->left;
+        node->left->parent = successor;
+        successor->parent = node->parent;
+        successor->color = node->color;
+        rb_replace_child(node->parent, node, successor, root);
+    }
+
+    if (color == RB_BLACK) {
+        rb_erase_color(child, parent, root);
+    }
+}
+
+// 最小节点
+rb_node_t* rb_first(const rb_root_t* root)
+{
+    rb_node_t* node = root->node;
+    if (!node) {
+        return NULL;
+    }
+    while (node->left) {
+        node = node->left;
+    }
+    return node;
+}
+
+// 中序后继
+rb_node_t* rb_next(const rb_node_t* node)
+{
+    if (node->right) {
+        node = node->right;
+        while (node->left) {
+            node = node->left;
+        }
+        return (rb_node_t*)node;
+    }
+
+    // 向上找到第一个以左子树包含 node 的祖先
+    rb_node_t* parent = node->parent;
+    while (parent && node == parent->right) {
+        node = parent;
+        parent = node->parent;
+    }
+    return parent;
+}
+
+// 最大节点
+rb_node_t* rb_last(const rb_root_t* root)
+{
+    rb_node_t* node = root->node;
+    if (!node) {
+        return NULL;
+    }
+    while (node->right) {
+        node = node->right;
+    }
+    return node;
+}
+
+// 中序前驱
+rb_node_t* rb_prev(const rb_node_t* node)
+{
+    if (node->left) {
+        node = node->left;
+        while (node->right) {
+            node = node->right;
+        }
+        return (rb_node_t*)node;
+    }
+
+    // 向上找到第一个以右子树包含 node 的祖先
+    rb_node_t* parent = node->parent;
+    while (parent && node == parent->left) {
+        node = parent;
+        parent = node->parent;
+    }
+    return parent;
+}
@@ -1,5 +1,14 @@
 #include <serial.h>
 #include <common.h>
+#include <proc/wait.h>
+#include <spinlock.h>
+
+// 接收缓冲区：由串口接收中断填充，读者在 serial_wait_queue 上阻塞直到有数据
+static char serial_buffer[SERIAL_BUFFER_SIZE];
+static uint32_t serial_head = 0;               // 下一个读出位置
+static uint32_t serial_tail = 0;               // 下一个写入位置
+static wait_queue_t serial_wait_queue;
+static spinlock_t serial_lock = SPINLOCK_INIT;     // 保护接收缓冲区和接收寄存器（中断处理函数与其他处理器上的读者并发访问）
 
 static void serial_outb(uint16_t port, uint8_t value)
 {
@@ -22,6 +31,9 @@ void serial_init(void)
     serial_outb(SERIAL_COM1_BASE + 3, 0x03);
     serial_outb(SERIAL_COM1_BASE + 2, 0xC7);
     serial_outb(SERIAL_COM1_BASE + 4, 0x0B);
+    
+    // 开启接收数据中断（OUT2 已置位，中断送到 IRQ4）
+    serial_outb(SERIAL_COM1_BASE + 1, 0x01);
 }
 
 void serial_write_char(char c)
@@ -39,16 +51,66 @@ void serial_write_string(const char* str)
     }
 }
 
+// 取走接收寄存器中的所有数据，缓冲区满时丢弃（调用者持有 serial_lock）
+static void serial_buffer_fill(void)
+{
+    while (serial_inb(SERIAL_COM1_BASE + 5) & SERIAL_DATA_READY) {
+        char c = serial_inb(SERIAL_COM1_BASE);
+        if (serial_tail - serial_head < SERIAL_BUFFER_SIZE) {
+            serial_buffer[serial_tail % SERIAL_BUFFER_SIZE] = c;
+            serial_tail++;
+        }
+    }
+}
+
+// 串口接收中断：数据放入缓冲区并唤醒一个读者
+void serial_irq(void)
+{
+    if (serial_can_read()) {
+        wake_up(&serial_wait_queue);
+    }
+}
+
 bool serial_can_read(void)
 {
-    return serial_inb(SERIAL_COM1_BASE + 5) & SERIAL_DATA_READY;
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    serial_buffer_fill();
+    bool ready = serial_tail != serial_head;
+    spin_unlock_irqrestore(&serial_lock, flags);
+    return ready;
 }
 
-char serial_read_char(void)
+// 取出一个字符，缓冲区为空时返回 false
+static bool serial_buffer_pop(char* c)
 {
-    while (!serial_can_read()) {
+    uint32_t flags = spin_lock_irqsave(&serial_lock);
+    
+    serial_buffer_fill();
+    bool ready = serial_tail != serial_head;
+    if (ready) {
+        *c = serial_buffer[serial_head % SERIAL_BUFFER_SIZE];
+        serial_head++;
     }
-    return serial_inb(SERIAL_COM1_BASE);
+    
+    spin_unlock_irqrestore(&serial_lock, flags);
+    return ready;
+}
+
+// 阻塞直到收到数据或超时，返回是否有数据可读
+bool serial_wait(uint32_t timeout_ticks)
+{
+    return wait_event_timeout(serial_wait_queue, serial_can_read(), timeout_ticks) != 0;
+}
+
+// 阻塞直到收到一个字符
+char serial_read_char(void)
+{
+    char c = 0;
+    
+    // 检查和取出在同一次加锁中完成，其他处理器上的读者先取走时继续等待
+    wait_event_exclusive(serial_wait_queue, serial_buffer_pop(&c));
+    
+    return c;
 }
 
 bool serial_received(void)
@@ -5,7 +5,15 @@
 #include <common.h>
 #include <serial.h>
 #include <proc/task.h>
+#include <proc/sched.h>
 #include <mm/paging.h>
+#include <mm/buddy.h>
+#include <mm/zeropool.h>
+#include <mm/slab.h>
+#include <mm/vmalloc.h>
+#include <mm/kheapprof.h>
+#include <mm/scratch.h>
+#include <bench.h>
 
 static char shell_buffer[SHELL_BUFFER_SIZE];
 static int shell_buffer_pos = 0;
@@ -18,7 +26,11 @@ static shell_command_t shell_commands[] = {
     {"ai", shell_cmd_ai, "Ask AI a question (via serial port)"},
     {"ps", shell_cmd_ps, "Show process list"},
     {"free", shell_cmd_free, "Show memory usage"},
+    {"slabinfo", shell_cmd_slabinfo, "Show slab cache statistics"},
+    {"kheapprof", shell_cmd_kheapprof, "Show kernel heap profile (kheapprof reset to clear)"},
     {"top", shell_cmd_top, "Show running processes"},
+    {"setsched", shell_cmd_setsched, "Set scheduling policy: setsched <pid> prio|fair [nice]"},
+    {"bench", shell_cmd_bench, "Run a kernel microbenchmark"},
     {NULL, NULL, NULL}
 };
 
@@ -125,36 +137,22 @@ void shell_cmd_ai(int argc, char** argv)
     
     kprint("Waiting for AI response...\n");
     
-    int timeout = 0;
-    const int max_timeout = 100000;
-    
-    while (timeout < max_timeout) {
-        if (serial_received()) {
-            kprint("\nAI Response:\n");
+    // 阻塞等待回复（串口接收中断唤醒），不再空转
+    if (serial_wait(AI_RESPONSE_TIMEOUT)) {
+        kprint("\nAI Response:\n");
+        
+        while (serial_wait(AI_CHAR_TIMEOUT)) {
+            char c = serial_read_char();
             
-            char c;
-            while (1) {
-                if (serial_can_read()) {
-                    c = serial_read_char();
-                    
-                    if (c == '\n' || c == '\r') {
-                        kprint("\n");
-                        break;
-                    }
-                    
-                    vga_putc(c);
-                } else {
-                    timeout++;
-                    if (timeout >= max_timeout) {
-                        kprint("\n");
-                        break;
-                    }
-                }
+            if (c == '\n' || c == '\r') {
+                break;
             }
             
-            return;
+            vga_putc(c);
         }
-        timeout++;
+        kprint("\n");
+        
+        return;
     }
     
     kprint("Timeout: No response from AI.\n");
@@ -228,6 +226,73 @@ void shell_cmd_free(int argc, char** argv)
               kheap_total / 1024, kheap_used / 1024, kheap_free / 1024);
     kprint(buf);
     
+    // 内核堆碎片统计
+    kheap_stats_t heap_stats;
+    get_kheap_stats(&heap_stats);
+    snprintf(buf, sizeof(buf), "Free blocks: %d\nLargest free: %d KB\nFragmentation: %d%%\n",
+             heap_stats.free_blocks, heap_stats.largest_free / 1024, heap_stats.fragmentation);
+    kprint(buf);
+    snprintf(buf, sizeof(buf), "Peak size: %d KB\nPeak used: %d KB\nGrows: %d\nTrims: %d\n",
+             heap_stats.peak_size / 1024, heap_stats.peak_used / 1024,
+             heap_stats.grow_count, heap_stats.trim_count);
+    kprint(buf);
+    
+    // 内核虚拟区域统计
+    vmalloc_stats_t vm_stats;
+    vmalloc_get_stats(&vm_stats);
+    snprintf(buf, sizeof(buf), "Vmalloc:\nAreas: %d\nPages: %d\nLargest gap: %d KB\n",
+             vm_stats.areas, vm_stats.pages, vm_stats.largest_gap / 1024);
+    kprint(buf);
+    
+    // 伙伴分配器每阶空闲块统计
+    kprint("Buddy Allocator:\n");
+    buddy_dump();
+    
+    // 预清零帧池统计
+    const zero_pool_stats_t* normal = zero_pool_get_stats(BUDDY_ZONE_NORMAL);
+    const zero_pool_stats_t* high = zero_pool_get_stats(BUDDY_ZONE_HIGH);
+    snprintf(buf, sizeof(buf), "Zero Pool (%s):\nPooled: %d + %d\nHits: %d\nMisses: %d\n",
+             zero_pool_enabled() ? "on" : "off", normal->pooled, high->pooled,
+             normal->hits + high->hits, normal->misses + high->misses);
+    kprint(buf);
+    
+    kprint("\n");
+}
+
+// 显示slab缓存统计
+void shell_cmd_slabinfo(int argc, char** argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+    
+    char* buf = (char*)scratch_alloc(1024);
+    if (!buf) {
+        return;
+    }
+    kmem_cache_info(buf, 1024);
+    
+    kprint("\n");
+    kprint(buf);
+    kprint("\n");
+}
+
+// 显示内核堆分析结果
+void shell_cmd_kheapprof(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        kheap_prof_reset();
+        kprint("Kernel heap profile cleared\n");
+        return;
+    }
+    
+    char* buf = (char*)scratch_alloc(4096);
+    if (!buf) {
+        return;
+    }
+    kheap_prof_info(buf, 4096);
+    
+    kprint("\n");
+    kprint(buf);
     kprint("\n");
 }
 
@@ -271,6 +336,87 @@ void shell_cmd_top(int argc, char** argv)
     kprint("\n");
 }
 
+// 解析十进制整数（允许负号），格式错误返回 -1
+static int shell_parse_int(const char* str, int* value)
+{
+    int sign = 1;
+    if (*str == '-') {
+        sign = -1;
+        str++;
+    }
+    if (*str == '\0') {
+        return -1;
+    }
+    
+    int result = 0;
+    for (; *str; str++) {
+        if (*str < '0' || *str > '9') {
+            return -1;
+        }
+        result = result * 10 + (*str - '0');
+    }
+    *value = result * sign;
+    return 0;
+}
+
+// 设置进程的调度策略和 nice 值
+void shell_cmd_setsched(int argc, char** argv)
+{
+    if (argc < 3) {
+        kprint("\nUsage: setsched <pid> prio|fair [nice]\n");
+        return;
+    }
+    
+    int pid;
+    int nice = 0;
+    uint32_t policy;
+    if (strcmp(argv[2], "prio") == 0) {
+        policy = SCHED_PRIO;
+    } else if (strcmp(argv[2], "fair") == 0) {
+        policy = SCHED_FAIR;
+    } else {
+        kprint("\nUnknown policy: ");
+        kprint(argv[2]);
+        kprint("\n");
+        return;
+    }
+    if (shell_parse_int(argv[1], &pid) < 0 || (argc > 3 && shell_parse_int(argv[3], &nice) < 0)) {
+        kprint("\nInvalid number\n");
+        return;
+    }
+    
+    task_t* task = find_task(pid);
+    if (!task) {
+        kprintf("\nProcess %d not found\n", pid);
+        return;
+    }
+    int ret = sched_setscheduler(task, policy, nice);
+    task_put(task);
+    if (ret < 0) {
+        kprintf("\nCannot set policy of process %d (nice must be %d..%d)\n", pid, NICE_MIN, NICE_MAX);
+        return;
+    }
+    kprintf("\nProcess %d: policy %s, nice %d\n", pid, sched_policy_name(policy), nice);
+}
+
+// 运行内核微基准测试
+void shell_cmd_bench(int argc, char** argv)
+{
+    if (argc < 2) {
+        kprint("\nUsage: bench <name>\n");
+        kprint("Available benchmarks:\n");
+        bench_run(NULL);
+        return;
+    }
+    
+    kprint("\n");
+    if (bench_run(argv[1]) < 0) {
+        kprint("Unknown benchmark: ");
+        kprint(argv[1]);
+        kprint("\n");
+    }
+}
+
 void shell_run(void)
 {
     char* argv[SHELL_MAX_ARGS];
@@ -323,6 +469,9 @@ void shell_run(void)
                 }
             }
             
+            // 命令在临时区中分配的内存在命令结束时一并释放
+            scratch_reset();
+            
             if (!found) {
                 // 尝试作为可执行文件执行
                 kprint("Executing: ");
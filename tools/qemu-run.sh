@@ -23,8 +23,11 @@ if [ ! -f ${KERNEL_BIN} ]; then
     exit 1
 fi
 
+# 处理器数（可通过环境变量 SMP 指定）
+SMP=${SMP:-4}
+
 # 运行QEMU
-${QEMU} -kernel ${KERNEL_BIN} -m 128M -monitor stdio -serial COM1
+${QEMU} -kernel ${KERNEL_BIN} -m 128M -smp ${SMP} -monitor stdio -serial COM1
 
 # 可选：如果需要更详细的调试输出，可以使用以下命令
-# ${QEMU} -kernel ${KERNEL_BIN} -m 128M -monitor stdio -serial COM1 -d int -no-reboot
+# ${QEMU} -kernel ${KERNEL_BIN} -m 128M -smp ${SMP} -monitor stdio -serial COM1 -d int -no-reboot